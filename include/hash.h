@@ -4,9 +4,34 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#define HASH_SIZE 32  // Optimal output size for SHAKE256 2^32 =256 bits
+#define HASH_SIZE 32  // Maximum (and default) hash output length n; params->n selects 16, 24 or 32 bytes
 
-// SHAKE256 hash function
-void hash_shake256(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen);
+// SHAKE256 hash function; 0, or -1 with out zeroed if OpenSSL fails
+int hash_shake256(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen);
+
+// Free the calling thread's cached SHAKE256 and SHA-256 contexts
+void hash_release_thread_state(void);
+
+// Hash backends, recorded in key and signature headers
+#define HASH_BACKEND_SHAKE256  0  // SHAKE256 via OpenSSL EVP
+#define HASH_BACKEND_POSEIDON2 1  // Poseidon2 over Goldilocks (see poseidon2.h), cheap inside SNARK circuits
+#define HASH_BACKEND_SHA256    2  // SHA-256 with SHA-NI or OpenSSL (see sha256.h), fast on hosts with SHA extensions
+
+// One hash family. A key uses its backend for every chain, tree node, PRF output and message digest.
+// hash() returns 0, or -1 with out zeroed if the hash failed.
+typedef struct hash_backend {
+    int id;
+    const char *name;
+    int (*hash)(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen);
+} hash_backend;
+
+// Backend by id, or NULL
+const hash_backend *hash_backend_get(int id);
+
+// Backend id by name ("shake256", "poseidon2", "sha256"), or -1
+int hash_backend_from_name(const char *name);
+
+// Implementation the backend dispatched to on this CPU (e.g. "sha-ni" or "openssl")
+const char *hash_backend_implementation(const hash_backend *backend);
 
 #endif
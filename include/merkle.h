@@ -3,17 +3,53 @@
 
 #include <stdint.h>
 #include "hash.h"
+#include "xmss_config.h"
 
-// This header file defines functions for working with Merkle Trees.
-void merkle_compute_root(const uint8_t leaves[][HASH_SIZE], int num_leaves, uint8_t root[HASH_SIZE]);
-
-// Compute the authentication path for a given leaf in a Merkle Tree.
-void merkle_auth_path(const uint8_t leaves[][HASH_SIZE], int num_leaves, int leaf_index,
-                      uint8_t auth_path[][HASH_SIZE], uint8_t root_out[HASH_SIZE]);
-                      
-// Compute the root hash from a leaf and its authentication path.
-void merkle_root_from_path(const uint8_t leaf[HASH_SIZE], int leaf_index,
-                           const uint8_t auth_path[][HASH_SIZE], int height,
-                           uint8_t root_out[HASH_SIZE]);
+// This header file defines functions for working with Merkle Trees. Leaves, auth paths and roots
+// are flat arrays of params->n byte nodes, and every parent is thash_node() of its children, as in
+// the XMSS tree (pub_seed is only used in tweaked mode). Any leaf count works: a level with an odd
+// number of nodes carries its last node up unchanged, so a power-of-two tree is the XMSS tree and
+// no other leaf set (such as one with the last leaf repeated) gives the same root.
+
+// Height of the tree over num_leaves leaves (ceil(log2(num_leaves)))
+int merkle_height(uint64_t num_leaves);
+
+// Scratch space needed by merkle_compute_root()/merkle_auth_path() (about 0.75 * num_leaves nodes).
+// Callers may pass such a buffer as work (e.g. from an arena) or NULL to have it allocated.
+size_t merkle_workspace_bytes(const xmss_params *params, uint64_t num_leaves);
+
+// Compute the root level by level. Levels of 4096 or more pairs are split across the worker pool
+// (xmss_parallel.h). Returns 0 on success, -1 if there are no leaves, the workspace cannot be
+// allocated or a hash failed.
+int merkle_compute_root(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaves,
+                        uint64_t num_leaves, uint8_t *work, uint8_t *root);
+
+// Compute the authentication path (merkle_height(num_leaves) nodes) of a leaf and the root. Heights
+// at which the leaf's ancestor is carried up get a zero entry.
+int merkle_auth_path(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaves, uint64_t num_leaves,
+                     uint64_t leaf_index, uint8_t *work, uint8_t *auth_path, uint8_t *root_out);
+
+// Compute the root from a leaf and its authentication path in a tree of num_leaves leaves
+// (0, or -1 if the index is out of range or a hash failed)
+int merkle_root_from_path(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaf,
+                          uint64_t leaf_index, uint64_t num_leaves, const uint8_t *auth_path, uint8_t *root_out);
+
+// Multi-proofs for a set of leaves: only the siblings that cannot be derived from the other
+// leaves, ordered by height and then index. Leaf indices must be strictly increasing. Nodes are
+// hashed as above, so proofs for XMSS leaves rebuild the XMSS root in either mode.
+
+// Number of proof nodes for the given leaves of a tree of this height (-1 if the indices are invalid)
+int merkle_multiproof_size(int height, const uint64_t *indices, int count);
+
+// Extract a multi-proof from the leaves' individual auth paths (auth_paths[k][t] is the sibling
+// of leaf k at height t, e.g. XMSSSignature.auth_path). proof receives the nodes; returns their count.
+int merkle_multiproof_from_paths(const xmss_params *params, int height, const uint64_t *indices, int count,
+                                 uint8_t *const *const *auth_paths, uint8_t *proof);
+
+// Rebuild the root from the leaves (count nodes) and a multi-proof, hashing every node once.
+// Returns 0 on success, -1 if the indices are invalid, the proof has the wrong size or a hash failed.
+int merkle_multiproof_root(const xmss_params *params, const uint8_t *pub_seed, int height,
+                           const uint64_t *indices, const uint8_t *leaves, int count,
+                           const uint8_t *proof, int proof_nodes, uint8_t *root_out);
 
 #endif
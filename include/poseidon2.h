@@ -0,0 +1,35 @@
+#ifndef POSEIDON2_H
+#define POSEIDON2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Poseidon2 over the Goldilocks field p = 2^64 - 2^32 + 1: width 12, x^7 S-box,
+// 8 full and 22 partial rounds. Round constants are drawn from
+// SHAKE256("QuantumShield Poseidon2 Goldilocks t=12") by rejection sampling. The internal diagonal
+// is drawn from the same string with " diag" and a counter byte appended, using the first counter
+// whose internal matrix is invertible with no invariant subspace (tests/kat_test.c pins the result).
+#define POSEIDON2_P      0xFFFFFFFF00000001ULL
+#define POSEIDON2_WIDTH  12
+#define POSEIDON2_RATE   8
+#define POSEIDON2_ROUNDS_F 8
+#define POSEIDON2_ROUNDS_P 22
+
+// Bytes packed into one input element (7 bytes stay below p)
+#define POSEIDON2_CHUNK_BYTES 7
+
+// Apply the permutation to a state of canonical field elements
+void poseidon2_permute(uint64_t state[POSEIDON2_WIDTH]);
+
+// Sponge hash over canonical elements: rate 8, the capacity is seeded with the input and output
+// counts and an element-mode marker, and outcount rate elements are squeezed
+int poseidon2_hash_elements(const uint64_t *in, size_t count, uint64_t *out, size_t outcount);
+
+// Sponge hash over bytes. An input of whole little-endian 8-byte words that are all canonical
+// (n-byte chain values, tree nodes and earlier outputs: n/8 elements) goes through
+// poseidon2_hash_elements() unchanged, so a squeezed output feeds the next absorb directly. Other
+// inputs are packed 7 bytes per element under a different capacity marker. Output elements are
+// written as 8 little-endian bytes each.
+int poseidon2_hash(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen);
+
+#endif
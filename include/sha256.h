@@ -0,0 +1,21 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_BYTES 32
+
+// SHA-256 with a variable output length. Up to 32 bytes this is SHA-256(in) truncated; longer
+// outputs concatenate SHA-256(in || counter) for big-endian 32-bit counters 0, 1, ...
+// The first call picks the implementation: SHA-NI instructions when the CPU has them, OpenSSL otherwise.
+// Returns 0, or -1 with out zeroed if OpenSSL fails.
+int sha256_hash(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen);
+
+// Free the calling thread's cached OpenSSL context (see hash_release_thread_state())
+void sha256_release_thread_state(void);
+
+// Name of the selected implementation ("sha-ni" or "openssl")
+const char *sha256_implementation(void);
+
+#endif
@@ -1,9 +1,76 @@
 #ifndef SNARK_EXPORT_H
 #define SNARK_EXPORT_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include "xmss.h"
+#include "xmss_aggregate.h"
+#include "xmss_config.h"
+
+// Output buffer of the streaming exporter
+#define SNARK_STREAM_BUFFER (1 << 16)
+
+// One signature of a witness bundle
+typedef struct {
+    const uint8_t *msg;
+    size_t msg_len;
+    const XMSSSignature *sig;
+    const uint8_t *root;
+    const uint8_t *pub_seed;  // Written in tweaked mode only
+    int64_t signer;           // Registry position, or -1 to omit
+} snark_witness;
 
 // Export SNARK data to JSON format
-int export_snark_json(const char *filename, const uint8_t *msg, size_t msg_len, int h, int w);
+int export_snark_json(const char *filename, const uint8_t *msg, size_t msg_len, const xmss_params *params);
+
+// Stream a bundle as NDJSON without building a JSON tree: one line with the parameters, then one
+// line per signature with all wots_len chains and the h auth-path nodes. Returns 0, or -1 on a write error.
+int export_snark_ndjson_fd(int fd, const xmss_params *params, const snark_witness *items, size_t count);
+int export_snark_ndjson(const char *filename, const xmss_params *params, const snark_witness *items, size_t count);
+
+// Stream every signature of an aggregate, with its signer's registry key
+int export_snark_aggregate_ndjson(const char *filename, const xmss_params *params, const uint8_t *msg, size_t msg_len,
+                                  const xmss_aggregate *agg, const xmss_key_registry *registry);
+
+// Binary witness fields: byte strings are split into chunks that fit below the modulus, and each
+// chunk is stored zero-extended as one little-endian element
+#define SNARK_FIELD_RAW        0  // Plain bytes (1-byte chunks and elements)
+#define SNARK_FIELD_BN254      1  // BN254 scalar field: 31-byte chunks in 32-byte elements
+#define SNARK_FIELD_GOLDILOCKS 2  // 2^64 - 2^32 + 1: 7-byte chunks in 8-byte elements
+#define SNARK_FIELD_BABYBEAR   3  // 15 * 2^27 + 1: 3-byte chunks in 4-byte elements
+
+#define SNARK_BIN_MAGIC   "XWIT"
+#define SNARK_BIN_VERSION 1
+#define SNARK_BIN_HEADER  128
+
+// Binary witness layout. The file is a SNARK_BIN_HEADER byte header followed by count fixed-size
+// records; every integer is little-endian and every record starts 8-byte aligned, so provers can mmap it.
+// Header: magic, then the fields below in order (u32, with count and record_bytes as u64), zero padding.
+// Record (offsets in the header): u64 leaf index, packed message digest, packed nonce (zero unless
+// target-sum), packed root, packed public seed (zero in plain mode), wots_len u32 base-w digits,
+// wots_len u32 remaining chain steps (w - 1 - digit), wots_len packed chain values, h u32 auth-path
+// bits (leaf index bit t: 1 if the sibling is on the left) and h packed siblings.
+typedef struct {
+    uint32_t version;
+    uint32_t h, w, n, wots_len, encoding, target_sum, hash_mode;
+    uint32_t field, chunk_bytes, elem_bytes;
+    uint32_t digest_bytes, nonce_bytes;   // Packed sizes of an n-byte value and of the nonce
+    uint32_t off_index, off_digest, off_nonce, off_root, off_pub_seed;
+    uint32_t off_digits, off_steps, off_chains, off_path_bits, off_siblings;
+    uint64_t count;
+    uint64_t record_bytes;
+    uint32_t hash_backend;                // HASH_BACKEND_* of the chains and tree
+} snark_bin_header;
+
+// Field name ("raw", "bn254", "goldilocks", "babybear") to id, or -1
+int snark_field_from_name(const char *name);
+
+// Header of a binary witness with count records (-1 for an unknown field)
+int snark_bin_layout(const xmss_params *params, int field, uint64_t count, snark_bin_header *header);
+
+// Write a bundle as a binary witness. Returns 0, or -1 on a write error or an invalid signature encoding.
+int export_snark_bin_fd(int fd, const xmss_params *params, int field, const snark_witness *items, size_t count);
+int export_snark_bin(const char *filename, const xmss_params *params, int field, const snark_witness *items,
+                     size_t count);
 
 #endif
@@ -0,0 +1,56 @@
+#ifndef THASH_H
+#define THASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hash.h"
+#include "xmss_config.h"
+
+// RFC 8391 address types
+#define XMSS_ADDR_TYPE_OTS      0
+#define XMSS_ADDR_TYPE_LTREE    1
+#define XMSS_ADDR_TYPE_HASHTREE 2
+
+#define XMSS_ADDR_BYTES 32
+#define XMSS_PUB_SEED_BYTES 32
+
+// RFC 8391 hash address (ADRS): eight 32-bit words, serialized big-endian
+typedef struct {
+    uint32_t word[8];
+} xmss_adrs;
+
+// Address setters (word layout follows RFC 8391, section 2.5)
+void adrs_init(xmss_adrs *adrs);
+void adrs_set_type(xmss_adrs *adrs, uint32_t type);
+void adrs_set_ots(xmss_adrs *adrs, uint32_t ots);
+void adrs_set_chain(xmss_adrs *adrs, uint32_t chain);
+void adrs_set_hash(xmss_adrs *adrs, uint32_t hash);
+void adrs_set_ltree(xmss_adrs *adrs, uint32_t ltree);
+void adrs_set_tree_height(xmss_adrs *adrs, uint32_t height);
+void adrs_set_tree_index(xmss_adrs *adrs, uint32_t index);
+void adrs_set_key_and_mask(xmss_adrs *adrs, uint32_t key_and_mask);
+void adrs_to_bytes(const xmss_adrs *adrs, uint8_t out[XMSS_ADDR_BYTES]);
+
+// Tweakable hash with an n-byte output. In XMSS_HASH_TWEAKED mode this is RFC 8391 with the key's
+// backend as the hash: F for one n-byte block, RAND_HASH for two and the L-tree for an L-tree
+// address, each keyed and masked with PRF(pub_seed[0..n), ADRS) outputs. In XMSS_HASH_PLAIN mode
+// pub_seed and adrs are ignored and this is H(in). Returns 0, or -1 with out zeroed if the hash failed.
+int thash(const xmss_params *params, const uint8_t *pub_seed, const xmss_adrs *adrs,
+          const uint8_t *in, size_t inlen, uint8_t *out);
+
+// Untweaked hash with the key's backend (message digests and PRFs); 0, or -1 with out zeroed
+int xmss_hash(const xmss_params *params, const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen);
+
+// RFC 8391 PRF(SEED, ADRS) = H(toByte(3, pad) || SEED || ADRS) with an n-byte seed, where pad = n
+// (4 for n = 24, as in NIST SP 800-208). On SHAKE256 the prefix and seed are absorbed once per
+// thread and the Keccak state is cloned per call. Returns 0, or -1 with out zeroed on failure.
+int thash_prf(const xmss_params *params, const uint8_t *pub_seed, const xmss_adrs *adrs, uint8_t *out);
+
+// Free the calling thread's cached seed and SHAKE256 state (call before a worker thread exits)
+void thash_release_thread_state(void);
+
+// Hash two n-byte child nodes into their parent at the given height/index of the tree (0 or -1, as thash)
+int thash_node(const xmss_params *params, const uint8_t *pub_seed, int height, uint64_t index,
+               const uint8_t *left, const uint8_t *right, uint8_t *out);
+
+#endif
@@ -2,12 +2,27 @@
 #define UTIL_H
 
 #include <stddef.h>
+#include <stdio.h>
 #include <stdint.h>
 
-// Securely zeroes memory to prevent sensitive data leakage.
+// Securely zeroes memory to prevent sensitive data leakage (memset width, never optimized away).
 void secure_zero_memory(void *ptr, size_t len);
 
-// Conditionally selects bytes from two arrays based on a mask in constant time.
+// Conditionally selects bytes from two arrays based on a mask in constant time: dst = mask ? a : b.
+// mask must be 0 or all ones. Works 16 bytes (SSE2/NEON) or 8 bytes at a time; dst may alias a or b.
 void conditional_select(uint8_t *dst, const uint8_t *a, const uint8_t *b, uint32_t mask, size_t len);
 
+// 1 if the buffers are equal, else 0, in time that depends only on len.
+int constant_time_equal(const void *a, const void *b, size_t len);
+
+// Atomically replace the file dst with src (write to a temporary file first, then call this).
+// On POSIX the directory is synced afterwards, so the rename survives a crash.
+int replace_file(const char *src, const char *dst);
+
+// Flush a file opened for writing through to the disk (before fclose() and replace_file()).
+int fsync_file(FILE *f);
+
+// Open a file for writing with owner-only permissions (0600), for files holding secrets.
+FILE *fopen_private(const char *path);
+
 #endif
\ No newline at end of file
@@ -3,7 +3,9 @@
 
 #include <stdint.h>
 #include "hash.h"
+#include "thash.h"
 #include "xmss_config.h"
+#include "xmss_arena.h"
 
 // WOTS Key structure
 typedef struct {
@@ -11,21 +13,50 @@ typedef struct {
     uint8_t **pk;
 } WOTSKey;
 
+// Randomizer length for the target-sum encoding
+#define WOTS_NONCE_BYTES 16
+
 // WOTS signature structure
 typedef struct {
     uint8_t **sig;
+    uint8_t nonce[WOTS_NONCE_BYTES]; // Target-sum encoding only
 } WOTSSignature;
 
-// WOTS Key and signiture memory management
+// WOTS Key and signiture memory management. Each chain set is one block (row pointers followed
+// by the rows, so sk[0] and pk[0] address all rows); the _arena variants take the public parts
+// from a scratch arena when one is given. sk always comes from the locked secure heap (xmss_secmem.h).
 int wots_alloc_key(WOTSKey *key, const xmss_params *params);
 void wots_free_key(WOTSKey *key, const xmss_params *params);
 int wots_alloc_sig(WOTSSignature *sig, const xmss_params *params);
 void wots_free_sig(WOTSSignature *sig, const xmss_params *params);
+int wots_alloc_key_arena(WOTSKey *key, const xmss_params *params, xmss_arena *arena);
+void wots_free_key_arena(WOTSKey *key, const xmss_params *params, xmss_arena *arena);
+int wots_alloc_sig_arena(WOTSSignature *sig, const xmss_params *params, xmss_arena *arena);
+void wots_free_sig_arena(WOTSSignature *sig, const xmss_params *params, xmss_arena *arena);
+
+// WOTS operations. pub_seed and ots_adrs (type OTS, OTS index set) are only used in
+// XMSS_HASH_TWEAKED mode; plain mode callers may pass NULL for both. wots_sign() returns 0, or -1
+// (and signs nothing) if the message digest failed.
+void wots_compute_pk(const xmss_params *params, WOTSKey *key, const uint8_t *pub_seed, const xmss_adrs *ots_adrs);
+int  wots_sign(const xmss_params *params, const uint8_t *msg, size_t msg_len, WOTSKey *key, WOTSSignature *sig,
+               const uint8_t *pub_seed, const xmss_adrs *ots_adrs);
+int  wots_verify(const xmss_params *params, const uint8_t *msg, const WOTSSignature *sig, WOTSKey *pk,
+                 const uint8_t *pub_seed, const xmss_adrs *ots_adrs);
+
+// wots_verify() in two steps, so signatures of one message can share the encoding: the base-w
+// digits of msg (wots_len bytes, -1 if invalid), then the public key recovered from them.
+// Without the target-sum encoding the digits do not depend on sig.
+int  wots_verify_digits(const xmss_params *params, const uint8_t *msg, const WOTSSignature *sig, uint8_t *digits);
+void wots_pk_from_digits(const xmss_params *params, const uint8_t *digits, const WOTSSignature *sig, WOTSKey *pk,
+                         const uint8_t *pub_seed, const xmss_adrs *ots_adrs);
 
-// WOTS operations
-void wots_compute_pk(const xmss_params *params, WOTSKey *key);
-void wots_sign(const xmss_params *params, const uint8_t *msg, size_t msg_len, WOTSKey *key, WOTSSignature *sig);
-void wots_verify(const xmss_params *params, const uint8_t *msg, const WOTSSignature *sig, WOTSKey *pk);
+// Offline/online signing. wots_precompute_chains() stores all w values of every chain
+// (wots_len * w * n bytes, secret); wots_sign_precomputed() then only encodes the message
+// and selects one value per chain in constant time.
+void wots_precompute_chains(const xmss_params *params, const WOTSKey *key, uint8_t *table,
+                            const uint8_t *pub_seed, const xmss_adrs *ots_adrs);
+int  wots_sign_precomputed(const xmss_params *params, const uint8_t *msg, size_t msg_len, const uint8_t *table,
+                           WOTSSignature *sig);
 
 // Vulnerable function, for testing purposes only.
 void wots_sign_vulnerable(const xmss_params *params, const uint8_t *msg, size_t msg_len, WOTSKey *key, WOTSSignature *sig);
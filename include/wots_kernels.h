@@ -0,0 +1,28 @@
+#ifndef WOTS_KERNELS_H
+#define WOTS_KERNELS_H
+
+#include <stdint.h>
+#include "thash.h"
+#include "xmss_config.h"
+
+// Upper bound on wots_len (w=2, n=32: 256 message digits + 9 checksum digits)
+#define WOTS_LEN_MAX 265
+
+// Hot WOTS+ loops for one (w, n) pair. xmss_params_init() points params->kernels at a fully
+// specialized table when one exists and at the generic (runtime w, n) table otherwise.
+struct wots_kernels {
+    int w;  // 0 for the generic table
+    int n;
+
+    // Constant-time chain from the secret value: always hashes w-1 times, keeps the first 'steps'
+    void (*chain_ct)(const xmss_params *params, const uint8_t *pub_seed, xmss_adrs *adrs,
+                     uint8_t *out, const uint8_t *in, int steps);
+
+    // Base-w digits of an n-byte message hash followed by the checksum digits (wots_len1 + wots_len2 outputs)
+    void (*base_w_checksum)(const xmss_params *params, const uint8_t *input, uint8_t *output);
+};
+
+// Pick the kernel table for the given parameters (never NULL)
+const wots_kernels *wots_kernels_select(const xmss_params *params);
+
+#endif
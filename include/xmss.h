@@ -4,48 +4,107 @@
 #include <stdint.h>
 #include "wots.h"
 #include "hash.h"
+#include "thash.h"
 #include "xmss_config.h"
 
 // Filenames
 #define XMSS_STATE_FILE "xmss_state.dat"
 #define XMSS_KEY_FILE   "xmss_key.bin"
 
+// Key file header: magic, then a uint32 version, then the parameter words
+#define XMSS_KEY_MAGIC   "XKEY"
+#define XMSS_KEY_VERSION 1
+
 #define XMSS_SEED_BYTES 32
 
 // XMSS Key structure
 typedef struct {
     uint8_t  seed[XMSS_SEED_BYTES];
-    uint8_t  root[HASH_SIZE];
+    uint8_t  pub_seed[XMSS_PUB_SEED_BYTES]; // Public; only used in XMSS_HASH_TWEAKED mode
+    uint8_t  root[HASH_SIZE];               // First n bytes are used
 } XMSSKey;
 
 // XMSS Signature structure
 typedef struct {
     int index;
     WOTSSignature *wots_sig;
-    uint8_t **auth_path; // [h][HASH_SIZE]
+    uint8_t **auth_path; // [h][n]
 } XMSSSignature;
 
-// Memory management
+// Memory management (the _arena variants take the signature from a scratch arena when one is given)
 int xmss_alloc_sig(XMSSSignature *sig, const xmss_params *params);
 void xmss_free_sig(XMSSSignature *sig, const xmss_params *params);
+int xmss_alloc_sig_arena(XMSSSignature *sig, const xmss_params *params, xmss_arena *arena);
+void xmss_free_sig_arena(XMSSSignature *sig, const xmss_params *params, xmss_arena *arena);
+
+// A zeroed key in locked secure memory (xmss_secmem.h), for keys held for a whole run;
+// xmss_key_free() wipes it
+XMSSKey *xmss_key_alloc(void);
+void xmss_key_free(XMSSKey *key);
 
-// Key lifecycle
+// Key lifecycle. xmss_keygen() = xmss_keygen_seeds() (draws randomness) + xmss_keygen_root() (hashing only).
 void xmss_keygen(const xmss_params *params, XMSSKey *key);
+void xmss_keygen_seeds(const xmss_params *params, XMSSKey *key);
+void xmss_keygen_root(const xmss_params *params, XMSSKey *key);
 int  xmss_save_key(const XMSSKey *key, const xmss_params *params);
 int  xmss_load_key(XMSSKey *key, xmss_params *params);
+int  xmss_save_key_file(const char *path, const XMSSKey *key, const xmss_params *params);
+// Loads return 1 on success, 0 if the file is missing and -1 if it is unreadable or not a key file.
+// A headerless file from the original format (int h, int w, seed, root) is migrated on load.
+int  xmss_load_key_file(const char *path, XMSSKey *key, xmss_params *params);
+
+// Precomputed leaves for offline/online signing (see xmss_precomp.h)
+typedef struct xmss_precomp_pool xmss_precomp_pool;
 
-// Signing
-void xmss_sign_auto(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig);
-void xmss_sign_index(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig, int idx);
+// Signing; 0 on success, -1 on failure. pool may be NULL. xmss_sign_auto() and xmss_sign_epoch()
+// read and advance the default state file and draw from the CSPRNG: a program that signs on more
+// than one thread (including through xmss_async.h) must hold xmss_sign_lock() around each call.
+int  xmss_sign_auto(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig,
+                    xmss_precomp_pool *pool);
+int  xmss_sign_index(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig, int idx);
+int  xmss_sign_epoch(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig, uint64_t epoch);
+
+// Sign a precomputed message digest (xmss_hash() of the message, n bytes) at a leaf, so one digest
+// can be shared by many keys with the same hash backend and n. The caller manages the state.
+int  xmss_sign_digest(const xmss_params *params, const uint8_t *msg_hash, XMSSKey *key, XMSSSignature *sig, int idx);
 
 // Verify
-int  xmss_verify(const xmss_params *params, const uint8_t *msg, XMSSSignature *sig, const uint8_t *root);
+int  xmss_verify(const xmss_params *params, const uint8_t *msg, XMSSSignature *sig, const uint8_t *root,
+                 const uint8_t *pub_seed);
+
+// Verify count signatures under the same parameters (pub_seeds may be NULL in plain mode).
+// results[i] is 1 if signature i is valid; returns the number of valid signatures.
+int  xmss_verify_batch(const xmss_params *params, int count, const uint8_t *const *msgs, XMSSSignature *const *sigs,
+                       const uint8_t *const *roots, const uint8_t *const *pub_seeds, int *results);
 
 // State persistence
 int xmss_load_state(int *index);
+int xmss_load_state_file(const char *path, int *index);
 int xmss_save_state(int index);
+int xmss_save_state_file(const char *path, int index);
+
+// Process-wide signing lock (see xmss_sign_auto()); the async queue takes it for every sign job
+void xmss_sign_lock(void);
+void xmss_sign_unlock(void);
+
+// Helper functions to generate the WOTS key of a leaf (secret part only, or secret and public);
+// 0, or -1 if the PRF failed
+int  xmss_derive_wots_sk(const xmss_params *params, const XMSSKey *key, int index, WOTSKey *wots_key);
+int  xmss_generate_wots_key(const xmss_params *params, XMSSKey *key, int index, WOTSKey *wots_key);
+
+// Helpers to compute a tree node recursively, or the pseudorandom filler of a subtree outside the activation window
+void compute_node(const xmss_params *params, uint8_t *node, XMSSKey *key, int height, uint64_t index);
+void compute_inactive_node(const xmss_params *params, uint8_t *node, const XMSSKey *key, int height, uint64_t index);
+
+// Helper to compute the authentication path of a leaf (h rows of n bytes). Nodes held by an
+// attached node cache for this key (see xmss_cache.h) are copied instead of recomputed.
+void xmss_compute_auth_path(const xmss_params *params, XMSSKey *key, uint64_t idx, uint8_t **auth_path);
+
+// Helper to build the OTS hash address of a leaf
+void xmss_ots_adrs(xmss_adrs *adrs, uint64_t index);
 
-// Helper function to generate WOTS key
-void xmss_generate_wots_key(const xmss_params *params, XMSSKey *key, int index, WOTSKey *wots_key);
+// Helper to compress a WOTS public key (wots_len * n bytes, chains in order) into leaf index (0 or -1, as thash)
+int xmss_compress_leaf(const xmss_params *params, const uint8_t *pub_seed, uint64_t index,
+                       const uint8_t *pk_concat, uint8_t *node);
 
 #endif
@@ -0,0 +1,90 @@
+#ifndef XMSS_AGGREGATE_H
+#define XMSS_AGGREGATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xmss.h"
+#include "xmss_config.h"
+
+// Signatures of one message by many keys (e.g. all validators attesting to one slot).
+// signers[i] is the registry position of the key that made sigs[i]; positions are strictly increasing.
+typedef struct {
+    int count;
+    uint32_t *signers;
+    XMSSSignature *sigs;
+} xmss_aggregate;
+
+// Flag bit of a registry position that holds a key
+#define XMSS_KEY_REGISTRY_PRESENT 1u
+
+// Registry of trusted keys: root i at roots + i * stride, public seed i at pub_seeds + i * stride
+// (pub_seeds may be NULL in plain mode). A stride of 0 means packed arrays: n bytes per root and
+// XMSS_PUB_SEED_BYTES per seed. count is the number of positions. Registry files (xmss_registry.h)
+// are viewed in place with their record size; their positions may be empty, so the view also gives
+// each position's flags and parameter words (flags and params are NULL when every position holds a
+// key with the verifier's parameters).
+typedef struct {
+    uint32_t count;
+    const uint8_t *roots;
+    const uint8_t *pub_seeds;
+    const uint32_t *flags;
+    const int32_t *params;     // XMSS_PARAMS_WORDS words per position (xmss_params_encode())
+    size_t stride;
+} xmss_key_registry;
+
+// Root of registry position i
+static inline const uint8_t *xmss_key_registry_root(const xmss_key_registry *registry, const xmss_params *params,
+                                                    uint32_t i) {
+    return registry->roots + (size_t)i * (registry->stride ? registry->stride : (size_t)params->n);
+}
+
+// Public seed of registry position i, or NULL
+static inline const uint8_t *xmss_key_registry_pub_seed(const xmss_key_registry *registry, uint32_t i) {
+    if (!registry->pub_seeds) return NULL;
+    return registry->pub_seeds + (size_t)i * (registry->stride ? registry->stride : XMSS_PUB_SEED_BYTES);
+}
+
+// Whether position i holds a key whose parameter words equal words
+static inline int xmss_key_registry_holds(const xmss_key_registry *registry, const int32_t words[XMSS_PARAMS_WORDS],
+                                          uint32_t i) {
+    if (i >= registry->count) return 0;
+    size_t stride = registry->stride;
+    if (registry->flags && !(*(const uint32_t *)((const uint8_t *)registry->flags + (size_t)i * stride) &
+                             XMSS_KEY_REGISTRY_PRESENT)) {
+        return 0;
+    }
+    if (registry->params) {
+        const int32_t *p = (const int32_t *)((const uint8_t *)registry->params + (size_t)i * stride);
+        for (int k = 0; k < XMSS_PARAMS_WORDS; k++) {
+            if (p[k] != words[k]) return 0;
+        }
+    }
+    return 1;
+}
+
+// Memory management (signatures are allocated for params)
+int  xmss_aggregate_alloc(xmss_aggregate *agg, const xmss_params *params, int count);
+void xmss_aggregate_free(xmss_aggregate *agg, const xmss_params *params);
+
+// Serialized size: u32 count, count u32 signer positions, then count xmss_eth signatures (all little-endian)
+static inline size_t xmss_aggregate_size(const xmss_params *params, int count) {
+    size_t nonce = (params->encoding == WOTS_ENCODING_TARGET_SUM) ? WOTS_NONCE_BYTES : 0;
+    return 4 + (size_t)count * (8 + nonce + ((size_t)params->wots_len + (size_t)params->h) * (size_t)params->n);
+}
+
+// Serialize an aggregate into out (at least xmss_aggregate_size() bytes)
+int  xmss_aggregate_serialize(const xmss_params *params, const xmss_aggregate *agg, uint8_t *out, size_t out_cap,
+                              size_t *out_len);
+
+// Parse an aggregate (allocates agg; free with xmss_aggregate_free()). The length must match exactly.
+int  xmss_aggregate_deserialize(const xmss_params *params, xmss_aggregate *agg, const uint8_t *in, size_t in_len);
+
+// Verify every signature of an aggregate against its signer's registry key. The message is digested
+// and encoded once (once per signature in the target-sum encoding) and the signers are spread over
+// the worker pool. results (optional) receives 1 per valid signature. Returns 1 if the aggregate
+// is valid: all signatures verify and the signers are distinct registry positions in increasing order,
+// each holding a key with params (xmss_key_registry_holds()).
+int  xmss_aggregate_verify(const xmss_params *params, const uint8_t *msg, const xmss_aggregate *agg,
+                           const xmss_key_registry *registry, int *results);
+
+#endif
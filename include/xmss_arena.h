@@ -0,0 +1,50 @@
+#ifndef XMSS_ARENA_H
+#define XMSS_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of each thread's scratch arena. Signing needs a few WOTS+ keys' worth (about 8 KiB at
+// w = 16, n = 32); requests that do not fit fall back to the heap.
+#ifndef XMSS_ARENA_THREAD_BYTES
+#define XMSS_ARENA_THREAD_BYTES (256 * 1024)
+#endif
+
+// Bump allocator for per-operation scratch memory. Allocations are released together by
+// rewinding to a mark; everything ever handed out (up to the high-water mark) is wiped with
+// secure_zero_memory() when the outermost operation ends, so secrets never outlive it.
+typedef struct {
+    uint8_t *base;
+    size_t cap;
+    size_t used;
+    size_t high;   // Bytes handed out since the last wipe
+} xmss_arena;
+
+// Set up / wipe and release an arena of cap bytes
+int  xmss_arena_init(xmss_arena *arena, size_t cap);
+void xmss_arena_free(xmss_arena *arena);
+
+// 16-byte aligned bytes from the arena, or NULL if it is full
+void *xmss_arena_alloc(xmss_arena *arena, size_t bytes);
+
+// Scratch memory from the arena, or from the heap if arena is NULL or full. xmss_arena_put()
+// wipes and frees heap blocks (arena blocks are released with the operation). Heap blocks carry
+// a size header, so they must go back through xmss_arena_put(), never free().
+void *xmss_arena_get(xmss_arena *arena, size_t bytes);
+void  xmss_arena_put(xmss_arena *arena, void *ptr);
+
+// Operations nest: begin returns a mark, end rewinds to it. Ending the outermost operation
+// (mark 0) resets the arena and wipes everything it handed out.
+size_t xmss_arena_begin(const xmss_arena *arena);
+void   xmss_arena_end(xmss_arena *arena, size_t mark);
+
+// Wipe the whole used range and start over
+void xmss_arena_reset(xmss_arena *arena);
+
+// The calling thread's arena (created on first use), or NULL if it could not be allocated
+xmss_arena *xmss_arena_thread(void);
+
+// Wipe and free the calling thread's arena (worker threads call this before exiting)
+void xmss_arena_release_thread(void);
+
+#endif
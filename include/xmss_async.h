@@ -0,0 +1,49 @@
+#ifndef XMSS_ASYNC_H
+#define XMSS_ASYNC_H
+
+#include <stdint.h>
+#include "xmss.h"
+#include "xmss_config.h"
+
+#define XMSS_ASYNC_SIGN   0
+#define XMSS_ASYNC_VERIFY 1
+
+typedef struct xmss_async_job xmss_async_job;
+
+// Completion callback, called on a worker thread once job->result is set
+typedef void (*xmss_async_cb)(xmss_async_job *job);
+
+// One request. The caller owns the job and everything it points to until completion.
+struct xmss_async_job {
+    int op;                       // XMSS_ASYNC_SIGN or XMSS_ASYNC_VERIFY
+    const xmss_params *params;
+    const uint8_t *msg;           // NUL-terminated, as for xmss_sign_auto()/xmss_verify()
+    XMSSSignature *sig;           // Filled by sign, read by verify
+    XMSSKey *key;                 // Sign only
+    const uint8_t *root;          // Verify only
+    const uint8_t *pub_seed;      // Verify only
+
+    // Notification: the callback (may be NULL), then an 8-byte write of 1 to notify_fd
+    // (an eventfd or the write end of a pipe; -1 for none). The callback may free the job;
+    // the fd is read before it runs and must stay open until the write.
+    xmss_async_cb done;
+    void *user;
+    int notify_fd;
+
+    int result;                   // Sign: 0 on success, -1 on failure (xmss_sign_auto()). Verify: 1 valid, 0 invalid.
+};
+
+typedef struct xmss_async xmss_async;
+
+// Start a queue with the given number of worker threads and at most capacity pending jobs.
+// Each worker runs one job at a time, so up to `threads` verifications run in parallel.
+// Returns NULL on failure.
+xmss_async *xmss_async_create(int threads, int capacity);
+
+// Queue a job without blocking. Returns 0, or -1 if the queue is full or shutting down.
+int  xmss_async_submit(xmss_async *q, xmss_async_job *job);
+
+// Finish every queued job, then stop the workers and free the queue
+void xmss_async_destroy(xmss_async *q);
+
+#endif
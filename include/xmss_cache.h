@@ -0,0 +1,52 @@
+#ifndef XMSS_CACHE_H
+#define XMSS_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hash.h"
+#include "xmss_config.h"
+
+#define XMSS_CACHE_FILE "xmss_cache.bin"
+
+// Number of top tree levels kept in the cache (2^(XMSS_CACHE_LEVELS+1) nodes at most)
+#ifndef XMSS_CACHE_LEVELS
+#define XMSS_CACHE_LEVELS 18
+#endif
+
+// Node cache: every node at heights [base, h] of one key's tree, bound to the key by its root.
+// Height t holds 2^(h-t) nodes. Nodes inside subtrees outside the activation window are never
+// needed and stay zero.
+typedef struct {
+    int h;
+    int n;
+    int base;                // Lowest cached height
+    uint8_t root[HASH_SIZE]; // Root of the key the nodes belong to
+    uint8_t *nodes;
+} xmss_node_cache;
+
+// Lowest cached height for the given parameters (also the keygen chunk height)
+int xmss_cache_base(const xmss_params *params);
+
+// Cache memory management
+int  xmss_cache_init(xmss_node_cache *cache, const xmss_params *params);
+void xmss_cache_free(xmss_node_cache *cache);
+size_t xmss_cache_bytes(const xmss_node_cache *cache);
+
+// Pointer to node (height, index), or NULL if the height is not cached
+uint8_t *xmss_cache_node(const xmss_node_cache *cache, int height, uint64_t index);
+
+// Save/load the cache (parameter header, base, root, nodes). Loading checks the parameters.
+int xmss_cache_save(const char *path, const xmss_node_cache *cache, const xmss_params *params);
+int xmss_cache_load(const char *path, xmss_node_cache *cache, const xmss_params *params);
+
+// Attach a cache for auth path computation (NULL detaches). It is only used for the key with the same root.
+void xmss_cache_use(const xmss_node_cache *cache);
+
+// Attach a cache for the calling thread only, ahead of xmss_cache_use() (NULL detaches). Lets
+// threads that sign under different keys each use their key's cache.
+void xmss_cache_use_thread(const xmss_node_cache *cache);
+
+// The attached cache if it belongs to the key with this root, otherwise NULL
+const xmss_node_cache *xmss_cache_for(const xmss_params *params, const uint8_t *root);
+
+#endif
@@ -3,11 +3,27 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
+
+// WOTS+ message encodings
+#define WOTS_ENCODING_CHECKSUM   0  // Classic WOTS+: base-w digits plus checksum chains
+#define WOTS_ENCODING_TARGET_SUM 1  // Target-sum: randomized rehashing until the digits sum to a fixed value
+
+// Hash modes
+#define XMSS_HASH_PLAIN   0  // Untweaked SHAKE256(x) for chains and tree nodes
+#define XMSS_HASH_TWEAKED 1  // RFC 8391 F, RAND_HASH and L-tree, keyed and masked by PRF(pub_seed, ADRS)
+
+// Specialized WOTS+ kernel table (see wots_kernels.h)
+typedef struct wots_kernels wots_kernels;
+
+// Hash backend (see hash.h)
+typedef struct hash_backend hash_backend;
 
 // Struct to hold all runtime-configurable XMSS/WOTS parameters
 typedef struct {
     int h;          // XMSS tree height
     int w;          // WOTS+ Winternitz parameter
+    int n;          // Hash output length in bytes (16, 24 or 32)
 
     // Derived WOTS parameters
     int log_w;      // log2(w)
@@ -15,8 +31,23 @@ typedef struct {
     int wots_len2;
     int wots_len;   // Total WOTS+ chain length
 
+    // WOTS+ encoding
+    int encoding;   // WOTS_ENCODING_CHECKSUM or WOTS_ENCODING_TARGET_SUM
+    int target_sum; // Required digit sum for the target-sum encoding
+
+    // Hashing
+    int hash_mode;  // XMSS_HASH_PLAIN or XMSS_HASH_TWEAKED
+    const hash_backend *hash; // Hash family of every chain, node, PRF and digest (default SHAKE256)
+
+    // WOTS+ kernels for (w, n), re-selected whenever w or n change
+    const wots_kernels *kernels;
+
     // Derived XMSS parameters
     uint64_t max_keys; // 2^h
+
+    // Activation window: the key may only sign leaves (epochs) in [act_start, act_start + act_count)
+    uint64_t act_start;
+    uint64_t act_count;
 } xmss_params;
 
 // Calculate log2 for integer powers of 2
@@ -25,4 +56,43 @@ int int_log2(int n);
 // Initializes the parameter structure based on h and w.
 int xmss_params_init(xmss_params *params, int h, int w);
 
+// Select the hash output length n (16, 24 or 32 bytes). Chain lengths are recomputed and a
+// target-sum encoding falls back to the default target for the new n.
+int xmss_params_set_n(xmss_params *params, int n);
+
+// Select the WOTS+ encoding. A target_sum of 0 selects the default (one std. deviation above the mean digit sum).
+int xmss_params_set_encoding(xmss_params *params, int encoding, int target_sum);
+
+// Select the hash mode (plain or address-tweaked)
+int xmss_params_set_hash_mode(xmss_params *params, int hash_mode);
+
+// Select the hash backend (HASH_BACKEND_*)
+int xmss_params_set_hash_backend(xmss_params *params, int backend);
+
+// Write/read the parameter header shared by key and signature files. The backend id is stored in
+// the bits above the hash mode, so SHAKE256 headers are unchanged.
+int xmss_params_write(FILE *f, const xmss_params *params);
+int xmss_params_read(FILE *f, xmss_params *params);
+
+// The same header as words (h, w, n, encoding, target sum, hash word), for fixed-size records
+#define XMSS_PARAMS_WORDS 6
+void xmss_params_encode(const xmss_params *params, int32_t words[XMSS_PARAMS_WORDS]);
+int  xmss_params_decode(xmss_params *params, const int32_t words[XMSS_PARAMS_WORDS]);
+
+// Leaves that can be signed: indices (and the state file) are int, so at most [0, 2^31)
+#define XMSS_MAX_SIGN_LEAVES ((uint64_t)INT32_MAX + 1)
+
+// Restrict the key to the activation window [start, start + count), which must end by
+// min(2^h, XMSS_MAX_SIGN_LEAVES). Defaults to that whole range.
+int xmss_params_set_activation(xmss_params *params, uint64_t start, uint64_t count);
+
+// Check whether a leaf index lies inside the activation window
+int xmss_params_is_active(const xmss_params *params, uint64_t index);
+
+// Check whether a subtree (height, index) intersects the activation window
+int xmss_params_subtree_active(const xmss_params *params, int height, uint64_t index);
+
+// Check whether two parameter sets describe the same tree (including the activation window)
+int xmss_params_equal(const xmss_params *a, const xmss_params *b);
+
 #endif
\ No newline at end of file
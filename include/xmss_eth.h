@@ -6,9 +6,14 @@
 #include "xmss.h"
 #include "xmss_config.h"
 
+// Signature file header: magic, then a uint32 version, then the parameter words
+#define XMSS_SIG_MAGIC   "XSIG"
+#define XMSS_SIG_VERSION 1
+
 // Compute the serialized signature size for the given XMSS/WOTS parameters
 static inline size_t xmss_eth_sig_size(const xmss_params *params) {
-    return 4 + ((size_t)params->wots_len + (size_t)params->h) * HASH_SIZE;
+    size_t nonce = (params->encoding == WOTS_ENCODING_TARGET_SUM) ? WOTS_NONCE_BYTES : 0;
+    return 4 + nonce + ((size_t)params->wots_len + (size_t)params->h) * (size_t)params->n;
 }
 
 /* Serialize XMSS signature to Ethereum compact form.*/
@@ -20,7 +25,10 @@ int xmss_eth_serialize(const xmss_params *params, const XMSSSignature *sig,
 int xmss_eth_deserialize(xmss_params *params, XMSSSignature *sig,
                          const uint8_t *in, size_t in_len);
 
-/* Save/load Ethereum compact sig file. */
+/* Save/load Ethereum compact sig file: XMSS_SIG_MAGIC, a uint32 version, the parameter words,
+ * then the compact signature. Load also reads the original headerless layout (int h, int w, then a
+ * SHAKE256, n = 32 signature) and rejects anything else. It returns 1 on success, 0 if the file is
+ * missing and -1 if it is unreadable. */
 int xmss_eth_save_sig(const char *path, const XMSSSignature *sig, const xmss_params *params);
 int xmss_eth_load_sig(const char *path, XMSSSignature *sig, xmss_params *params);
 
@@ -0,0 +1,53 @@
+#ifndef XMSS_KEYGEN_H
+#define XMSS_KEYGEN_H
+
+#include <stdint.h>
+#include "xmss.h"
+#include "xmss_cache.h"
+#include "xmss_config.h"
+
+#define XMSS_PROGRESS_FILE "xmss_keygen.progress"
+
+// Default checkpoint interval in leaves
+#define XMSS_CHECKPOINT_DEFAULT (1ULL << 16)
+
+// Treehash state: the next leaf to process and the stack of completed subtree roots
+// (at most one per height, so h + 1 entries)
+typedef struct {
+    uint64_t next_leaf;
+    int top;
+    struct {
+        int height;
+        uint64_t index;
+        uint8_t node[HASH_SIZE];
+    } stack[33];
+} xmss_treehash_state;
+
+// Start a treehash at the given leaf
+void xmss_treehash_init(xmss_treehash_state *st, uint64_t first_leaf);
+
+// Push a completed subtree root (aligned, left to right) and merge it with its left neighbours.
+// Nodes at heights >= cache->base are stored in the cache (which may be NULL).
+void xmss_treehash_push(const xmss_params *params, const XMSSKey *key, xmss_node_cache *cache,
+                        xmss_treehash_state *st, int height, uint64_t index, const uint8_t *node);
+
+// Advance the treehash by one chunk (at most 2^base leaves, or one whole subtree outside the
+// activation window) without passing end_leaf. Every node at heights >= cache->base is stored
+// in the cache (which may be NULL). Returns 1 while leaves remain before end_leaf, 0 when done.
+int xmss_treehash_step(const xmss_params *params, XMSSKey *key, xmss_node_cache *cache,
+                       xmss_treehash_state *st, uint64_t end_leaf);
+
+// Treehash keygen: the same root as xmss_keygen(), built left to right with O(h) memory.
+// With a progress_path, the seeds, the next leaf, the treehash stack and the partial cache are
+// checkpointed there every checkpoint_leaves leaves, and an existing progress file is resumed
+// (its seeds replace freshly drawn ones). The progress file holds the secret seed and is removed
+// once the root is complete. The progress file is created 0600, and a resumed one must describe
+// a consistent treehash stack. Returns 0 on success, -1 on error.
+int xmss_keygen_resumable(const xmss_params *params, XMSSKey *key, xmss_node_cache *cache,
+                          const char *progress_path, uint64_t checkpoint_leaves);
+
+// The same treehash without a progress file, over the seeds already in key (e.g. drawn by
+// xmss_keygen_seeds() on another thread). Fills key->root and the cache (which may be NULL).
+int xmss_keygen_cached(const xmss_params *params, XMSSKey *key, xmss_node_cache *cache);
+
+#endif
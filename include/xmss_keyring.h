@@ -0,0 +1,61 @@
+#ifndef XMSS_KEYRING_H
+#define XMSS_KEYRING_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "xmss.h"
+#include "xmss_cache.h"
+#include "xmss_config.h"
+
+// A keyring is a directory holding many keys of one signer process. Key id i keeps its own key,
+// state and (optional) node cache files, in the same formats as xmss_key.bin, xmss_state.dat
+// and xmss_cache.bin.
+#define XMSS_KEYRING_KEY_FMT   "%s/key_%u.bin"
+#define XMSS_KEYRING_STATE_FMT "%s/state_%u.dat"
+#define XMSS_KEYRING_CACHE_FMT "%s/cache_%u.bin"
+
+// Signatures made by the CLI under key id i (Ethereum compact form)
+#define XMSS_KEYRING_SIG_FMT   "%s/sig_%u.bin"
+
+// One key of the ring
+typedef struct {
+    uint32_t id;
+    xmss_params params;
+    XMSSKey *key;             // Secret key in locked secure memory (xmss_key_alloc())
+    int next_index;           // Next unused leaf (mirrors the state file)
+    int have_cache;
+    xmss_node_cache cache;    // Traversal data for this key's auth paths
+} xmss_keyring_entry;
+
+// Open keyring (entries sorted by id)
+typedef struct {
+    char *dir;
+    int count;
+    xmss_keyring_entry *entries;
+    pthread_mutex_t lock;     // Serializes leaf reservations
+} xmss_keyring;
+
+// Open a keyring directory (created if missing) and load every key with its state and cache
+int  xmss_keyring_open(xmss_keyring *ring, const char *dir);
+
+// Wipe the secret keys and free the caches
+void xmss_keyring_close(xmss_keyring *ring);
+
+// Entry of a key id, or NULL
+xmss_keyring_entry *xmss_keyring_find(const xmss_keyring *ring, uint32_t id);
+
+// Generate a new key with its cache and initial state under an unused id
+int  xmss_keyring_generate(xmss_keyring *ring, uint32_t id, const xmss_params *params);
+
+// Sign with key id at its next unused leaf. sig must be allocated for that key's parameters.
+// The state file is advanced before signing, so a crash never reuses a leaf.
+int  xmss_keyring_sign(xmss_keyring *ring, uint32_t id, const uint8_t *msg, XMSSSignature *sig);
+
+// Sign one message under count keys. The message is digested once per distinct hash backend and n,
+// leaves are reserved serially, and the signatures are spread over the worker pool (each thread
+// uses its key's cache). sigs[i] must be allocated for key ids[i]; results[i] (optional) is 1 if
+// signature i was made. Returns the number of signatures made.
+int  xmss_keyring_sign_batch(xmss_keyring *ring, const uint8_t *msg, const uint32_t *ids, int count,
+                             XMSSSignature *sigs, int *results);
+
+#endif
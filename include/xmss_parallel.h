@@ -0,0 +1,23 @@
+#ifndef XMSS_PARALLEL_H
+#define XMSS_PARALLEL_H
+
+// Below this many hashes per call, waking the workers costs more than it saves
+#ifndef XMSS_PARALLEL_MIN_HASHES
+#define XMSS_PARALLEL_MIN_HASHES 512
+#endif
+
+// Start a persistent pool of worker threads (0 = one per online core, minus the caller).
+// The pool belongs to the calling thread: calls from any other thread, and nested calls, run serially.
+int  xmss_parallel_start(int threads);
+
+// Stop and join the workers
+void xmss_parallel_stop(void);
+
+// Number of running workers (0 = serial)
+int  xmss_parallel_threads(void);
+
+// Run fn(ctx, i) for i in [0, count) on the workers and the calling thread, returning when all are done.
+// hashes estimates the total work; small calls, calls without a pool and nested calls run serially.
+void xmss_parallel_for(int count, long hashes, void (*fn)(void *ctx, int i), void *ctx);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef XMSS_PATHCACHE_H
+#define XMSS_PATHCACHE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "hash.h"
+#include "thash.h"
+#include "xmss_config.h"
+
+// Number of top tree levels whose proven nodes are kept (2^(XMSS_PATHCACHE_LEVELS+1) nodes at most)
+#ifndef XMSS_PATHCACHE_LEVELS
+#define XMSS_PATHCACHE_LEVELS 14
+#endif
+
+// Proven-node cache of one trusted root: nodes at heights [base, h) that a verified signature
+// has already connected to the root. A node is only stored after the path through it reached
+// the root, so meeting a cached node ends root reconstruction early.
+typedef struct xmss_path_cache {
+    int h;
+    int n;
+    int base;                                 // Lowest cached height
+    uint8_t root[HASH_SIZE];
+    uint8_t pub_seed[XMSS_PUB_SEED_BYTES];    // Zero in plain mode
+    uint8_t *nodes;                           // Height t holds 2^(h-t) nodes, as in xmss_node_cache
+    uint8_t *proven;                          // One flag per node
+    uint64_t hits;                            // Verifications ended early by a cached node
+    pthread_mutex_t lock;
+    struct xmss_path_cache *next;             // Attached caches
+} xmss_path_cache;
+
+// Cache memory management (free also detaches)
+int  xmss_pathcache_init(xmss_path_cache *cache, const xmss_params *params, const uint8_t *root,
+                         const uint8_t *pub_seed);
+void xmss_pathcache_free(xmss_path_cache *cache);
+
+// Compare a reconstructed node and the auth path above it with the cache: 1 if both are proven,
+// 0 if a different node or sibling is proven there (the path cannot reach the root), -1 if unknown
+int  xmss_pathcache_check(xmss_path_cache *cache, int height, uint64_t index, const uint8_t *node,
+                          uint8_t *const *auth_path);
+
+// Store the path of a signature that reached the root (or a proven node at height top): the
+// reconstructed nodes path[t] and the auth path siblings for every t < top
+void xmss_pathcache_insert(xmss_path_cache *cache, uint64_t leaf, int top, uint8_t (*path)[HASH_SIZE],
+                           uint8_t *const *auth_path);
+
+// Attach a cache to xmss_verify() (several caches, one per root, may be attached)
+void xmss_pathcache_use(xmss_path_cache *cache);
+
+// The attached cache for this root and public seed, or NULL
+xmss_path_cache *xmss_pathcache_for(const xmss_params *params, const uint8_t *root, const uint8_t *pub_seed);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef XMSS_PRECOMP_H
+#define XMSS_PRECOMP_H
+
+#include <stdint.h>
+#include "xmss.h"
+#include "xmss_config.h"
+
+// Default number of leaves kept ready
+#define XMSS_PRECOMP_DEFAULT 16
+
+// One prepared leaf: every intermediate chain value plus the auth path
+typedef struct {
+    uint64_t index;
+    uint8_t *chains;    // wots_len * w * n bytes (secret, in xmss_secmem.h memory), see wots_precompute_chains()
+    uint8_t *auth_path; // h * n bytes
+} xmss_precomp_leaf;
+
+// Ring of prepared leaves with consecutive indices, bound to one key by its root
+struct xmss_precomp_pool {
+    int capacity;
+    int head;                   // Slot of the lowest prepared index
+    int count;                  // Number of prepared leaves
+    uint8_t root[HASH_SIZE];    // Root of the key the leaves belong to
+    xmss_precomp_leaf *leaves;
+};
+
+// Pool memory management. Freeing wipes every prepared leaf.
+int  xmss_precomp_init(xmss_precomp_pool *pool, const xmss_params *params, int capacity);
+void xmss_precomp_free(xmss_precomp_pool *pool, const xmss_params *params);
+
+// Offline step: drop leaves below next_index and prepare leaves from next_index onward until
+// the pool is full or the activation window ends. Returns the number of prepared leaves, -1 on error.
+int  xmss_precomp_fill(xmss_precomp_pool *pool, const xmss_params *params, XMSSKey *key, uint64_t next_index);
+
+// Online step: sign with the prepared leaf 'index', which is wiped and removed from the pool.
+// Returns -1 (without touching sig) if that leaf is not prepared for this key.
+int  xmss_precomp_sign(xmss_precomp_pool *pool, const xmss_params *params, const uint8_t *msg,
+                       const XMSSKey *key, XMSSSignature *sig, uint64_t index);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef XMSS_PREGEN_H
+#define XMSS_PREGEN_H
+
+#include <stdint.h>
+#include "xmss.h"
+#include "xmss_cache.h"
+#include "xmss_config.h"
+
+// Staged files of the next key (renamed over XMSS_KEY_FILE / XMSS_STATE_FILE / XMSS_CACHE_FILE on rotation)
+#define XMSS_NEXT_KEY_FILE   "xmss_key.next.bin"
+#define XMSS_NEXT_STATE_FILE "xmss_state.next.dat"
+#define XMSS_NEXT_CACHE_FILE "xmss_cache.next.bin"
+
+// Commit marker: while it exists, the staged files are committed and still being installed
+#define XMSS_ROTATE_MARKER   "xmss_rotate.commit"
+
+// Build the next key in the background once this fraction of the activation window has
+// been used (0 < threshold <= 1). A threshold of 0 disables pre-generation (the default).
+int  xmss_pregen_enable(double threshold);
+
+// Called after each signature with the next unused index. Starts the low-priority
+// pre-generation thread when the threshold is crossed and no key is staged yet.
+void xmss_pregen_check(const xmss_params *params, uint64_t next_index);
+
+// Stage a key with its initial state and node cache (which may be NULL). The key file is written
+// last, so its presence means the staged set is complete. Returns 0 or -1.
+int  xmss_pregen_stage(const xmss_params *params, const XMSSKey *key, const xmss_node_cache *cache);
+
+// Install the staged key (waiting for a running pre-generation first). The commit marker is
+// written, then the staged files are renamed over the live ones and the marker is removed.
+// The staged node cache is loaded and attached with xmss_cache_use().
+// Returns 1 if a key was installed, 0 if none is staged.
+int  xmss_pregen_rotate(const xmss_params *params, XMSSKey *key);
+
+// Finish a rotation interrupted after its commit marker was written. xmss_load_key() and
+// xmss_load_state() call this first. Returns 1 if one was finished, 0 if none was pending, -1 on failure.
+int  xmss_pregen_recover(void);
+
+// Wait for a running pre-generation. This blocks until the whole next key is built, so a process
+// that calls it before exiting (like the CLI) exits only after that.
+// Returns 1 if a key was staged, 0 if none was running, -1 on failure.
+int  xmss_pregen_wait(void);
+
+#endif
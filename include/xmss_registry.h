@@ -0,0 +1,68 @@
+#ifndef XMSS_REGISTRY_H
+#define XMSS_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xmss.h"
+#include "xmss_aggregate.h"
+#include "xmss_config.h"
+
+// Validator public-key registry file: a 64-byte header followed by a table of fixed-size records.
+// Record i holds validator id i, so a lookup is one offset computation into the mapped file.
+// Integers are in host byte order, like the key and signature files.
+#define XMSS_REGISTRY_MAGIC   "XREG"
+#define XMSS_REGISTRY_VERSION 1
+#define XMSS_REGISTRY_PRESENT XMSS_KEY_REGISTRY_PRESENT  // Record flag: the slot holds a key
+
+// File header
+typedef struct {
+    char     magic[4];       // XMSS_REGISTRY_MAGIC
+    uint32_t version;        // XMSS_REGISTRY_VERSION
+    uint32_t record_bytes;   // sizeof(xmss_registry_record)
+    uint32_t capacity;       // Number of slots (highest id + 1, rounded up)
+    uint32_t count;          // Occupied slots
+    uint8_t  reserved[44];
+} xmss_registry_header;
+
+// One validator key. Empty slots are all zero, so their roots never verify.
+typedef struct {
+    uint32_t id;
+    uint32_t flags;                       // XMSS_REGISTRY_PRESENT
+    int32_t  params[XMSS_PARAMS_WORDS];   // Parameter header words (xmss_params_encode())
+    uint8_t  root[HASH_SIZE];             // First n bytes are used
+    uint8_t  pub_seed[XMSS_PUB_SEED_BYTES];
+} xmss_registry_record;
+
+// An open registry (the whole file is mapped; writable registries grow on demand)
+typedef struct {
+    int fd;
+    int writable;
+    uint8_t *map;
+    size_t map_bytes;
+    xmss_registry_header *header;
+    xmss_registry_record *records;
+} xmss_registry;
+
+// Open a registry file. With writable set, a missing file is created empty. The file is locked until
+// close: exclusively for a writable registry, shared otherwise, so readers never see a half-done update.
+int  xmss_registry_open(xmss_registry *reg, const char *path, int writable);
+void xmss_registry_close(xmss_registry *reg);
+
+// Record of a validator id, or NULL if the slot is empty
+const xmss_registry_record *xmss_registry_lookup(const xmss_registry *reg, uint32_t id);
+
+// Insert or replace a validator key (the file grows to cover id); remove clears the slot
+int  xmss_registry_put(xmss_registry *reg, uint32_t id, const xmss_params *params, const uint8_t *root,
+                       const uint8_t *pub_seed);
+int  xmss_registry_remove(xmss_registry *reg, uint32_t id);
+
+// Parameters of a record, and whether they equal params (activation windows are not recorded)
+int  xmss_registry_record_params(const xmss_registry_record *rec, xmss_params *params);
+int  xmss_registry_record_matches(const xmss_registry_record *rec, const xmss_params *params);
+
+// View the mapped table as an xmss_key_registry whose positions are validator ids, so
+// xmss_aggregate_verify() reads roots and seeds straight from the file. count is the number of
+// slots; empty slots and keys with other parameters are rejected through the flags and params words.
+void xmss_registry_view(const xmss_registry *reg, xmss_key_registry *view);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef XMSS_SECMEM_H
+#define XMSS_SECMEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Secure heap for secret key material. Small blocks come from 64 KiB regions that are mapped on
+// demand, locked into RAM (mlock) and excluded from core dumps, so secrets never reach swap.
+// Allocation is a bump pointer plus one free list per power-of-two size class, so no system call
+// is made per operation. Guard pages surround each region, not each block: running off a region
+// faults, but an overrun into a neighbouring block of the same region does not.
+#define XMSS_SECMEM_REGION_BYTES (64 * 1024)
+
+// Zeroed, 16-byte aligned secret memory. Requests larger than a quarter region get a locked
+// mapping of their own, ending at a guard page. Only if no memory can be mapped at all does this
+// fall back to the ordinary heap, with a warning printed once. NULL if that fails too.
+void *xmss_secmem_alloc(size_t bytes);
+
+// Wipe a block and return it to its free list (NULL is ignored)
+void  xmss_secmem_free(void *ptr);
+
+// Bytes currently mapped for the pool and how many of them are locked
+size_t xmss_secmem_mapped_bytes(void);
+size_t xmss_secmem_locked_bytes(void);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef XMSS_SHARD_H
+#define XMSS_SHARD_H
+
+#include <stdint.h>
+#include "xmss.h"
+#include "xmss_cache.h"
+#include "xmss_config.h"
+
+// Shared seeds of a sharded keygen (parameter header + XMSSKey without root). Secret: copy it
+// to every host that computes shards, and keep it away from anything else.
+#define XMSS_SEED_FILE "xmss_seed.bin"
+
+// Default shard file name for shard i of N
+#define XMSS_SHARD_FILE_FMT "xmss_shard_%d_of_%d.bin"
+
+// Check that i/N names a shard: N a power of two, at most 2^h, and 0 <= i < N. Prints why not; returns 0 or -1.
+int xmss_shard_check(const xmss_params *params, int shard, int shards);
+
+// Load the shared seeds, creating the seed file (mode 0600, like every key file) if it does not
+// exist yet. Returns 0 on success, -1 if the file is unreadable or was written for other parameters.
+int xmss_shard_seed(const xmss_params *params, XMSSKey *key);
+
+// Compute shard i of N (N a power of two, at most 2^h): the root of the subtree over leaves
+// [i * 2^h/N, (i + 1) * 2^h/N) and, if with_cache is set, that subtree's node-cache segment.
+int xmss_shard_generate(const xmss_params *params, XMSSKey *key, int shard, int shards,
+                        int with_cache, const char *path);
+
+// Merge shard files into the final key. The shards must cover all leaves exactly once (gaps and
+// overlaps are reported) and belong to the seeds in the seed file. params and key receive the
+// merged key. The cache is filled if every shard carries its segment (*have_cache is set then).
+int xmss_shard_merge(const char *const *paths, int count, xmss_params *params, XMSSKey *key,
+                     xmss_node_cache *cache, int *have_cache);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef XMSS_SIGBATCH_H
+#define XMSS_SIGBATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xmss.h"
+#include "wots.h"
+#include "xmss_config.h"
+
+// Batch file header: magic, then a uint32 version, then the parameter words
+#define XMSS_SIGBATCH_MAGIC   "XBAT"
+#define XMSS_SIGBATCH_VERSION 1
+
+// Signatures of several messages by one key, with their auth paths merged into one Merkle
+// multi-proof (merkle.h). Entry i signs message i; leaf indices are strictly increasing.
+typedef struct {
+    int count;
+    int proof_nodes;
+    uint64_t *indices;
+    WOTSSignature *wots;
+    uint8_t *proof;       // proof_nodes * n bytes
+} xmss_sigbatch;
+
+// Serialized size: u32 count, u32 proof_nodes, count entries of u32 index, nonce (target-sum only)
+// and WOTS+ chains, then the proof nodes (all little-endian)
+static inline size_t xmss_sigbatch_size(const xmss_params *params, int count, int proof_nodes) {
+    size_t nonce = (params->encoding == WOTS_ENCODING_TARGET_SUM) ? WOTS_NONCE_BYTES : 0;
+    return 8 + (size_t)count * (4 + nonce + (size_t)params->wots_len * (size_t)params->n) +
+           (size_t)proof_nodes * (size_t)params->n;
+}
+
+// Build a batch from count signatures of one key in increasing leaf order (copies the WOTS+ parts
+// and extracts the multi-proof from the auth paths). 0 on success, -1 on bad indices or no memory.
+int  xmss_sigbatch_build(const xmss_params *params, xmss_sigbatch *batch, XMSSSignature *const *sigs, int count);
+void xmss_sigbatch_free(xmss_sigbatch *batch, const xmss_params *params);
+
+// Serialize a batch into out (at least xmss_sigbatch_size() bytes)
+int  xmss_sigbatch_serialize(const xmss_params *params, const xmss_sigbatch *batch, uint8_t *out, size_t out_cap,
+                             size_t *out_len);
+
+// Parse a batch (allocates batch; free with xmss_sigbatch_free()). The length must match exactly.
+int  xmss_sigbatch_deserialize(const xmss_params *params, xmss_sigbatch *batch, const uint8_t *in, size_t in_len);
+
+// Save/load a batch file (header, then the serialized batch). Load returns 1 on success, 0 if the
+// file is missing and -1 if it is unreadable.
+int  xmss_sigbatch_save(const char *path, const xmss_sigbatch *batch, const xmss_params *params);
+int  xmss_sigbatch_load(const char *path, xmss_sigbatch *batch, xmss_params *params);
+
+// Verify a batch of messages (msgs[i] NUL-terminated, one per entry): recover every leaf from its
+// WOTS+ signature, rebuild the root from the multi-proof and compare it with root. Returns 1 if valid.
+int  xmss_sigbatch_verify(const xmss_params *params, const uint8_t *const *msgs, const xmss_sigbatch *batch,
+                          const uint8_t *root, const uint8_t *pub_seed);
+
+#endif
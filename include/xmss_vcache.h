@@ -0,0 +1,59 @@
+#ifndef XMSS_VCACHE_H
+#define XMSS_VCACHE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "hash.h"
+#include "xmss.h"
+#include "xmss_config.h"
+
+// Lock stripes and entries per bucket
+#define XMSS_VCACHE_STRIPES 16
+#define XMSS_VCACHE_WAYS    8
+
+// Default number of entries (about 40 bytes each)
+#define XMSS_VCACHE_DEFAULT (1 << 16)
+
+// One remembered verification
+typedef struct {
+    uint8_t digest[HASH_SIZE]; // SHAKE256 of parameters, message digest, signature, root and public seed
+    uint8_t used;
+    uint8_t result;            // xmss_verify() outcome
+    uint8_t referenced;        // CLOCK bit
+} xmss_vcache_entry;
+
+// Verified-signature cache: fixed-size, XMSS_VCACHE_WAYS-way buckets with CLOCK eviction.
+// Bucket b is guarded by lock b % XMSS_VCACHE_STRIPES.
+typedef struct {
+    uint64_t buckets;          // Power of two
+    xmss_vcache_entry *entries;
+    uint8_t *hands;            // CLOCK hand per bucket
+    pthread_mutex_t locks[XMSS_VCACHE_STRIPES];
+    uint64_t hits;
+    uint64_t misses;
+} xmss_verify_cache;
+
+// Allocate a cache of at least the given number of entries (rounded up to a power of two)
+int  xmss_vcache_init(xmss_verify_cache *cache, uint64_t entries);
+void xmss_vcache_free(xmss_verify_cache *cache);
+
+// Key of one verification; 0, or -1 if the hash failed (the digest must then not be used)
+int  xmss_vcache_digest(const xmss_params *params, const uint8_t *msg_hash, const XMSSSignature *sig,
+                        const uint8_t *root, const uint8_t *pub_seed, uint8_t digest[HASH_SIZE]);
+
+// Look up a digest: returns the cached result (0 or 1), or -1 on a miss
+int  xmss_vcache_lookup(xmss_verify_cache *cache, const uint8_t digest[HASH_SIZE]);
+
+// Remember a verification result
+void xmss_vcache_insert(xmss_verify_cache *cache, const uint8_t digest[HASH_SIZE], int result);
+
+// Hit and miss counters since init
+void xmss_vcache_stats(const xmss_verify_cache *cache, uint64_t *hits, uint64_t *misses);
+
+// Attach a cache to xmss_verify() and xmss_verify_batch() (NULL detaches)
+void xmss_vcache_use(xmss_verify_cache *cache);
+
+// The attached cache, or NULL
+xmss_verify_cache *xmss_vcache_attached(void);
+
+#endif
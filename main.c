@@ -14,13 +14,22 @@
 #include "hash.h"
 #include "xmss_config.h"
 #include "snark_export.h"
+#include "xmss_pregen.h"
+#include "xmss_cache.h"
+#include "xmss_keygen.h"
+#include "xmss_shard.h"
+#include "xmss_parallel.h"
+#include "xmss_registry.h"
+#include "xmss_keyring.h"
+#include "xmss_sigbatch.h"
+#include "util.h"
 
 // define constants
 #define ROOT_FILE "root.hex"
 #define SIG_FILE  "sig.bin"
 
 // Global variables for export
-XMSSKey global_xmss_key;
+uint8_t global_pub_seed[XMSS_PUB_SEED_BYTES];
 XMSSSignature global_last_signature;
 uint8_t global_last_root[HASH_SIZE];
 uint32_t global_last_index;
@@ -28,6 +37,14 @@ uint32_t global_last_index;
 // Global parameters for XMSS
 static xmss_params g_params;
 
+// Activation window and epoch selection
+static bool g_activation_set = false;
+static bool g_epoch_set = false;
+static uint64_t g_epoch = 0;
+
+// Keygen checkpoint interval in leaves (0 = no checkpointing unless a progress file is resumed)
+static uint64_t g_checkpoint = 0;
+
 // Convert bytes to hex string
 static void bytes_to_hex(const uint8_t *in, size_t len, char *out) {
     static const char *hex = "0123456789ABCDEF";
@@ -38,54 +55,82 @@ static void bytes_to_hex(const uint8_t *in, size_t len, char *out) {
     out[2*len] = '\0';
 }
 
-// Save/load the root hash
-static int save_root(const uint8_t *root) {
+// Human readable WOTS+ encoding name
+static const char *encoding_name(int encoding) {
+    return encoding == WOTS_ENCODING_TARGET_SUM ? "target-sum" : "checksum";
+}
+
+// Save the n-byte root hash (and the public seed for tweaked hashing, on a second line)
+static int save_root(const uint8_t *root, size_t n, const uint8_t *pub_seed) {
     FILE *f = fopen(ROOT_FILE, "w");
     if (!f) return 0;
     char hex[HASH_SIZE * 2 + 1];
-    bytes_to_hex(root, HASH_SIZE, hex);
+    bytes_to_hex(root, n, hex);
     fprintf(f, "%s\n", hex);
+    if (pub_seed) {
+        char seed_hex[XMSS_PUB_SEED_BYTES * 2 + 1];
+        bytes_to_hex(pub_seed, XMSS_PUB_SEED_BYTES, seed_hex);
+        fprintf(f, "%s\n", seed_hex);
+    }
     fclose(f);
     return 1;
 }
 
-// Load the root hash from a file
-static int load_root(uint8_t *root) {
-    FILE *f = fopen(ROOT_FILE, "r");
-    if (!f) return 0;
-    char hex[HASH_SIZE * 2 + 2];
-    if (!fgets(hex, sizeof(hex), f)) { fclose(f); return 0; }
+// Read one hex line of at most max_len bytes; returns the number of bytes decoded (0 on error)
+static size_t read_hex_line(FILE *f, uint8_t *out, size_t max_len) {
+    char hex[HASH_SIZE * 2 + 3];
+    if (!fgets(hex, sizeof(hex), f)) return 0;
     size_t l = strlen(hex);
-    if (l && (hex[l-1] == '\n' || hex[l-1] == '\r')) hex[l-1] = '\0';
-    fclose(f);
+    while (l && (hex[l-1] == '\n' || hex[l-1] == '\r')) hex[--l] = '\0';
 
     // Add error checking for hex string length
-    if (strlen(hex) != HASH_SIZE * 2) {
-        fprintf(stderr, "Invalid root hash length in %s\n", ROOT_FILE);
-        return 0;
-    }
+    if (l == 0 || l % 2 != 0 || l > max_len * 2) return 0;
 
     // Convert hex string to bytes
-    for (size_t i = 0; i < HASH_SIZE; i++) {
-        if (sscanf(hex + 2 * i, "%2hhx", &root[i]) != 1) return 0;
+    for (size_t i = 0; i < l / 2; i++) {
+        if (sscanf(hex + 2 * i, "%2hhx", &out[i]) != 1) return 0;
     }
+    return l / 2;
+}
+
+// Load the root hash (and the optional public seed) from a file
+static int load_root(uint8_t *root, size_t *root_len, uint8_t *pub_seed, bool *has_pub_seed) {
+    FILE *f = fopen(ROOT_FILE, "r");
+    if (!f) return 0;
+    *root_len = read_hex_line(f, root, HASH_SIZE);
+    if (*root_len == 0) {
+        fprintf(stderr, "Invalid root hash length in %s\n", ROOT_FILE);
+        fclose(f);
+        return 0;
+    }
+    *has_pub_seed = read_hex_line(f, pub_seed, XMSS_PUB_SEED_BYTES) == XMSS_PUB_SEED_BYTES;
+    fclose(f);
     return 1;
 }
 
 // This function signs a message using XMSS and saves the signature
-static int mode_sign(const char *message) {
-    XMSSKey key;
+static int mode_sign_key(const char *message, XMSSKey *key) {
     XMSSSignature sig;
     xmss_params params_from_file;
+    xmss_node_cache cache = {0};
 
     // Initialize parameters
-    int key_loaded = xmss_load_key(&key, &params_from_file);
+    int key_loaded = xmss_load_key(key, &params_from_file);
+    if (key_loaded < 0) {
+        // Never overwrite a key file that could not be read
+        fprintf(stderr, "ERROR: Could not load %s; move it aside to generate a new key.\n", XMSS_KEY_FILE);
+        return 1;
+    }
 
     // If a key is loaded, we need to verify the parameters match
     if (key_loaded == 1) {
         printf("Key file found!\n");
-        if(params_from_file.h != g_params.h || params_from_file.w != g_params.w) {
-            fprintf(stderr, "ERROR: Current parameters (h=%d, w=%d) do not match existing key file parameters.\n", g_params.h, g_params.w);
+        if(params_from_file.h != g_params.h || params_from_file.w != g_params.w ||
+           params_from_file.encoding != g_params.encoding || params_from_file.target_sum != g_params.target_sum ||
+           params_from_file.hash_mode != g_params.hash_mode || params_from_file.n != g_params.n ||
+           params_from_file.hash->id != g_params.hash->id) {
+            fprintf(stderr, "ERROR: Current parameters (h=%d, w=%d, encoding=%s) do not match existing key file parameters.\n",
+                    g_params.h, g_params.w, encoding_name(g_params.encoding));
             fprintf(stderr, "Please verify your configuration and delete or move the old key file if you wish to continue with these new parameters.\n");
             return 1; // Throw an error if parameters do not match
         }
@@ -105,23 +150,61 @@ static int mode_sign(const char *message) {
             return -1;
         }
 
-    // If no key is loaded, we generate a new key and save it
+        // The activation window is a property of the key; adopt it unless one was requested explicitly
+        if (g_activation_set && (params_from_file.act_start != g_params.act_start ||
+                                 params_from_file.act_count != g_params.act_count)) {
+            fprintf(stderr, "ERROR: Requested activation window does not match the existing key file.\n");
+            return 1;
+        }
+        g_params.act_start = params_from_file.act_start;
+        g_params.act_count = params_from_file.act_count;
+
+        // Use the node cache written at keygen, if any
+        if (xmss_cache_load(XMSS_CACHE_FILE, &cache, &g_params) == 1) xmss_cache_use(&cache);
+
+    // If no key is loaded, we generate a new key (resuming an interrupted keygen) and save it
     } else {
-        printf("Generating new XMSS key (h=%d, w=%d)...\n", g_params.h, g_params.w);
-        xmss_keygen(&g_params, &key);
-        if (xmss_save_key(&key, &g_params) != 0) {
+        printf("Generating new XMSS key (h=%d, w=%d, active leaves [%llu, %llu))...\n", g_params.h, g_params.w,
+               (unsigned long long)g_params.act_start, (unsigned long long)(g_params.act_start + g_params.act_count));
+        FILE *progress = fopen(XMSS_PROGRESS_FILE, "rb");
+        bool checkpointed = g_checkpoint > 0 || progress != NULL;
+        if (progress) fclose(progress);
+
+        if (xmss_cache_init(&cache, &g_params) != 0 ||
+            xmss_keygen_resumable(&g_params, key, &cache, checkpointed ? XMSS_PROGRESS_FILE : NULL, g_checkpoint) != 0) {
+            fprintf(stderr, "Failed to generate XMSS key\n");
+            xmss_cache_free(&cache);
+            return 1;
+        }
+        if (xmss_save_key(key, &g_params) != 0) {
             fprintf(stderr, "Failed to save XMSS key\n");
+            xmss_cache_free(&cache);
             return 1;
         }
-        xmss_save_state(0);
+        if (xmss_cache_save(XMSS_CACHE_FILE, &cache, &g_params) != 0) {
+            fprintf(stderr, "WARNING: Failed to save node cache %s\n", XMSS_CACHE_FILE);
+        }
+        xmss_cache_use(&cache);
+        xmss_save_state((int)g_params.act_start);
     }
 
-    // Save the root hash
+    // Sign either the requested epoch or the next unused leaf. One message per run, so no precompute
+    // pool: it would be filled and drained by the same call.
     if (xmss_alloc_sig(&sig, &g_params) != 0) { fprintf(stderr, "Failed to allocate signature\n"); return 1; }
-    xmss_sign_auto(&g_params, (const uint8_t*)message, &key, &sig);
+    if (g_epoch_set) {
+        if (xmss_sign_epoch(&g_params, (const uint8_t*)message, key, &sig, g_epoch) != 0) {
+            xmss_free_sig(&sig, &g_params);
+            xmss_cache_free(&cache);
+            return 1;
+        }
+    } else if (xmss_sign_auto(&g_params, (const uint8_t*)message, key, &sig, NULL) != 0) {
+        xmss_free_sig(&sig, &g_params);
+        xmss_cache_free(&cache);
+        return 1;
+    }
 
     // Save the signature to a file    
-    if (!save_root(key.root)) {
+    if (!save_root(key->root, g_params.n, g_params.hash_mode == XMSS_HASH_TWEAKED ? key->pub_seed : NULL)) {
         fprintf(stderr, "Failed to save root hex\n");
         return 1;
     }
@@ -133,31 +216,77 @@ static int mode_sign(const char *message) {
     }
 
     // Set global variables for export
-    global_xmss_key = key;
+    memcpy(global_pub_seed, key->pub_seed, XMSS_PUB_SEED_BYTES);
     global_last_signature = sig;
-    memcpy(global_last_root, key.root, HASH_SIZE);
+    memcpy(global_last_root, key->root, g_params.n);
     global_last_index = sig.index;
     size_t sigsz = xmss_eth_sig_size(&g_params);
 
     // Print the signature details
     printf("Message: \"%s\"\n", message);
     printf("Root (public key): ");
-    for (int i = 0; i < HASH_SIZE; i++) printf("%02X", key.root[i]);
+    for (int i = 0; i < g_params.n; i++) printf("%02X", key->root[i]);
     printf("\nIndex used: %d\n", sig.index);
     printf("Ethereum compact signature size: %zu bytes\n", sigsz);
+
+    // The signature is already saved; finish a pre-generation started by this signature (this blocks
+    // for a whole key generation)
+    if (xmss_pregen_wait() == 1) printf("Next key pre-generated and staged in %s\n", XMSS_NEXT_KEY_FILE);
     printf("Done.\n");
 
-    xmss_free_sig(&sig, &g_params);
+    // global_last_signature keeps the signature for the SNARK exports; main() frees it
+    xmss_cache_free(&cache);
     return 0;
 }
 
-// This function verifies a message signature using XMSS.
-static int mode_verify(const char *message) {
+// Sign with the key held in locked secure memory for the whole run
+static int mode_sign(const char *message) {
+    XMSSKey *key = xmss_key_alloc();
+    if (!key) {
+        fprintf(stderr, "Failed to allocate XMSS key\n");
+        return 1;
+    }
+    int r = mode_sign_key(message, key);
+    xmss_key_free(key);
+    return r;
+}
+
+// Load the root and public seed of a validator id from a registry file
+static int load_registry_root(const char *path, uint32_t id, uint8_t *root, size_t *root_len, uint8_t *pub_seed,
+                              bool *has_pub_seed, int32_t params_words[XMSS_PARAMS_WORDS]) {
+    xmss_registry reg;
+    if (xmss_registry_open(&reg, path, 0) != 0) return 0;
+    const xmss_registry_record *rec = xmss_registry_lookup(&reg, id);
+    if (!rec) {
+        fprintf(stderr, "Validator id %u is not in %s\n", id, path);
+        xmss_registry_close(&reg);
+        return 0;
+    }
+    memcpy(params_words, rec->params, sizeof(rec->params));
+    *root_len = (size_t)rec->params[2];
+    memcpy(root, rec->root, HASH_SIZE);
+    memcpy(pub_seed, rec->pub_seed, XMSS_PUB_SEED_BYTES);
+    *has_pub_seed = true;
+    xmss_registry_close(&reg);
+    return 1;
+}
+
+// This function verifies a message signature using XMSS, against root.hex or a registry entry.
+static int mode_verify(const char *message, const char *registry_path, uint32_t registry_id) {
     XMSSSignature sig;
     uint8_t root[HASH_SIZE];
+    size_t root_len = 0;
+    uint8_t pub_seed[XMSS_PUB_SEED_BYTES] = {0};
+    bool has_pub_seed = false;
+    int32_t registry_params[XMSS_PARAMS_WORDS];
 
-    // Load the signature file
-    if (!load_root(root)) {
+    // Load the root from the registry or root.hex
+    if (registry_path) {
+        if (!load_registry_root(registry_path, registry_id, root, &root_len, pub_seed, &has_pub_seed,
+                                registry_params)) {
+            return 1;
+        }
+    } else if (!load_root(root, &root_len, pub_seed, &has_pub_seed)) {
         fprintf(stderr, "Missing root.hex\n");
         return 1;
     }
@@ -171,17 +300,306 @@ static int mode_verify(const char *message) {
     }
 
     // Check if the parameters match the expected values
-    printf("Loaded signature (h=%d, w=%d, index=%d)\n", params_from_file.h, params_from_file.w, sig.index);
+    printf("Loaded signature (h=%d, w=%d, n=%d, encoding=%s, hash=%s, index=%d)\n", params_from_file.h,
+           params_from_file.w, params_from_file.n, encoding_name(params_from_file.encoding), params_from_file.hash->name,
+           sig.index);
     printf("Verifying message: \"%s\"\n", message);
 
+    // A registry key must have been registered with the signature's parameters
+    if (registry_path) {
+        int32_t words[XMSS_PARAMS_WORDS];
+        xmss_params_encode(&params_from_file, words);
+        if (memcmp(words, registry_params, sizeof(words)) != 0) {
+            fprintf(stderr, "Signature parameters do not match validator %u in %s\n", registry_id, registry_path);
+            xmss_free_sig(&sig, &params_from_file);
+            return 1;
+        }
+    }
+
+    // The root must have the signature's hash length
+    if (root_len != (size_t)params_from_file.n) {
+        fprintf(stderr, "Root length in %s (%zu bytes) does not match the signature (n=%d)\n",
+                ROOT_FILE, root_len, params_from_file.n);
+        xmss_free_sig(&sig, &params_from_file);
+        return 1;
+    }
+
+    // Tweaked hashing needs the public seed that belongs to the root
+    if (params_from_file.hash_mode == XMSS_HASH_TWEAKED && !has_pub_seed) {
+        fprintf(stderr, "Missing public seed in %s for a tweaked-hash signature\n", ROOT_FILE);
+        xmss_free_sig(&sig, &params_from_file);
+        return 1;
+    }
+
     // Verify the signature
-    int ok = xmss_verify(&params_from_file, (const uint8_t*)message, &sig, root);
+    int ok = xmss_verify(&params_from_file, (const uint8_t*)message, &sig, root, pub_seed);
     printf(ok ? "Verification SUCCESS\n" : "Verification FAILED\n");
     
-    xmss_free_sig(&sig, &g_params);
+    xmss_free_sig(&sig, &params_from_file);
+    return ok ? 0 : 1;
+}
+
+// Compute one keygen shard from the shared seed file
+static int mode_keygen_shard(int shard, int shards) {
+    XMSSKey key;
+    FILE *existing = fopen(XMSS_KEY_FILE, "rb");
+    if (existing) {
+        fclose(existing);
+        fprintf(stderr, "ERROR: %s already exists; shards are only computed for a new key.\n", XMSS_KEY_FILE);
+        return 1;
+    }
+    // Reject a bad i/N before the seed file is created
+    if (xmss_shard_check(&g_params, shard, shards) != 0) return 1;
+    if (xmss_shard_seed(&g_params, &key) != 0) return 1;
+
+    char path[64];
+    snprintf(path, sizeof(path), XMSS_SHARD_FILE_FMT, shard, shards);
+    printf("Computing keygen shard %d/%d (h=%d, w=%d)...\n", shard, shards, g_params.h, g_params.w);
+    int r = xmss_shard_generate(&g_params, &key, shard, shards, 1, path);
+    secure_zero_memory(&key, sizeof(key));
+    if (r != 0) {
+        fprintf(stderr, "Failed to compute shard %d/%d\n", shard, shards);
+        return 1;
+    }
+    printf("Shard written to %s\n", path);
+    return 0;
+}
+
+// Merge keygen shards into the final key, state and node cache
+static int mode_keygen_merge(const char *const *paths, int count) {
+    XMSSKey key;
+    xmss_params params;
+    xmss_node_cache cache = {0};
+    int have_cache = 0;
+    FILE *existing = fopen(XMSS_KEY_FILE, "rb");
+    if (existing) {
+        fclose(existing);
+        fprintf(stderr, "ERROR: %s already exists; move it away before merging shards.\n", XMSS_KEY_FILE);
+        return 1;
+    }
+    if (xmss_shard_merge(paths, count, &params, &key, &cache, &have_cache) != 0) {
+        fprintf(stderr, "Failed to merge %d shard(s)\n", count);
+        return 1;
+    }
+
+    int ok = xmss_save_key(&key, &params) == 0 && xmss_save_state((int)params.act_start) == 0;
+    if (ok && have_cache && xmss_cache_save(XMSS_CACHE_FILE, &cache, &params) != 0) {
+        fprintf(stderr, "WARNING: Failed to save node cache %s\n", XMSS_CACHE_FILE);
+    }
+    if (ok) {
+        printf("Merged %d shard(s) into %s (h=%d, w=%d)\n", count, XMSS_KEY_FILE, params.h, params.w);
+        printf("Root (public key): ");
+        for (int i = 0; i < params.n; i++) printf("%02X", key.root[i]);
+        printf("\n");
+    } else {
+        fprintf(stderr, "Failed to save XMSS key\n");
+    }
+    secure_zero_memory(&key, sizeof(key));
+    if (have_cache) xmss_cache_free(&cache);
+    return ok ? 0 : 1;
+}
+
+// Register the key in xmss_key.bin under a validator id (or remove the id)
+static int mode_registry_update(const char *path, uint32_t id, bool remove) {
+    xmss_registry reg;
+    if (xmss_registry_open(&reg, path, 1) != 0) return 1;
+    int r;
+    if (remove) {
+        r = xmss_registry_remove(&reg, id);
+        if (r != 0) fprintf(stderr, "Validator id %u is not in %s\n", id, path);
+        else printf("Removed validator %u from %s\n", id, path);
+    } else {
+        XMSSKey key;
+        xmss_params params;
+        if (xmss_load_key(&key, &params) != 1) {
+            fprintf(stderr, "Missing or invalid %s\n", XMSS_KEY_FILE);
+            xmss_registry_close(&reg);
+            return 1;
+        }
+        r = xmss_registry_put(&reg, id, &params, key.root, key.pub_seed);
+        if (r == 0) printf("Registered %s as validator %u in %s\n", XMSS_KEY_FILE, id, path);
+        secure_zero_memory(&key, sizeof(key));
+    }
+    if (r == 0) printf("Registry holds %u key(s) in %u slot(s)\n", reg.header->count, reg.header->capacity);
+    xmss_registry_close(&reg);
+    return r == 0 ? 0 : 1;
+}
+
+// Generate a new key in a keyring
+static int mode_keyring_add(const char *dir, uint32_t id) {
+    xmss_keyring ring;
+    if (xmss_keyring_open(&ring, dir) != 0) return 1;
+    printf("Generating keyring key %u (h=%d, w=%d, hash=%s)...\n", id, g_params.h, g_params.w, g_params.hash->name);
+    int r = xmss_keyring_generate(&ring, id, &g_params);
+    if (r == 0) {
+        const xmss_keyring_entry *e = xmss_keyring_find(&ring, id);
+        printf("Root (public key): ");
+        for (int i = 0; i < g_params.n; i++) printf("%02X", e->key->root[i]);
+        printf("\nKeyring %s holds %d key(s)\n", dir, ring.count);
+    }
+    xmss_keyring_close(&ring);
+    return r == 0 ? 0 : 1;
+}
+
+// Sign a message under one key of a keyring, or under all of them in one batch
+static int mode_keyring_sign(const char *dir, const char *message, bool one, uint32_t id) {
+    xmss_keyring ring;
+    if (xmss_keyring_open(&ring, dir) != 0) return 1;
+    int count = one ? 1 : ring.count;
+    uint32_t *ids = calloc((size_t)count + 1, sizeof(uint32_t));
+    XMSSSignature *sigs = calloc((size_t)count + 1, sizeof(XMSSSignature));
+    int *results = calloc((size_t)count + 1, sizeof(int));
+    int allocated = 0, failed = !ids || !sigs || !results;
+    if (one && !xmss_keyring_find(&ring, id)) {
+        fprintf(stderr, "Key id %u is not in keyring %s\n", id, dir);
+        failed = 1;
+    }
+    for (; !failed && allocated < count; allocated++) {
+        ids[allocated] = one ? id : ring.entries[allocated].id;
+        if (xmss_alloc_sig(&sigs[allocated], &xmss_keyring_find(&ring, ids[allocated])->params) != 0) failed = 1;
+    }
+
+    int made = 0;
+    if (!failed) {
+        made = xmss_keyring_sign_batch(&ring, (const uint8_t*)message, ids, count, sigs, results);
+        for (int i = 0; i < count; i++) {
+            if (!results[i]) continue;
+            char path[4096];
+            snprintf(path, sizeof(path), XMSS_KEYRING_SIG_FMT, dir, ids[i]);
+            if (xmss_eth_save_sig(path, &sigs[i], &xmss_keyring_find(&ring, ids[i])->params) != 0) {
+                fprintf(stderr, "Failed to save %s\n", path);
+                made--;
+                results[i] = 0;
+            } else {
+                printf("Key %u: index %d -> %s\n", ids[i], sigs[i].index, path);
+            }
+        }
+        printf("Signed \"%s\" under %d of %d keyring key(s)\n", message, made, count);
+    }
+
+    for (int i = 0; i < allocated; i++) xmss_free_sig(&sigs[i], &xmss_keyring_find(&ring, ids[i])->params);
+    free(ids);
+    free(sigs);
+    free(results);
+    xmss_keyring_close(&ring);
+    return !failed && made == count && count > 0 ? 0 : 1;
+}
+
+// Sign several messages at consecutive leaves of the existing key and save them as one batch
+static int mode_batch_sign(const char *path, const char *const *msgs, int count) {
+    xmss_params params;
+    xmss_node_cache cache = {0};
+    XMSSKey *key = xmss_key_alloc();
+    if (!key) {
+        fprintf(stderr, "Failed to allocate XMSS key\n");
+        return 1;
+    }
+    if (xmss_load_key(key, &params) != 1) {
+        fprintf(stderr, "Missing or invalid %s; sign once with -e to create a key.\n", XMSS_KEY_FILE);
+        xmss_key_free(key);
+        return 1;
+    }
+
+    // All signatures must come from this key, so the batch may not run into a key rotation
+    int next_index;
+    if (xmss_load_state(&next_index) < 0) {
+        fprintf(stderr, "Error reading XMSS state file\n");
+        xmss_key_free(key);
+        return 1;
+    }
+    uint64_t first = (uint64_t)next_index < params.act_start ? params.act_start : (uint64_t)next_index;
+    uint64_t end = params.act_start + params.act_count;
+    if (first > end || end - first < (uint64_t)count) {
+        fprintf(stderr, "ERROR: Only %llu unused leaves left; a batch cannot span a key rotation.\n",
+                (unsigned long long)(first > end ? 0 : end - first));
+        xmss_key_free(key);
+        return 1;
+    }
+    if (xmss_cache_load(XMSS_CACHE_FILE, &cache, &params) == 1) xmss_cache_use(&cache);
+
+    XMSSSignature *sigs = calloc((size_t)count, sizeof(XMSSSignature));
+    XMSSSignature **order = calloc((size_t)count, sizeof(XMSSSignature *));
+    int allocated = 0, failed = !sigs || !order;
+    for (; !failed && allocated < count; allocated++) {
+        order[allocated] = &sigs[allocated];
+        if (xmss_alloc_sig(&sigs[allocated], &params) != 0 ||
+            xmss_sign_auto(&params, (const uint8_t*)msgs[allocated], key, &sigs[allocated], NULL) != 0) {
+            failed = 1;
+        }
+    }
+
+    // Consecutive leaves are in increasing order, so the auth paths merge into one multi-proof
+    xmss_sigbatch batch = {0};
+    if (!failed && xmss_sigbatch_build(&params, &batch, order, count) != 0) failed = 1;
+    if (!failed && xmss_sigbatch_save(path, &batch, &params) != 0) {
+        fprintf(stderr, "Failed to save %s\n", path);
+        failed = 1;
+    }
+    if (!failed && !save_root(key->root, params.n, params.hash_mode == XMSS_HASH_TWEAKED ? key->pub_seed : NULL)) {
+        fprintf(stderr, "Failed to save root hex\n");
+        failed = 1;
+    }
+    if (!failed) {
+        printf("Signed %d message(s) at leaves [%d, %d]\n", count, sigs[0].index, sigs[count - 1].index);
+        printf("Multi-proof: %d node(s) instead of %d\n", batch.proof_nodes, count * params.h);
+        printf("Batch size: %zu bytes (%zu bytes as separate signatures) -> %s\n",
+               xmss_sigbatch_size(&params, count, batch.proof_nodes), (size_t)count * xmss_eth_sig_size(&params), path);
+    }
+
+    xmss_sigbatch_free(&batch, &params);
+    for (int i = 0; i < allocated; i++) xmss_free_sig(&sigs[i], &params);
+    free(sigs);
+    free(order);
+    xmss_cache_free(&cache);
+    xmss_key_free(key);
+    return failed ? 1 : 0;
+}
+
+// Verify a signature batch against root.hex
+static int mode_batch_verify(const char *path, const char *const *msgs, int count) {
+    uint8_t root[HASH_SIZE];
+    size_t root_len = 0;
+    uint8_t pub_seed[XMSS_PUB_SEED_BYTES] = {0};
+    bool has_pub_seed = false;
+    if (!load_root(root, &root_len, pub_seed, &has_pub_seed)) {
+        fprintf(stderr, "Missing root.hex\n");
+        return 1;
+    }
+
+    xmss_params params;
+    xmss_sigbatch batch;
+    if (xmss_sigbatch_load(path, &batch, &params) != 1) {
+        fprintf(stderr, "Missing or invalid %s\n", path);
+        return 1;
+    }
+    printf("Loaded batch of %d signature(s) (h=%d, w=%d, n=%d, encoding=%s, hash=%s, proof nodes=%d)\n",
+           batch.count, params.h, params.w, params.n, encoding_name(params.encoding), params.hash->name,
+           batch.proof_nodes);
+
+    int ok = 0;
+    if (batch.count != count) {
+        fprintf(stderr, "The batch holds %d signature(s) but %d message(s) were given\n", batch.count, count);
+    } else if (root_len != (size_t)params.n) {
+        fprintf(stderr, "Root length in %s (%zu bytes) does not match the batch (n=%d)\n", ROOT_FILE, root_len, params.n);
+    } else if (params.hash_mode == XMSS_HASH_TWEAKED && !has_pub_seed) {
+        fprintf(stderr, "Missing public seed in %s for a tweaked-hash batch\n", ROOT_FILE);
+    } else {
+        ok = xmss_sigbatch_verify(&params, (const uint8_t *const *)msgs, &batch, root, pub_seed);
+        printf(ok ? "Verification SUCCESS\n" : "Verification FAILED\n");
+    }
+    xmss_sigbatch_free(&batch, &params);
     return ok ? 0 : 1;
 }
 
+// Parse a validator id
+static bool parse_validator_id(const char *s, uint32_t *id) {
+    char *end;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (*s == '\0' || *s == '-' || *end != '\0' || v >= UINT32_MAX) return false;
+    *id = (uint32_t)v;
+    return true;
+}
+
 // Usage instructions
 static void print_usage(const char *prog) {
     printf("Usage: %s [mode] [parameters] [options]\n", prog);
@@ -189,6 +607,13 @@ static void print_usage(const char *prog) {
     printf("  -e \"message\"     # Sign a message\n");
     printf("  -v \"message\"     # Verify a message\n");
     printf("  -b [k s v]         # Benchmark (defaults: k=100, s=1000, v=1000)\n");
+    printf("  --keygen-shard <i>/<N>  # Compute shard i of N of a new key from %s\n", XMSS_SEED_FILE);
+    printf("  --keygen-merge <f...>   # Merge shard files into xmss_key.bin\n");
+    printf("  --registry-add <f> <id>    # Register the key in xmss_key.bin as validator id in registry f\n");
+    printf("  --registry-remove <f> <id> # Remove validator id from registry f\n");
+    printf("  --keyring-add <dir> <id>   # Generate key id in keyring directory dir\n");
+    printf("  --batch-sign <f> <msg...>   # Sign each message with xmss_key.bin and save one batch with a shared multi-proof\n");
+    printf("  --batch-verify <f> <msg...> # Verify a signature batch against %s\n", ROOT_FILE);
     printf("\nBenchmarking Options:\n");
     printf("  [k]                # Number of key generations\n");
     printf("  [s]                # Number of sign operations\n");
@@ -197,7 +622,24 @@ static void print_usage(const char *prog) {
     printf("  --height <h>       Set XMSS Merkle tree height (Default=5)\n");
     printf("  --wots <w>         Set WOTS+ Winternitz parameter (Default=8, must be to the (Default=5)power of 2)\n");
     printf("  --seed N           Use deterministic RNG seed\n");
+    printf("  --activation <s> <c>  Only activate leaves/epochs [s, s+c) of a new key (Default=all)\n");
+    printf("  --epoch <e>        Sign for epoch (leaf index) e instead of the next unused leaf\n");
+    printf("  --encoding <e>     WOTS+ encoding: checksum or target-sum (Default=checksum)\n");
+    printf("  --target-sum <T>   Digit sum for the target-sum encoding (Default=mean + one std. deviation)\n");
+    printf("  --hash-len <n>     Hash output length in bytes: 16, 24 or 32 (Default=32)\n");
+    printf("  --hash-mode <m>    Chain/tree hashing: plain or tweaked (RFC 8391 F, RAND_HASH and L-tree; Default=plain)\n");
+    printf("  --hash <b>         Hash backend of a new key: shake256, poseidon2 (SNARK-friendly) or sha256 (SHA-NI, Default=shake256)\n");
+    printf("  --checkpoint <l>   Checkpoint key generation to %s every l leaves; rerun to resume\n", XMSS_PROGRESS_FILE);
+    printf("  --threads <t>      Spread the chains and auth path of one signature over t threads (0 = all cores, Default=1)\n");
+    printf("  --pregen <f>       Pre-generate the next key once a fraction f of the leaves is used; that run waits for it\n");
+    printf("                     before exiting (Default=off)\n");
     printf("  --export-snark     <filename.json>    Export snark data to specified JSON file (optional)\n");
+    printf("  --export-snark-ndjson <filename>      Stream the SNARK witness as NDJSON (optional)\n");
+    printf("  --export-snark-bin <filename>         Write the SNARK witness in the binary layout (optional)\n");
+    printf("  --snark-field <f>  Pack binary witness values for raw, bn254, goldilocks or babybear (Default=raw)\n");
+    printf("  --registry <f> <id>  With -v, verify against validator id in registry f instead of %s\n", ROOT_FILE);
+    printf("  --keyring <dir>    With -e, sign under every key of keyring dir (signatures go to dir/sig_<id>.bin)\n");
+    printf("  --key-id <id>      With --keyring, sign under key id only\n");
 
 }
 
@@ -207,11 +649,31 @@ int main(int argc, char *argv[]) {
     bool seed_set = false;
     const char *sign_msg = NULL;
     const char *snark_outfile = NULL;
+    const char *ndjson_outfile = NULL;
+    const char *bin_outfile = NULL;
+    int snark_field = SNARK_FIELD_RAW;
     char *mode = NULL, *message = NULL;
+    int shard = 0, shards = 0;
+    const char **merge_paths = NULL;
+    int merge_count = 0;
+    const char *batch_path = NULL;
+    const char **batch_msgs = NULL;
+    int batch_count = 0;
+    const char *registry_path = NULL;
+    uint32_t registry_id = 0;
+    const char *keyring_dir = NULL;
+    bool key_id_set = false;
+    uint32_t key_id = 0;
 
     // Default parameters
     int h = 5, w = 8;
     int k = 10, s = 100, v = 100;
+    uint64_t act_start = 0, act_count = 0;
+    int encoding = WOTS_ENCODING_CHECKSUM, target_sum = 0;
+    int hash_mode = XMSS_HASH_PLAIN;
+    int hash_backend = HASH_BACKEND_SHAKE256;
+    int hash_len = HASH_SIZE;
+    int threads = 1;
 
     // Check for mode flags and parameters
     for (int i = 1; i < argc; i++) {
@@ -231,6 +693,83 @@ int main(int argc, char *argv[]) {
             if (i + 1 < argc) s = atoi(argv[++i]);
             if (i + 1 < argc) v = atoi(argv[++i]);
 
+        // Distributed keygen: one shard of the leaf range
+        } else if (strcmp(argv[i], "--keygen-shard") == 0 && i + 1 < argc) {
+            mode = "--keygen-shard";
+            if (sscanf(argv[++i], "%d/%d", &shard, &shards) != 2 || shards <= 0 || shard < 0 || shard >= shards) {
+                fprintf(stderr, "Error: --keygen-shard expects <i>/<N> with 0 <= i < N.\n");
+                return 1;
+            }
+
+        // Distributed keygen: merge shard files (all arguments up to the next option)
+        } else if (strcmp(argv[i], "--keygen-merge") == 0 && i + 1 < argc) {
+            mode = "--keygen-merge";
+            merge_paths = (const char **)&argv[i + 1];
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                merge_count++;
+                i++;
+            }
+
+        // Signature batches: the file, then all arguments up to the next option as messages
+        } else if ((strcmp(argv[i], "--batch-sign") == 0 || strcmp(argv[i], "--batch-verify") == 0) &&
+                   i + 2 < argc) {
+            mode = argv[i];
+            batch_path = argv[++i];
+            batch_msgs = (const char **)&argv[i + 1];
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                batch_count++;
+                i++;
+            }
+            if (batch_count == 0) {
+                fprintf(stderr, "Error: %s expects a file and at least one message.\n", mode);
+                return 1;
+            }
+
+        // Validator registry updates
+        } else if ((strcmp(argv[i], "--registry-add") == 0 || strcmp(argv[i], "--registry-remove") == 0) &&
+                   i + 2 < argc) {
+            mode = argv[i];
+            registry_path = argv[++i];
+            if (!parse_validator_id(argv[++i], &registry_id)) {
+                fprintf(stderr, "Error: %s expects a validator id below %u.\n", mode, UINT32_MAX);
+                return 1;
+            }
+
+        // Keyring updates
+        } else if (strcmp(argv[i], "--keyring-add") == 0 && i + 2 < argc) {
+            mode = "--keyring-add";
+            keyring_dir = argv[++i];
+            if (!parse_validator_id(argv[++i], &key_id)) {
+                fprintf(stderr, "Error: --keyring-add expects a key id below %u.\n", UINT32_MAX);
+                return 1;
+            }
+
+        // Sign with keyring keys
+        } else if (strcmp(argv[i], "--keyring") == 0 && i + 1 < argc) {
+            if (mode == NULL || strcmp(mode, "-e") != 0) {
+                fprintf(stderr, "--keyring is only allowed with -e\n");
+                return 1;
+            }
+            keyring_dir = argv[++i];
+        } else if (strcmp(argv[i], "--key-id") == 0 && i + 1 < argc) {
+            if (!parse_validator_id(argv[++i], &key_id)) {
+                fprintf(stderr, "Error: --key-id expects a key id below %u.\n", UINT32_MAX);
+                return 1;
+            }
+            key_id_set = true;
+
+        // Verify against a registry entry
+        } else if (strcmp(argv[i], "--registry") == 0 && i + 2 < argc) {
+            if (mode == NULL || strcmp(mode, "-v") != 0) {
+                fprintf(stderr, "--registry is only allowed with -v\n");
+                return 1;
+            }
+            registry_path = argv[++i];
+            if (!parse_validator_id(argv[++i], &registry_id)) {
+                fprintf(stderr, "Error: --registry expects a validator id below %u.\n", UINT32_MAX);
+                return 1;
+            }
+
         // Input validation for height parameter
         } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
             h = atoi(argv[++i]);
@@ -247,15 +786,106 @@ int main(int argc, char *argv[]) {
                 return 1;
             }
 
+        // Activation window for new keys
+        } else if (strcmp(argv[i], "--activation") == 0 && i + 2 < argc) {
+            act_start = strtoull(argv[++i], NULL, 10);
+            act_count = strtoull(argv[++i], NULL, 10);
+            if (act_count == 0) {
+                fprintf(stderr, "Error: --activation count must be a positive integer.\n");
+                return 1;
+            }
+            g_activation_set = true;
+
+        // WOTS+ encoding selection
+        } else if (strcmp(argv[i], "--encoding") == 0 && i + 1 < argc) {
+            const char *enc = argv[++i];
+            if (strcmp(enc, "checksum") == 0) {
+                encoding = WOTS_ENCODING_CHECKSUM;
+            } else if (strcmp(enc, "target-sum") == 0) {
+                encoding = WOTS_ENCODING_TARGET_SUM;
+            } else {
+                fprintf(stderr, "Error: --encoding must be 'checksum' or 'target-sum'.\n");
+                return 1;
+            }
+
+        // Target digit sum for the target-sum encoding
+        } else if (strcmp(argv[i], "--target-sum") == 0 && i + 1 < argc) {
+            target_sum = atoi(argv[++i]);
+            if (target_sum <= 0) {
+                fprintf(stderr, "Error: --target-sum must be a positive integer.\n");
+                return 1;
+            }
+
+        // Hash output length
+        } else if (strcmp(argv[i], "--hash-len") == 0 && i + 1 < argc) {
+            hash_len = atoi(argv[++i]);
+
+        // Hash mode selection
+        } else if (strcmp(argv[i], "--hash-mode") == 0 && i + 1 < argc) {
+            const char *hm = argv[++i];
+            if (strcmp(hm, "plain") == 0) {
+                hash_mode = XMSS_HASH_PLAIN;
+            } else if (strcmp(hm, "tweaked") == 0) {
+                hash_mode = XMSS_HASH_TWEAKED;
+            } else {
+                fprintf(stderr, "Error: --hash-mode must be 'plain' or 'tweaked'.\n");
+                return 1;
+            }
+
+        // Hash backend selection
+        } else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            hash_backend = hash_backend_from_name(argv[++i]);
+            if (hash_backend < 0) {
+                fprintf(stderr, "Error: --hash must be 'shake256', 'poseidon2' or 'sha256'.\n");
+                return 1;
+            }
+
+        // Explicit epoch to sign for
+        } else if (strcmp(argv[i], "--epoch") == 0 && i + 1 < argc) {
+            if (mode == NULL || strcmp(mode, "-e") != 0) {
+                fprintf(stderr, "--epoch is only allowed with -e\n");
+                return 1;
+            }
+            g_epoch = strtoull(argv[++i], NULL, 10);
+            g_epoch_set = true;
+
         // Check if a seed is provided
         } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
-            if (mode == NULL || strcmp(mode, "-e") != 0) {
-                fprintf(stderr, "--seed is only allowed with -e\n");
+            if (mode == NULL || (strcmp(mode, "-e") != 0 && strcmp(mode, "--keygen-shard") != 0)) {
+                fprintf(stderr, "--seed is only allowed with -e or --keygen-shard\n");
                 return 1;
             }
             custom_seed = strtoull(argv[++i], NULL, 10);
             seed_set = true;
 
+        // Checkpointed key generation
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            g_checkpoint = strtoull(argv[++i], NULL, 10);
+            if (g_checkpoint == 0) {
+                fprintf(stderr, "Error: --checkpoint must be a positive number of leaves.\n");
+                return 1;
+            }
+
+        // Intra-signature parallelism
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads < 0) {
+                fprintf(stderr, "Error: --threads must be 0 (all cores) or a positive integer.\n");
+                return 1;
+            }
+
+        // Background pre-generation of the next key
+        } else if (strcmp(argv[i], "--pregen") == 0 && i + 1 < argc) {
+            if (mode == NULL || strcmp(mode, "-e") != 0) {
+                fprintf(stderr, "--pregen is only allowed with -e\n");
+                return 1;
+            }
+            double threshold = atof(argv[++i]);
+            if (threshold <= 0.0 || xmss_pregen_enable(threshold) != 0) {
+                fprintf(stderr, "Error: --pregen must be a fraction in (0, 1].\n");
+                return 1;
+            }
+
         // Check if snark export is required
         } else if (strcmp(argv[i], "--export-snark") == 0 && i + 1 < argc) {
             if (mode == NULL || strcmp(mode, "-e") != 0) {
@@ -264,6 +894,30 @@ int main(int argc, char *argv[]) {
             }
             snark_outfile = argv[++i];
 
+        // Check if streaming snark export is required
+        } else if (strcmp(argv[i], "--export-snark-ndjson") == 0 && i + 1 < argc) {
+            if (mode == NULL || strcmp(mode, "-e") != 0) {
+                fprintf(stderr, "--export-snark-ndjson is only allowed with -e\n");
+                return 1;
+            }
+            ndjson_outfile = argv[++i];
+
+        // Check if binary snark export is required
+        } else if (strcmp(argv[i], "--export-snark-bin") == 0 && i + 1 < argc) {
+            if (mode == NULL || strcmp(mode, "-e") != 0) {
+                fprintf(stderr, "--export-snark-bin is only allowed with -e\n");
+                return 1;
+            }
+            bin_outfile = argv[++i];
+
+        // Field for the binary witness
+        } else if (strcmp(argv[i], "--snark-field") == 0 && i + 1 < argc) {
+            snark_field = snark_field_from_name(argv[++i]);
+            if (snark_field < 0) {
+                fprintf(stderr, "Error: --snark-field must be raw, bn254, goldilocks or babybear.\n");
+                return 1;
+            }
+
         // If input is invalid, print usage
         } else {
             print_usage(argv[0]);
@@ -277,6 +931,19 @@ int main(int argc, char *argv[]) {
     if (xmss_params_init(&g_params, h, w) != 0) {
         return -1;
     }
+    if (g_activation_set && xmss_params_set_activation(&g_params, act_start, act_count) != 0) {
+        return -1;
+    }
+    if (target_sum != 0 && encoding != WOTS_ENCODING_TARGET_SUM) {
+        fprintf(stderr, "Error: --target-sum requires --encoding target-sum.\n");
+        return 1;
+    }
+    if (xmss_params_set_n(&g_params, hash_len) != 0 ||
+        xmss_params_set_encoding(&g_params, encoding, target_sum) != 0 ||
+        xmss_params_set_hash_mode(&g_params, hash_mode) != 0 ||
+        xmss_params_set_hash_backend(&g_params, hash_backend) != 0) {
+        return -1;
+    }
     
     // Ensure a mode is selected
     if (!mode) {
@@ -290,6 +957,12 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // Start the worker pool (the calling thread is one of the t threads)
+    if (threads != 1) {
+        xmss_parallel_start(threads == 0 ? 0 : threads - 1);
+        atexit(xmss_parallel_stop);
+    }
+
     // Initialize PRF
     if (seed_set) {
         printf("[CSPRNG] Using deterministic seed: %llu\n", (unsigned long long)custom_seed);
@@ -298,13 +971,45 @@ int main(int argc, char *argv[]) {
         csprng_init(NULL, NULL);
     }
     
+    // The keyring signs its own keys and writes one signature per key
+    if (key_id_set && !keyring_dir) {
+        fprintf(stderr, "Error: --key-id requires --keyring.\n");
+        return 1;
+    }
+    if (keyring_dir && strcmp(mode, "-e") == 0 && (snark_outfile || ndjson_outfile || bin_outfile || g_epoch_set)) {
+        fprintf(stderr, "Error: --keyring signs at each key's next leaf and does not export SNARK witnesses.\n");
+        return 1;
+    }
+
     // Signing mode
-    if (strcmp(mode, "-e") == 0) {
+    if (strcmp(mode, "-e") == 0 && keyring_dir) {
+        return mode_keyring_sign(keyring_dir, sign_msg, key_id_set, key_id);
+    } else if (strcmp(mode, "-e") == 0) {
         if (mode_sign(sign_msg) != 0) {
             fprintf(stderr, "Signing failed.\n");
             return 1;
         }
     
+    // Distributed keygen modes
+    } else if (strcmp(mode, "--keygen-shard") == 0) {
+        return mode_keygen_shard(shard, shards);
+    } else if (strcmp(mode, "--keygen-merge") == 0) {
+        return mode_keygen_merge(merge_paths, merge_count);
+
+    // Keyring key generation
+    } else if (strcmp(mode, "--keyring-add") == 0) {
+        return mode_keyring_add(keyring_dir, key_id);
+
+    // Signature batch modes
+    } else if (strcmp(mode, "--batch-sign") == 0) {
+        return mode_batch_sign(batch_path, batch_msgs, batch_count);
+    } else if (strcmp(mode, "--batch-verify") == 0) {
+        return mode_batch_verify(batch_path, batch_msgs, batch_count);
+
+    // Validator registry modes
+    } else if (strcmp(mode, "--registry-add") == 0 || strcmp(mode, "--registry-remove") == 0) {
+        return mode_registry_update(registry_path, registry_id, strcmp(mode, "--registry-remove") == 0);
+
     // Benchmarking mode
     } else if (strcmp(mode, "-b") == 0) {
         run_benchmark(&g_params, k, s, v);
@@ -312,7 +1017,7 @@ int main(int argc, char *argv[]) {
     
     // Verification mode
     } else if (strcmp(mode, "-v") == 0) {
-        return mode_verify(message);
+        return mode_verify(message, registry_path, registry_id);
     
     // Throw an error if the mode is not recognized
     } else {
@@ -325,11 +1030,35 @@ int main(int argc, char *argv[]) {
         printf("Exporting SNARK data to %s\n", snark_outfile);
         
         // Throw an error if exporting SNARK fails
-        if (export_snark_json(snark_outfile, (const uint8_t*)sign_msg, strlen(sign_msg), h, w) != 0) { 
+        if (export_snark_json(snark_outfile, (const uint8_t*)sign_msg, strlen(sign_msg), &g_params) != 0) { 
             fprintf(stderr, "Failed to export SNARK data.\n");
             return 1;
         }
     }
 
+    // Stream the SNARK witness if requested
+    if (ndjson_outfile) {
+        printf("Streaming SNARK witness to %s\n", ndjson_outfile);
+        snark_witness item = { (const uint8_t*)sign_msg, strlen(sign_msg), &global_last_signature, global_last_root,
+                               global_pub_seed, -1 };
+        if (export_snark_ndjson(ndjson_outfile, &g_params, &item, 1) != 0) {
+            fprintf(stderr, "Failed to export SNARK witness.\n");
+            return 1;
+        }
+    }
+
+    // Write the binary SNARK witness if requested
+    if (bin_outfile) {
+        printf("Writing binary SNARK witness to %s\n", bin_outfile);
+        snark_witness item = { (const uint8_t*)sign_msg, strlen(sign_msg), &global_last_signature, global_last_root,
+                               global_pub_seed, -1 };
+        if (export_snark_bin(bin_outfile, &g_params, snark_field, &item, 1) != 0) {
+            fprintf(stderr, "Failed to export binary SNARK witness.\n");
+            return 1;
+        }
+    }
+
+    if (strcmp(mode, "-e") == 0) xmss_free_sig(&global_last_signature, &g_params);
+
     return 0;
 }
\ No newline at end of file
@@ -13,6 +13,8 @@
 #include "hash.h"
 #include "xmss_config.h"
 #include "xmss_eth.h"
+#include "xmss_precomp.h"
+#include "xmss_vcache.h"
 
 /* Human readable size helper */
 static void human_size(double bytes, char *out, size_t outlen) {
@@ -25,13 +27,15 @@ static void human_size(double bytes, char *out, size_t outlen) {
 
 // Run the benchmark for key generation, signing, and verification.
 void run_benchmark(const xmss_params *params, int keygen_runs, int sign_runs, int verify_runs) {
-    printf("Benchmarking (h=%d, w=%d), this will take some time...\n", params->h, params->w);
+    const char *encoding = (params->encoding == WOTS_ENCODING_TARGET_SUM) ? "target-sum" : "checksum";
+    printf("Benchmarking (h=%d, w=%d, encoding=%s, hash=%s/%s), this will take some time...\n", params->h, params->w,
+           encoding, params->hash->name, hash_backend_implementation(params->hash));
 
     // Initialize key and signature structures
     XMSSKey key;
     size_t key_size  = sizeof(XMSSKey);
     size_t sig_size  = xmss_eth_sig_size(params);
-    size_t root_size = HASH_SIZE;
+    size_t root_size = params->n;
 
     // Initialize testing parameters
     const char *msg = "benchmark message";
@@ -51,30 +55,63 @@ void run_benchmark(const xmss_params *params, int keygen_runs, int sign_runs, in
     XMSSSignature sig_sign;
     if (xmss_alloc_sig(&sig_sign, params) != 0) { fprintf(stderr, "Benchmark failed to alloc sig\n"); return; }
     for (int i = 0; i < sign_runs; i++) {
-        int idx = i % params->max_keys;
+        int idx = (int)(params->act_start + i % params->act_count);
         start = hires_time_seconds();
         xmss_sign_index(params, (const uint8_t*)msg, &key, &sig_sign, idx);
         end = hires_time_seconds();
         sign_total += (end - start);
     }
     double sign_avg = sign_total / sign_runs;
+
+    // ONLINE SIGN benchmark: leaves are prepared offline (untimed), only the online step is timed
+    double online_total = 0.0, online_avg = 0.0;
+    xmss_precomp_pool pool;
+    int online_runs = (uint64_t)sign_runs < params->act_count ? sign_runs : (int)params->act_count;
+    if (online_runs > 0 && xmss_precomp_init(&pool, params, XMSS_PRECOMP_DEFAULT) == 0) {
+        for (int i = 0; i < online_runs; i++) {
+            uint64_t idx = params->act_start + i;
+            if (xmss_precomp_fill(&pool, params, &key, idx) <= 0) break;
+            start = hires_time_seconds();
+            xmss_precomp_sign(&pool, params, (const uint8_t*)msg, &key, &sig_sign, idx);
+            end = hires_time_seconds();
+            online_total += (end - start);
+        }
+        online_avg = online_total / online_runs;
+        xmss_precomp_free(&pool, params);
+    }
     xmss_free_sig(&sig_sign, params);
 
 
     // VERIFY benchmark
-    double verify_avg = 0.0;
+    double verify_avg = 0.0, cached_verify_avg = 0.0;
+    uint64_t cache_hits = 0;
     if (verify_runs > 0) {
         XMSSSignature sig_verify;
         if (xmss_alloc_sig(&sig_verify, params) != 0) { fprintf(stderr, "Benchmark failed to alloc sig\n"); return; }
         for (int i = 0; i < verify_runs; i++) {
-            int idx = i % params->max_keys;
+            int idx = (int)(params->act_start + i % params->act_count);
             xmss_sign_index(params, (const uint8_t*)msg, &key, &sig_verify, idx);
             start = hires_time_seconds();
-            xmss_verify(params, (const uint8_t*)msg, &sig_verify, key.root);
+            xmss_verify(params, (const uint8_t*)msg, &sig_verify, key.root, key.pub_seed);
             end = hires_time_seconds();
             verify_total += (end - start);
         }
         verify_avg = verify_total / verify_runs;
+
+        // Duplicate verifications of the last signature are answered by the verified-signature cache
+        xmss_verify_cache vcache;
+        if (xmss_vcache_init(&vcache, XMSS_VCACHE_DEFAULT) == 0) {
+            xmss_vcache_use(&vcache);
+            xmss_verify(params, (const uint8_t*)msg, &sig_verify, key.root, key.pub_seed);
+            start = hires_time_seconds();
+            for (int i = 0; i < verify_runs; i++) {
+                xmss_verify(params, (const uint8_t*)msg, &sig_verify, key.root, key.pub_seed);
+            }
+            end = hires_time_seconds();
+            cached_verify_avg = (end - start) / verify_runs;
+            xmss_vcache_stats(&vcache, &cache_hits, NULL);
+            xmss_vcache_free(&vcache);
+        }
         xmss_free_sig(&sig_verify, params);
     }
 
@@ -85,14 +122,17 @@ void run_benchmark(const xmss_params *params, int keygen_runs, int sign_runs, in
     human_size((double)root_size, root_hr, sizeof root_hr);
 
     // Print the benchmark results
-    printf("\n===== Benchmark (h=%d, w=%d, Averaged) =====\n", params->h, params->w);
+    printf("\n===== Benchmark (h=%d, w=%d, %s, %s, Averaged) =====\n", params->h, params->w, encoding, params->hash->name);
     printf("Keygen runs : %d\n", keygen_runs);
     printf("Sign runs   : %d\n", sign_runs);
     printf("Verify runs : %d\n", verify_runs);
     printf("--------------------------------\n");
     printf("Keygen avg  : %.9f s\n", keygen_avg);
     printf("Sign avg    : %.9f s\n", sign_avg);
+    printf("Online sign : %.9f s (precomputed leaves)\n", online_avg);
     printf("Verify avg  : %.9f s\n", verify_avg);
+    printf("Dup. verify : %.9f s (verified-signature cache, %llu hits)\n", cached_verify_avg,
+           (unsigned long long)cache_hits);
     printf("--------------------------------\n");
     printf("Key size    : %zu (%s)\n", key_size, key_hr);
     printf("Sig size    : %zu (%s)\n", sig_size, sig_hr);
@@ -118,18 +158,18 @@ void run_benchmark(const xmss_params *params, int keygen_runs, int sign_runs, in
         fprintf(csv,
             "timestamp,h,w,keygen_runs,sign_runs,verify_runs,"
             "keygen_avg_s,sign_avg_s,verify_avg_s,"
-            "key_size_bytes,sig_size_bytes,root_size_bytes\n");
+            "key_size_bytes,sig_size_bytes,root_size_bytes,encoding,online_sign_avg_s,cached_verify_avg_s,hash\n");
     }
 
     // Write the benchmark results
     time_t t = time(NULL);
     fprintf(csv,
-        "%lld,%d,%d,%d,%d,%d,%.9f,%.9f,%.9f,%zu,%zu,%zu\n",
+        "%lld,%d,%d,%d,%d,%d,%.9f,%.9f,%.9f,%zu,%zu,%zu,%s,%.9f,%.9f,%s\n",
         (long long)t,
         params->h, params->w,
         keygen_runs, sign_runs, verify_runs,
         keygen_avg, sign_avg, verify_avg,
-        key_size, sig_size, root_size
+        key_size, sig_size, root_size, encoding, online_avg, cached_verify_avg, params->hash->name
     );
 
     // Close the CSV file
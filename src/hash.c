@@ -2,21 +2,65 @@
 #include <stdio.h>
 
 // import project-specific headers
+#include <string.h>
 #include "hash.h"
+#include "poseidon2.h"
+#include "sha256.h"
 #include <openssl/evp.h>
 
+// Per-thread SHAKE256 context, re-initialised for every call instead of allocated
+static _Thread_local EVP_MD_CTX *shake_ctx;
+
 // Hash function using SHAKE256
 // This function takes an input buffer and produces a variable-length output
-void hash_shake256(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen) {
-    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-    if (!ctx) {
+int hash_shake256(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen) {
+    if (!shake_ctx) shake_ctx = EVP_MD_CTX_new();
+    if (!shake_ctx) {
         fprintf(stderr, "hash_shake256: EVP_MD_CTX_new failed\n");
-        return;
+        memset(out, 0, outlen);
+        return -1;
     }
-    if (EVP_DigestInit_ex(ctx, EVP_shake256(), NULL) != 1 ||
-        EVP_DigestUpdate(ctx, in, inlen) != 1 ||
-        EVP_DigestFinalXOF(ctx, out, outlen) != 1) {
+    if (EVP_DigestInit_ex(shake_ctx, EVP_shake256(), NULL) != 1 ||
+        EVP_DigestUpdate(shake_ctx, in, inlen) != 1 ||
+        EVP_DigestFinalXOF(shake_ctx, out, outlen) != 1) {
         fprintf(stderr, "hash_shake256: SHAKE256 hashing failed\n");
+        // Never hand back a partial digest
+        memset(out, 0, outlen);
+        return -1;
     }
-    EVP_MD_CTX_free(ctx);
+    return 0;
+}
+
+// Free the calling thread's SHAKE256 and SHA-256 contexts
+void hash_release_thread_state(void) {
+    EVP_MD_CTX_free(shake_ctx);
+    shake_ctx = NULL;
+    sha256_release_thread_state();
+}
+
+// Backend table, indexed by id
+static const hash_backend backends[] = {
+    { HASH_BACKEND_SHAKE256,  "shake256",  hash_shake256  },
+    { HASH_BACKEND_POSEIDON2, "poseidon2", poseidon2_hash },
+    { HASH_BACKEND_SHA256,    "sha256",    sha256_hash    },
+};
+
+// Look up a backend by id
+const hash_backend *hash_backend_get(int id) {
+    if (id < 0 || id >= (int)(sizeof(backends) / sizeof(backends[0]))) return NULL;
+    return &backends[id];
+}
+
+// Look up a backend id by name
+int hash_backend_from_name(const char *name) {
+    for (int i = 0; i < (int)(sizeof(backends) / sizeof(backends[0])); i++) {
+        if (strcmp(name, backends[i].name) == 0) return backends[i].id;
+    }
+    return -1;
+}
+
+// Name of the implementation behind a backend
+const char *hash_backend_implementation(const hash_backend *backend) {
+    if (backend->id == HASH_BACKEND_SHA256) return sha256_implementation();
+    return backend->id == HASH_BACKEND_SHAKE256 ? "openssl" : "portable";
 }
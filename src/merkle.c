@@ -1,82 +1,268 @@
 // import standard libraries
+#include <stdlib.h>
 #include <string.h>
 
 // import project-specific headers
 #include "merkle.h"
 #include "hash.h"
+#include "thash.h"
+#include "xmss_parallel.h"
 
-// Compute Merkle root from an array of leaves
-void merkle_compute_root(const uint8_t leaves[][HASH_SIZE], int num_leaves, uint8_t root[HASH_SIZE]) {
+// Levels with at least this many parents are split across the worker pool
+#define MERKLE_PARALLEL_PARENTS 4096
+
+// Parents per pool item
+#define MERKLE_CHUNK_PARENTS 1024
+
+// Number of nodes of the level above a level of count nodes (an odd last node is carried up)
+static uint64_t parent_count(uint64_t count) {
+    return (count + 1) / 2;
+}
+
+// Height of a tree over num_leaves leaves
+int merkle_height(uint64_t num_leaves) {
+    int height = 0;
+    while (height < 64 && (1ULL << height) < num_leaves) height++;
+    return height;
+}
+
+// Workspace: the two levels above the leaves, used alternately for all higher levels
+size_t merkle_workspace_bytes(const xmss_params *params, uint64_t num_leaves) {
+    uint64_t first = parent_count(num_leaves);
+    return (size_t)(first + parent_count(first)) * params->n;
+}
+
+// One level reduction
+typedef struct {
+    const xmss_params *params;
+    const uint8_t *pub_seed;
+    int height;              // Height of the parents
+    const uint8_t *level;
+    uint64_t pairs;
+    uint8_t *parents;
+    int failed;
+} merkle_level_job;
+
+// Hash the sibling pairs [first, first + count) of a level; returns nonzero if a hash failed
+static int merkle_hash_pairs(const merkle_level_job *job, uint64_t first, uint64_t count) {
+    size_t n = job->params->n;
+    int failed = 0;
+    for (uint64_t i = first; i < first + count; i++) {
+        failed |= thash_node(job->params, job->pub_seed, job->height, i, job->level + 2 * i * n,
+                             job->level + (2 * i + 1) * n, job->parents + i * n);
+    }
+    return failed;
+}
+
+// Hash one chunk of a level on a pool worker
+static void merkle_level_item(void *ctx, int i) {
+    merkle_level_job *job = ctx;
+    uint64_t first = (uint64_t)i * MERKLE_CHUNK_PARENTS;
+    uint64_t count = job->pairs - first < MERKLE_CHUNK_PARENTS ? job->pairs - first : MERKLE_CHUNK_PARENTS;
+    if (merkle_hash_pairs(job, first, count)) __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+}
+
+// Hash a level of count nodes into the parents at the given height
+static int merkle_reduce_level(const xmss_params *params, const uint8_t *pub_seed, int height,
+                               const uint8_t *level, uint64_t count, uint8_t *parents) {
+    size_t n = params->n;
+    merkle_level_job job = { params, pub_seed, height, level, count / 2, parents, 0 };
+    if (job.pairs >= MERKLE_PARALLEL_PARENTS) {
+        int chunks = (int)((job.pairs + MERKLE_CHUNK_PARENTS - 1) / MERKLE_CHUNK_PARENTS);
+        xmss_parallel_for(chunks, (long)job.pairs, merkle_level_item, &job);
+    } else if (merkle_hash_pairs(&job, 0, job.pairs)) {
+        job.failed = 1;
+    }
+    // An odd last node has no sibling; it moves up unchanged
+    if (count & 1) memmove(parents + job.pairs * n, level + (count - 1) * n, n);
+    return job.failed ? -1 : 0;
+}
+
+// Level-by-level reduction shared by root and auth path computation. The leaves are only read;
+// the levels above them alternate between the two halves of the workspace.
+static int merkle_reduce(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaves,
+                         uint64_t num_leaves, uint8_t *work, uint64_t leaf_index, uint8_t *auth_path, uint8_t *root) {
+    size_t n = params->n;
+    if (num_leaves == 0) return -1;
     if (num_leaves == 1) {
-        memcpy(root, leaves[0], HASH_SIZE);
-        return;
+        memcpy(root, leaves, n);
+        return 0;
+    }
+
+    uint8_t *owned = NULL;
+    if (!work) {
+        work = owned = malloc(merkle_workspace_bytes(params, num_leaves));
+        if (!work) return -1;
     }
+    uint8_t *buffers[2] = { work, work + parent_count(num_leaves) * n };
 
-    int level_nodes = num_leaves;
-    // Copy leaves into a working buffer allocate dynamically as needed
-    uint8_t level[level_nodes][HASH_SIZE];
-    memcpy(level, leaves, num_leaves * HASH_SIZE);
-
-    while (level_nodes > 1) {
-        int parent_nodes = level_nodes / 2;
-        for (int i = 0; i < parent_nodes; i++) {
-            uint8_t concat[2 * HASH_SIZE];
-            memcpy(concat, level[2*i], HASH_SIZE);
-            memcpy(concat + HASH_SIZE, level[2*i + 1], HASH_SIZE);
-            hash_shake256(concat, sizeof(concat), level[i], HASH_SIZE);
+    const uint8_t *level = leaves;
+    uint64_t count = num_leaves;
+    uint64_t idx = leaf_index;
+    int failed = 0;
+    for (int height = 0; count > 1; height++) {
+        if (auth_path) {
+            // A carried-up node has no sibling at this height; its path entry is zero
+            if ((idx ^ 1) < count) memcpy(auth_path + height * n, level + (idx ^ 1) * n, n);
+            else memset(auth_path + height * n, 0, n);
         }
-        level_nodes = parent_nodes;
+        uint8_t *parents = buffers[height & 1];
+        failed |= merkle_reduce_level(params, pub_seed, height + 1, level, count, parents);
+        level = parents;
+        count = parent_count(count);
+        idx >>= 1;
     }
-    memcpy(root, level[0], HASH_SIZE);
+    memcpy(root, level, n);
+    free(owned);
+    return failed ? -1 : 0;
+}
+
+// Compute Merkle root from an array of n-byte leaves
+int merkle_compute_root(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaves,
+                        uint64_t num_leaves, uint8_t *work, uint8_t *root) {
+    return merkle_reduce(params, pub_seed, leaves, num_leaves, work, 0, NULL, root);
 }
 
 // Build auth path for a given leaf index and also recompute root
-void merkle_auth_path(const uint8_t leaves[][HASH_SIZE], int num_leaves, int leaf_index,
-                      uint8_t auth_path[][HASH_SIZE], uint8_t root_out[HASH_SIZE]) {
-    int level_nodes = num_leaves;
-    int idx = leaf_index;
+int merkle_auth_path(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaves, uint64_t num_leaves,
+                     uint64_t leaf_index, uint8_t *work, uint8_t *auth_path, uint8_t *root_out) {
+    if (leaf_index >= num_leaves) return -1;
+    return merkle_reduce(params, pub_seed, leaves, num_leaves, work, leaf_index, auth_path, root_out);
+}
 
-    uint8_t level[level_nodes][HASH_SIZE];
-    memcpy(level, leaves, num_leaves * HASH_SIZE);
+// Reconstruct root from leaf + auth path, skipping the heights where the node was carried up
+int merkle_root_from_path(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaf,
+                          uint64_t leaf_index, uint64_t num_leaves, const uint8_t *auth_path, uint8_t *root_out) {
+    size_t n = params->n;
+    if (leaf_index >= num_leaves) return -1;
+    uint8_t current[HASH_SIZE];
+    memcpy(current, leaf, n);
+    uint64_t idx = leaf_index, count = num_leaves;
+    int failed = 0;
 
-    int height = 0;
-    while (level_nodes > 1) {
-        int sibling = (idx % 2 == 0) ? idx + 1 : idx - 1;
-        memcpy(auth_path[height], level[sibling], HASH_SIZE);
-
-        int parent_nodes = level_nodes / 2;
-        for (int i = 0; i < parent_nodes; i++) {
-            uint8_t concat[2 * HASH_SIZE];
-            memcpy(concat, level[2*i], HASH_SIZE);
-            memcpy(concat + HASH_SIZE, level[2*i + 1], HASH_SIZE);
-            hash_shake256(concat, sizeof(concat), level[i], HASH_SIZE);
+    for (int h = 0; count > 1; h++) {
+        if ((idx ^ 1) < count) {
+            if (idx % 2 == 0) {
+                failed |= thash_node(params, pub_seed, h + 1, idx >> 1, current, auth_path + h * n, current);
+            } else {
+                failed |= thash_node(params, pub_seed, h + 1, idx >> 1, auth_path + h * n, current, current);
+            }
         }
-        idx /= 2;
-        level_nodes = parent_nodes;
-        height++;
+        idx >>= 1;
+        count = parent_count(count);
     }
-    memcpy(root_out, level[0], HASH_SIZE);
+    memcpy(root_out, current, n);
+    return failed ? -1 : 0;
 }
 
-// Reconstruct root from leaf + auth path
-void merkle_root_from_path(const uint8_t leaf[HASH_SIZE], int leaf_index,
-                           const uint8_t auth_path[][HASH_SIZE], int height,
-                           uint8_t root_out[HASH_SIZE]) {
-    uint8_t current[HASH_SIZE];
-    memcpy(current, leaf, HASH_SIZE);
-    int idx = leaf_index;
-
-    for (int h = 0; h < height; h++) {
-        uint8_t concat[2 * HASH_SIZE];
-        if (idx % 2 == 0) {
-            memcpy(concat, current, HASH_SIZE);
-            memcpy(concat + HASH_SIZE, auth_path[h], HASH_SIZE);
-        } else {
-            memcpy(concat, auth_path[h], HASH_SIZE);
-            memcpy(concat + HASH_SIZE, current, HASH_SIZE);
+// Check that the leaf indices are strictly increasing and inside the tree
+static int indices_valid(int height, const uint64_t *indices, int count) {
+    if (height < 0 || height > 32 || count <= 0) return 0;
+    for (int k = 0; k < count; k++) {
+        if (indices[k] >> height) return 0;
+        if (k > 0 && indices[k] <= indices[k - 1]) return 0;
+    }
+    return 1;
+}
+
+// Number of proof nodes: walk the levels, counting nodes whose sibling is not in the set
+int merkle_multiproof_size(int height, const uint64_t *indices, int count) {
+    if (!indices_valid(height, indices, count)) return -1;
+    uint64_t *level = malloc((size_t)count * sizeof(uint64_t));
+    if (!level) return -1;
+    memcpy(level, indices, (size_t)count * sizeof(uint64_t));
+
+    int nodes = 0;
+    for (int t = 0; t < height; t++) {
+        int parents = 0;
+        for (int k = 0; k < count; k++) {
+            if ((level[k] & 1) == 0 && k + 1 < count && level[k + 1] == (level[k] | 1)) k++;
+            else nodes++;
+            level[parents++] = level[k] >> 1;
+        }
+        count = parents;
+    }
+    free(level);
+    return nodes;
+}
+
+// Extract a multi-proof from individual auth paths. Each node of a level remembers one leaf
+// below it, whose auth path holds the node's sibling.
+int merkle_multiproof_from_paths(const xmss_params *params, int height, const uint64_t *indices, int count,
+                                 uint8_t *const *const *auth_paths, uint8_t *proof) {
+    if (!indices_valid(height, indices, count)) return -1;
+    uint64_t *level = malloc((size_t)count * sizeof(uint64_t));
+    int *source = malloc((size_t)count * sizeof(int));
+    if (!level || !source) {
+        free(level);
+        free(source);
+        return -1;
+    }
+    for (int k = 0; k < count; k++) {
+        level[k] = indices[k];
+        source[k] = k;
+    }
+
+    int nodes = 0;
+    for (int t = 0; t < height; t++) {
+        int parents = 0;
+        for (int k = 0; k < count; k++) {
+            int src = source[k];
+            if ((level[k] & 1) == 0 && k + 1 < count && level[k + 1] == (level[k] | 1)) k++;
+            else memcpy(proof + (size_t)nodes++ * params->n, auth_paths[src][t], params->n);
+            level[parents] = level[k] >> 1;
+            source[parents++] = src;
+        }
+        count = parents;
+    }
+    free(level);
+    free(source);
+    return nodes;
+}
+
+// Rebuild the root from the leaves and a multi-proof, one level at a time
+int merkle_multiproof_root(const xmss_params *params, const uint8_t *pub_seed, int height,
+                           const uint64_t *indices, const uint8_t *leaves, int count,
+                           const uint8_t *proof, int proof_nodes, uint8_t *root_out) {
+    if (merkle_multiproof_size(height, indices, count) != proof_nodes) return -1;
+    size_t n = params->n;
+    uint64_t *level = malloc((size_t)count * sizeof(uint64_t));
+    uint8_t *nodes = malloc((size_t)count * n);
+    if (!level || !nodes) {
+        free(level);
+        free(nodes);
+        return -1;
+    }
+    memcpy(level, indices, (size_t)count * sizeof(uint64_t));
+    memcpy(nodes, leaves, (size_t)count * n);
+
+    // Parents are written in place: parent p only overwrites slots the walk has already read
+    const uint8_t *next_proof = proof;
+    int failed = 0;
+    for (int t = 0; t < height; t++) {
+        int parents = 0;
+        for (int k = 0; k < count; k++) {
+            const uint8_t *left, *right;
+            if ((level[k] & 1) == 0 && k + 1 < count && level[k + 1] == (level[k] | 1)) {
+                left = nodes + k * n;
+                right = nodes + (k + 1) * n;
+                k++;
+            } else if (level[k] & 1) {
+                left = next_proof;
+                right = nodes + k * n;
+                next_proof += n;
+            } else {
+                left = nodes + k * n;
+                right = next_proof;
+                next_proof += n;
+            }
+            failed |= thash_node(params, pub_seed, t + 1, level[k] >> 1, left, right, nodes + parents * n);
+            level[parents++] = level[k] >> 1;
         }
-        hash_shake256(concat, sizeof(concat), current, HASH_SIZE);
-        idx /= 2;
+        count = parents;
     }
-    memcpy(root_out, current, HASH_SIZE);
+    memcpy(root_out, nodes, n);
+    free(level);
+    free(nodes);
+    return failed ? -1 : 0;
 }
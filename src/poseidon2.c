@@ -0,0 +1,369 @@
+// import standard libraries
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// import project-specific headers
+#include "poseidon2.h"
+#include "hash.h"
+
+// 2^64 mod p
+#define EPSILON 0xFFFFFFFFULL
+
+// Round constants: one per element in full rounds, one per partial round, and the internal diagonal
+static uint64_t rc_full[POSEIDON2_ROUNDS_F][POSEIDON2_WIDTH];
+static uint64_t rc_partial[POSEIDON2_ROUNDS_P];
+static uint64_t diag[POSEIDON2_WIDTH];
+static pthread_once_t constants_once = PTHREAD_ONCE_INIT;
+
+// Field addition of canonical elements
+static uint64_t gl_add(uint64_t a, uint64_t b) {
+    uint64_t s = a + b;
+    if (s < a) s += EPSILON;  // Wrapped past 2^64
+    if (s >= POSEIDON2_P) s -= POSEIDON2_P;
+    return s;
+}
+
+// Reduce a 128-bit product (2^64 = 2^32 - 1 and 2^96 = -1 mod p)
+static uint64_t gl_reduce(unsigned __int128 x) {
+    uint64_t lo = (uint64_t)x;
+    uint64_t hi = (uint64_t)(x >> 64);
+    uint64_t hi_hi = hi >> 32;
+    uint64_t hi_lo = hi & EPSILON;
+
+    uint64_t t0 = lo - hi_hi;
+    if (lo < hi_hi) t0 -= EPSILON;
+    uint64_t t1 = hi_lo * EPSILON;
+    uint64_t t2 = t0 + t1;
+    if (t2 < t0) t2 += EPSILON;
+    if (t2 >= POSEIDON2_P) t2 -= POSEIDON2_P;
+    return t2;
+}
+
+// Field multiplication
+static uint64_t gl_mul(uint64_t a, uint64_t b) {
+    return gl_reduce((unsigned __int128)a * b);
+}
+
+// S-box x^7
+static uint64_t sbox(uint64_t x) {
+    uint64_t x2 = gl_mul(x, x);
+    uint64_t x3 = gl_mul(x2, x);
+    uint64_t x4 = gl_mul(x2, x2);
+    return gl_mul(x3, x4);
+}
+
+// Field subtraction of canonical elements
+static uint64_t gl_sub(uint64_t a, uint64_t b) {
+    return a >= b ? a - b : a + (POSEIDON2_P - b);
+}
+
+// Field inverse by Fermat (a != 0)
+static uint64_t gl_inv(uint64_t a) {
+    uint64_t r = 1;
+    for (uint64_t e = POSEIDON2_P - 2; e; e >>= 1) {
+        if (e & 1) r = gl_mul(r, a);
+        a = gl_mul(a, a);
+    }
+    return r;
+}
+
+// Fill values with canonical elements above 1 from the SHAKE256 stream of a domain string
+static void sample_elements(const uint8_t *domain, size_t domain_len, uint64_t *values, int count) {
+    uint8_t stream[2 * (POSEIDON2_ROUNDS_F * POSEIDON2_WIDTH + POSEIDON2_ROUNDS_P) * 8];
+    hash_shake256(domain, domain_len, stream, sizeof(stream));
+    int taken = 0;
+    for (size_t pos = 0; pos + 8 <= sizeof(stream) && taken < count; pos += 8) {
+        uint64_t v = 0;
+        for (int b = 7; b >= 0; b--) v = (v << 8) | stream[pos + b];
+        if (v < POSEIDON2_P && v > 1) values[taken++] = v;  // The diagonal needs entries other than 0 and 1
+    }
+}
+
+typedef uint64_t p2_matrix[POSEIDON2_WIDTH][POSEIDON2_WIDTH];
+
+// c = a * b
+static void matrix_mul(p2_matrix c, p2_matrix a, p2_matrix b) {
+    p2_matrix t;
+    for (int i = 0; i < POSEIDON2_WIDTH; i++) {
+        for (int j = 0; j < POSEIDON2_WIDTH; j++) {
+            uint64_t acc = 0;
+            for (int k = 0; k < POSEIDON2_WIDTH; k++) acc = gl_add(acc, gl_mul(a[i][k], b[k][j]));
+            t[i][j] = acc;
+        }
+    }
+    memcpy(c, t, sizeof(t));
+}
+
+// Characteristic polynomial of a (monic, c[WIDTH] = 1) by Faddeev-LeVerrier
+static void charpoly(p2_matrix a, uint64_t c[POSEIDON2_WIDTH + 1]) {
+    p2_matrix m, am;
+    memset(m, 0, sizeof(m));
+    c[POSEIDON2_WIDTH] = 1;
+    for (int k = 1; k <= POSEIDON2_WIDTH; k++) {
+        // M_k = A M_{k-1} + c_{n-k+1} I, c_{n-k} = -tr(A M_k) / k
+        matrix_mul(m, a, m);
+        for (int i = 0; i < POSEIDON2_WIDTH; i++) m[i][i] = gl_add(m[i][i], c[POSEIDON2_WIDTH - k + 1]);
+        matrix_mul(am, a, m);
+        uint64_t trace = 0;
+        for (int i = 0; i < POSEIDON2_WIDTH; i++) trace = gl_add(trace, am[i][i]);
+        c[POSEIDON2_WIDTH - k] = gl_sub(0, gl_mul(trace, gl_inv((uint64_t)k)));
+    }
+}
+
+// out = a * b mod f, for a, b of degree < WIDTH and f monic of degree WIDTH
+static void poly_mulmod(const uint64_t *a, const uint64_t *b, const uint64_t *f, uint64_t *out) {
+    uint64_t t[2 * POSEIDON2_WIDTH - 1] = { 0 };
+    for (int i = 0; i < POSEIDON2_WIDTH; i++) {
+        for (int j = 0; j < POSEIDON2_WIDTH; j++) t[i + j] = gl_add(t[i + j], gl_mul(a[i], b[j]));
+    }
+    for (int i = 2 * POSEIDON2_WIDTH - 2; i >= POSEIDON2_WIDTH; i--) {
+        for (int j = 0; j < POSEIDON2_WIDTH; j++) {
+            t[i - POSEIDON2_WIDTH + j] = gl_sub(t[i - POSEIDON2_WIDTH + j], gl_mul(t[i], f[j]));
+        }
+    }
+    memcpy(out, t, POSEIDON2_WIDTH * sizeof(uint64_t));
+}
+
+// Degree of a polynomial with len coefficients (-1 for zero)
+static int poly_degree(const uint64_t *a, int len) {
+    while (len > 0 && a[len - 1] == 0) len--;
+    return len - 1;
+}
+
+// 1 if gcd(a, f) is constant (a has WIDTH coefficients, f WIDTH + 1)
+static int poly_coprime(const uint64_t *a, const uint64_t *f) {
+    uint64_t x[POSEIDON2_WIDTH + 1], y[POSEIDON2_WIDTH + 1];
+    memcpy(x, f, sizeof(x));
+    memset(y, 0, sizeof(y));
+    memcpy(y, a, POSEIDON2_WIDTH * sizeof(uint64_t));
+    int dx = poly_degree(x, POSEIDON2_WIDTH + 1), dy = poly_degree(y, POSEIDON2_WIDTH + 1);
+    while (dy >= 0) {
+        // x = x mod y, then swap
+        uint64_t inv = gl_inv(y[dy]);
+        while (dx >= dy) {
+            uint64_t q = gl_mul(x[dx], inv);
+            for (int i = 0; i <= dy; i++) x[dx - dy + i] = gl_sub(x[dx - dy + i], gl_mul(q, y[i]));
+            dx = poly_degree(x, dx);
+        }
+        uint64_t t[POSEIDON2_WIDTH + 1];
+        memcpy(t, x, sizeof(t)); memcpy(x, y, sizeof(t)); memcpy(y, t, sizeof(t));
+        int d = dx; dx = dy; dy = d;
+    }
+    return dx == 0;
+}
+
+// Rabin's test for a monic f of degree 12 = 2^2 * 3: x^(p^12) = x mod f, and x^(p^6) - x and
+// x^(p^4) - x are coprime to f
+static int poly_irreducible(const uint64_t f[POSEIDON2_WIDTH + 1]) {
+    // Frobenius map g(x) -> g(x)^p = g(x^p): column j is x^(p*j) mod f
+    uint64_t frob[POSEIDON2_WIDTH][POSEIDON2_WIDTH], xp[POSEIDON2_WIDTH] = { 0 }, sq[POSEIDON2_WIDTH];
+    uint64_t y[POSEIDON2_WIDTH] = { 0 };
+    xp[0] = 1;
+    y[1] = 1;
+    for (int bit = 63; bit >= 0; bit--) {
+        poly_mulmod(xp, xp, f, xp);
+        if ((POSEIDON2_P >> bit) & 1) poly_mulmod(xp, y, f, xp);
+    }
+    memset(frob[0], 0, sizeof(frob[0]));
+    frob[0][0] = 1;
+    for (int j = 1; j < POSEIDON2_WIDTH; j++) poly_mulmod(frob[j - 1], xp, f, frob[j]);
+
+    for (int i = 1; i <= POSEIDON2_WIDTH; i++) {
+        memset(sq, 0, sizeof(sq));
+        for (int j = 0; j < POSEIDON2_WIDTH; j++) {
+            for (int k = 0; k < POSEIDON2_WIDTH; k++) sq[k] = gl_add(sq[k], gl_mul(y[j], frob[j][k]));
+        }
+        memcpy(y, sq, sizeof(y));
+        if (i == 4 || i == 6) {
+            sq[1] = gl_sub(sq[1], 1);
+            if (!poly_coprime(sq, f)) return 0;
+        }
+    }
+    for (int k = 0; k < POSEIDON2_WIDTH; k++) {
+        if (y[k] != (k == 1)) return 0;
+    }
+    return 1;
+}
+
+// The internal matrix M_I = 1 + diag(mu) must be invertible, and M_I^k must have an irreducible
+// characteristic polynomial for k = 1..2t, so no subspace is invariant under any number of
+// partial rounds (Poseidon2 paper, section 5.3)
+static int diag_secure(const uint64_t mu[POSEIDON2_WIDTH]) {
+    p2_matrix m, power;
+    uint64_t c[POSEIDON2_WIDTH + 1];
+    for (int i = 0; i < POSEIDON2_WIDTH; i++) {
+        for (int j = 0; j < POSEIDON2_WIDTH; j++) m[i][j] = (i == j) ? gl_add(mu[i], 1) : 1;
+    }
+    memcpy(power, m, sizeof(m));
+    for (int k = 1; k <= 2 * POSEIDON2_WIDTH; k++) {
+        charpoly(power, c);
+        if (c[0] == 0 || !poly_irreducible(c)) return 0;  // c[0] = det(M_I^k)
+        matrix_mul(power, power, m);
+    }
+    return 1;
+}
+
+// Round constants from SHAKE256 of the domain string; the diagonal from SHAKE256 of the domain,
+// " diag" and a counter byte, taking the first counter whose matrix passes diag_secure()
+static void derive_constants(void) {
+    static const char domain[] = "QuantumShield Poseidon2 Goldilocks t=12";
+    uint64_t values[POSEIDON2_ROUNDS_F * POSEIDON2_WIDTH + POSEIDON2_ROUNDS_P];
+    sample_elements((const uint8_t *)domain, sizeof(domain) - 1, values,
+                    POSEIDON2_ROUNDS_F * POSEIDON2_WIDTH + POSEIDON2_ROUNDS_P);
+    int k = 0;
+    for (int r = 0; r < POSEIDON2_ROUNDS_F; r++) {
+        for (int i = 0; i < POSEIDON2_WIDTH; i++) rc_full[r][i] = values[k++];
+    }
+    for (int r = 0; r < POSEIDON2_ROUNDS_P; r++) rc_partial[r] = values[k++];
+
+    uint8_t diag_domain[sizeof(domain) - 1 + 6];
+    memcpy(diag_domain, domain, sizeof(domain) - 1);
+    memcpy(diag_domain + sizeof(domain) - 1, " diag", 5);
+    for (int counter = 0; counter < 256; counter++) {
+        diag_domain[sizeof(diag_domain) - 1] = (uint8_t)counter;
+        sample_elements(diag_domain, sizeof(diag_domain), diag, POSEIDON2_WIDTH);
+        if (diag_secure(diag)) return;
+    }
+    abort();  // Roughly one draw in twelve has an irreducible polynomial; never reached
+}
+
+// M4 = [[5,7,1,3],[4,6,1,1],[1,3,5,7],[1,1,4,6]] on one block, as the Poseidon2 addition chain
+static void m4_block(uint64_t *x) {
+    uint64_t t0 = gl_add(x[0], x[1]);
+    uint64_t t1 = gl_add(x[2], x[3]);
+    uint64_t t2 = gl_add(gl_add(x[1], x[1]), t1);
+    uint64_t t3 = gl_add(gl_add(x[3], x[3]), t0);
+    uint64_t t1_4 = gl_add(gl_add(t1, t1), gl_add(t1, t1));
+    uint64_t t0_4 = gl_add(gl_add(t0, t0), gl_add(t0, t0));
+    uint64_t t4 = gl_add(t1_4, t3);
+    uint64_t t5 = gl_add(t0_4, t2);
+    x[0] = gl_add(t3, t5);
+    x[1] = t5;
+    x[2] = gl_add(t2, t4);
+    x[3] = t4;
+}
+
+// External layer: circ(2 M4, M4, M4) over the three 4-element blocks
+static void external_layer(uint64_t s[POSEIDON2_WIDTH]) {
+    uint64_t sums[4] = { 0, 0, 0, 0 };
+    for (int c = 0; c < POSEIDON2_WIDTH; c += 4) {
+        m4_block(s + c);
+        for (int i = 0; i < 4; i++) sums[i] = gl_add(sums[i], s[c + i]);
+    }
+    for (int i = 0; i < POSEIDON2_WIDTH; i++) s[i] = gl_add(s[i], sums[i % 4]);
+}
+
+// Internal layer: 1 + diag(mu)
+static void internal_layer(uint64_t s[POSEIDON2_WIDTH]) {
+    uint64_t sum = 0;
+    for (int i = 0; i < POSEIDON2_WIDTH; i++) sum = gl_add(sum, s[i]);
+    for (int i = 0; i < POSEIDON2_WIDTH; i++) s[i] = gl_add(gl_mul(s[i], diag[i]), sum);
+}
+
+// One full round
+static void full_round(uint64_t s[POSEIDON2_WIDTH], const uint64_t rc[POSEIDON2_WIDTH]) {
+    for (int i = 0; i < POSEIDON2_WIDTH; i++) s[i] = sbox(gl_add(s[i], rc[i]));
+    external_layer(s);
+}
+
+// Permutation: initial external layer, half the full rounds, the partial rounds, the other full rounds
+void poseidon2_permute(uint64_t state[POSEIDON2_WIDTH]) {
+    pthread_once(&constants_once, derive_constants);
+    external_layer(state);
+    for (int r = 0; r < POSEIDON2_ROUNDS_F / 2; r++) full_round(state, rc_full[r]);
+    for (int r = 0; r < POSEIDON2_ROUNDS_P; r++) {
+        state[0] = sbox(gl_add(state[0], rc_partial[r]));
+        internal_layer(state);
+    }
+    for (int r = POSEIDON2_ROUNDS_F / 2; r < POSEIDON2_ROUNDS_F; r++) full_round(state, rc_full[r]);
+}
+
+// Capacity word marking the input mode, so element and byte inputs never share a state
+#define DOMAIN_BYTES    0
+#define DOMAIN_ELEMENTS 1
+
+// Little-endian 64-bit word i of a byte string
+static uint64_t load_word(const uint8_t *in, size_t i) {
+    uint64_t v = 0;
+    for (int b = 7; b >= 0; b--) v = (v << 8) | in[8 * i + b];
+    return v;
+}
+
+// 1 if the input is whole 8-byte words that are all canonical elements
+static int is_elements(const uint8_t *in, size_t inlen) {
+    if (inlen % 8 != 0) return 0;
+    uint64_t canonical = 1;
+    for (size_t i = 0; i < inlen / 8; i++) canonical &= load_word(in, i) < POSEIDON2_P;
+    return (int)canonical;
+}
+
+// Initial state: the capacity holds the lengths and the input mode
+static void sponge_init(uint64_t state[POSEIDON2_WIDTH], size_t inlen, size_t outlen, uint64_t domain) {
+    memset(state, 0, POSEIDON2_WIDTH * sizeof(uint64_t));
+    state[POSEIDON2_WIDTH - 1] = (uint64_t)inlen;
+    state[POSEIDON2_WIDTH - 2] = (uint64_t)outlen;
+    state[POSEIDON2_WIDTH - 3] = domain;
+}
+
+// Sponge over canonical field elements
+int poseidon2_hash_elements(const uint64_t *in, size_t count, uint64_t *out, size_t outcount) {
+    uint64_t state[POSEIDON2_WIDTH];
+    sponge_init(state, count, outcount, DOMAIN_ELEMENTS);
+
+    // Absorb whole rate blocks; an empty input still permutes once
+    size_t pos = 0;
+    do {
+        for (int i = 0; i < POSEIDON2_RATE && pos < count; i++) state[i] = gl_add(state[i], in[pos++]);
+        poseidon2_permute(state);
+    } while (pos < count);
+
+    // Squeeze the rate part
+    for (size_t done = 0;;) {
+        for (int i = 0; i < POSEIDON2_RATE && done < outcount; i++) out[done++] = state[i];
+        if (done == outcount) break;
+        poseidon2_permute(state);
+    }
+    memset(state, 0, sizeof(state));
+    return 0;
+}
+
+// Byte interface used by the hash backends. Whole canonical 8-byte words, such as chain values,
+// tree nodes and earlier outputs, are absorbed as elements; anything else is packed 7 bytes per element.
+int poseidon2_hash(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen) {
+    uint64_t state[POSEIDON2_WIDTH];
+    size_t pos = 0;
+    if (is_elements(in, inlen)) {
+        // Same state as poseidon2_hash_elements() on inlen / 8 elements and ceil(outlen / 8) outputs
+        size_t count = inlen / 8;
+        sponge_init(state, count, (outlen + 7) / 8, DOMAIN_ELEMENTS);
+        do {
+            for (int i = 0; i < POSEIDON2_RATE && pos < count; i++) state[i] = gl_add(state[i], load_word(in, pos++));
+            poseidon2_permute(state);
+        } while (pos < count);
+    } else {
+        // Whole rate blocks of 7-byte elements; an empty input still permutes once
+        sponge_init(state, inlen, outlen, DOMAIN_BYTES);
+        do {
+            for (int i = 0; i < POSEIDON2_RATE && pos < inlen; i++) {
+                size_t chunk = inlen - pos < POSEIDON2_CHUNK_BYTES ? inlen - pos : POSEIDON2_CHUNK_BYTES;
+                uint64_t element = 0;
+                for (size_t b = chunk; b-- > 0;) element = (element << 8) | in[pos + b];
+                state[i] = gl_add(state[i], element);
+                pos += chunk;
+            }
+            poseidon2_permute(state);
+        } while (pos < inlen);
+    }
+
+    // Squeeze the rate part, eight little-endian bytes per element
+    for (size_t done = 0;;) {
+        for (int i = 0; i < POSEIDON2_RATE && done < outlen; i++) {
+            for (int b = 0; b < 8 && done < outlen; b++) out[done++] = (uint8_t)(state[i] >> (8 * b));
+        }
+        if (done == outlen) break;
+        poseidon2_permute(state);
+    }
+    memset(state, 0, sizeof(state));
+    return 0;
+}
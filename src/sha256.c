@@ -0,0 +1,184 @@
+// import standard libraries
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+// import project-specific headers
+#include <openssl/evp.h>
+#include "sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_HAVE_NI 1
+#endif
+
+// One SHA-256 digest of in || suffix (the suffix is the optional output-block counter)
+typedef int (*sha256_fn)(const uint8_t *in, size_t inlen, const uint8_t *suffix, size_t suffixlen,
+                          uint8_t out[SHA256_BYTES]);
+
+// Per-thread OpenSSL context, re-initialised for every digest instead of allocated
+static _Thread_local EVP_MD_CTX *sha256_ctx;
+
+// OpenSSL digest
+static int sha256_openssl(const uint8_t *in, size_t inlen, const uint8_t *suffix, size_t suffixlen,
+                          uint8_t out[SHA256_BYTES]) {
+    if (!sha256_ctx) sha256_ctx = EVP_MD_CTX_new();
+    if (!sha256_ctx ||
+        EVP_DigestInit_ex(sha256_ctx, EVP_sha256(), NULL) != 1 ||
+        EVP_DigestUpdate(sha256_ctx, in, inlen) != 1 ||
+        (suffixlen > 0 && EVP_DigestUpdate(sha256_ctx, suffix, suffixlen) != 1) ||
+        EVP_DigestFinal_ex(sha256_ctx, out, NULL) != 1) {
+        fprintf(stderr, "sha256: SHA-256 hashing failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Free the calling thread's OpenSSL context
+void sha256_release_thread_state(void) {
+    EVP_MD_CTX_free(sha256_ctx);
+    sha256_ctx = NULL;
+}
+
+#ifdef SHA256_HAVE_NI
+
+// Round constants
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// Compress 64-byte blocks with the SHA extensions. The state is kept as ABEF/CDGH for sha256rnds2.
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_blocks_ni(uint32_t state[8], const uint8_t *data, size_t blocks) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);  // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);  // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);        // CDGH
+
+    for (; blocks > 0; blocks--, data += 64) {
+        __m128i abef = state0, cdgh = state1;
+        __m128i w[4];
+        for (int i = 0; i < 4; i++) w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * i)), mask);
+
+        // Four rounds per group; groups 4..15 extend the message schedule in place
+        for (int g = 0; g < 16; g++) {
+            if (g >= 4) {
+                __m128i x = _mm_sha256msg1_epu32(w[g & 3], w[(g + 1) & 3]);
+                x = _mm_add_epi32(x, _mm_alignr_epi8(w[(g + 3) & 3], w[(g + 2) & 3], 4));
+                w[g & 3] = _mm_sha256msg2_epu32(x, w[(g + 3) & 3]);
+            }
+            __m128i msg = _mm_add_epi32(w[g & 3], _mm_loadu_si128((const __m128i *)&K[4 * g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);       // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);    // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);    // HGFE
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+// Digest with the SHA extensions: whole input blocks are compressed in place, the tail is padded
+static int sha256_ni(const uint8_t *in, size_t inlen, const uint8_t *suffix, size_t suffixlen,
+                     uint8_t out[SHA256_BYTES]) {
+    uint32_t state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                          0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    size_t full = inlen / 64;
+    sha256_blocks_ni(state, in, full);
+
+    uint8_t tail[128] = {0};
+    size_t rest = inlen - full * 64;
+    memcpy(tail, in + full * 64, rest);
+    memcpy(tail + rest, suffix, suffixlen);
+    rest += suffixlen;
+    tail[rest] = 0x80;
+    size_t tail_blocks = rest + 9 <= 64 ? 1 : 2;
+    uint64_t bits = (uint64_t)(inlen + suffixlen) * 8;
+    for (int i = 0; i < 8; i++) tail[tail_blocks * 64 - 1 - i] = (uint8_t)(bits >> (8 * i));
+    sha256_blocks_ni(state, tail, tail_blocks);
+
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)state[i];
+    }
+    return 0;
+}
+
+// CPU support for SHA, SSE4.1 and SSSE3
+static int cpu_has_sha_ni(void) {
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & (1u << 9)) || !(c & (1u << 19))) return 0;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return 0;
+    return (b >> 29) & 1;
+}
+
+#endif
+
+// Selected implementation; the first call goes through the dispatcher
+static int sha256_dispatch_first(const uint8_t *in, size_t inlen, const uint8_t *suffix, size_t suffixlen,
+                                 uint8_t out[SHA256_BYTES]);
+static sha256_fn sha256_digest = sha256_dispatch_first;
+static const char *sha256_name = "openssl";
+static pthread_once_t dispatch_once = PTHREAD_ONCE_INIT;
+
+// Detect the CPU features once
+static void sha256_dispatch(void) {
+    sha256_fn fn = sha256_openssl;
+#ifdef SHA256_HAVE_NI
+    if (cpu_has_sha_ni()) {
+        fn = sha256_ni;
+        sha256_name = "sha-ni";
+    }
+#endif
+    __atomic_store_n(&sha256_digest, fn, __ATOMIC_RELEASE);
+}
+
+// Dispatch, then hash
+static int sha256_dispatch_first(const uint8_t *in, size_t inlen, const uint8_t *suffix, size_t suffixlen,
+                                 uint8_t out[SHA256_BYTES]) {
+    pthread_once(&dispatch_once, sha256_dispatch);
+    return sha256_digest(in, inlen, suffix, suffixlen, out);
+}
+
+// Variable-length SHA-256 (the output is zeroed if any block fails)
+int sha256_hash(const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen) {
+    sha256_fn digest = __atomic_load_n(&sha256_digest, __ATOMIC_ACQUIRE);
+    uint8_t block[SHA256_BYTES];
+    int failed = 0;
+    if (outlen <= SHA256_BYTES) {
+        failed = digest(in, inlen, NULL, 0, block) != 0;
+        memcpy(out, block, outlen);
+    } else {
+        for (size_t done = 0, counter = 0; done < outlen; counter++) {
+            uint8_t be[4] = { (uint8_t)(counter >> 24), (uint8_t)(counter >> 16), (uint8_t)(counter >> 8), (uint8_t)counter };
+            size_t take = outlen - done < SHA256_BYTES ? outlen - done : SHA256_BYTES;
+            failed |= digest(in, inlen, be, sizeof(be), block) != 0;
+            memcpy(out + done, block, take);
+            done += take;
+        }
+    }
+    if (failed) memset(out, 0, outlen);
+    return failed ? -1 : 0;
+}
+
+// Name of the selected implementation
+const char *sha256_implementation(void) {
+    pthread_once(&dispatch_once, sha256_dispatch);
+    return sha256_name;
+}
@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 // import project-specific headers
 #include <jansson.h>
@@ -10,15 +12,16 @@
 #include "xmss.h"
 #include "wots.h"
 #include "hash.h"
+#include "wots_kernels.h"
 
 // Global variables for export
-extern XMSSKey global_xmss_key;
 extern XMSSSignature global_last_signature;
 extern uint8_t global_last_root[HASH_SIZE];
 extern uint32_t global_last_index;
 
 // Function to export SNARK data to JSON
-int export_snark_json(const char *filename, const uint8_t *msg, size_t msg_len, int h, int w) {
+int export_snark_json(const char *filename, const uint8_t *msg, size_t msg_len, const xmss_params *params) {
+    int n = params->n;
     json_t *root = json_object();
 
     // Add message as hex string
@@ -31,9 +34,9 @@ int export_snark_json(const char *filename, const uint8_t *msg, size_t msg_len,
 
     // Add root as hex string
     char root_hex[HASH_SIZE * 2 + 1];
-    for (int i = 0; i < HASH_SIZE; i++)
+    for (int i = 0; i < n; i++)
         sprintf(&root_hex[i * 2], "%02X", global_last_root[i]);
-    root_hex[HASH_SIZE * 2] = '\0';
+    root_hex[n * 2] = '\0';
     json_object_set_new(root, "root", json_string(root_hex));
 
     // Add index
@@ -41,22 +44,22 @@ int export_snark_json(const char *filename, const uint8_t *msg, size_t msg_len,
 
     // Add WOTS signature
     json_t *sig_arr = json_array();
-    for (int i = 0; i < w; i++) {
+    for (int i = 0; i < params->wots_len; i++) {
         char buf[HASH_SIZE * 2 + 1];
-        for (int j = 0; j < HASH_SIZE; j++)
+        for (int j = 0; j < n; j++)
             sprintf(&buf[j * 2], "%02X", global_last_signature.wots_sig->sig[i][j]);
-        buf[HASH_SIZE * 2] = '\0';
+        buf[n * 2] = '\0';
         json_array_append_new(sig_arr, json_string(buf));
     }
     json_object_set_new(root, "wots_signature", sig_arr);
 
     // Add auth path
     json_t *auth_arr = json_array();
-    for (int i = 0; i < h; i++) {
+    for (int i = 0; i < params->h; i++) {
         char buf[HASH_SIZE * 2 + 1];
-        for (int j = 0; j < HASH_SIZE; j++)
+        for (int j = 0; j < n; j++)
             sprintf(&buf[j * 2], "%02X", global_last_signature.auth_path[i][j]);
-        buf[HASH_SIZE * 2] = '\0';
+        buf[n * 2] = '\0';
         json_array_append_new(auth_arr, json_string(buf));
     }
     json_object_set_new(root, "auth_path", auth_arr);
@@ -71,3 +74,348 @@ int export_snark_json(const char *filename, const uint8_t *msg, size_t msg_len,
     json_decref(root);
     return 0;
 }
+
+// Buffered writer over a file descriptor
+typedef struct {
+    int fd;
+    int failed;
+    size_t len;
+    char buf[SNARK_STREAM_BUFFER];
+} snark_stream;
+
+// Hex digits, indexed by nibble
+static const char hex_digits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
+// Write out the buffered bytes
+static void stream_flush(snark_stream *s) {
+    size_t done = 0;
+    while (!s->failed && done < s->len) {
+        ssize_t written = write(s->fd, s->buf + done, s->len - done);
+        if (written <= 0) s->failed = 1;
+        else done += (size_t)written;
+    }
+    s->len = 0;
+}
+
+// Append a string
+static void stream_puts(snark_stream *s, const char *str) {
+    for (; *str; str++) {
+        if (s->len == SNARK_STREAM_BUFFER) stream_flush(s);
+        s->buf[s->len++] = *str;
+    }
+}
+
+// Append bytes as a quoted upper-case hex string
+static void stream_hex(snark_stream *s, const uint8_t *bytes, size_t len) {
+    stream_puts(s, "\"");
+    while (len > 0) {
+        if (SNARK_STREAM_BUFFER - s->len < 2) stream_flush(s);
+        size_t chunk = (SNARK_STREAM_BUFFER - s->len) / 2;
+        if (chunk > len) chunk = len;
+        char *out = s->buf + s->len;
+        for (size_t i = 0; i < chunk; i++) {
+            out[2 * i] = hex_digits[bytes[i] >> 4];
+            out[2 * i + 1] = hex_digits[bytes[i] & 15];
+        }
+        s->len += 2 * chunk;
+        bytes += chunk;
+        len -= chunk;
+    }
+    stream_puts(s, "\"");
+}
+
+// Append "key":value for an integer
+static void stream_int(snark_stream *s, const char *key, long long value) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "\"%s\":%lld", key, value);
+    stream_puts(s, buf);
+}
+
+// Append an array of n-byte rows
+static void stream_rows(snark_stream *s, const char *key, uint8_t *const *rows, int count, size_t n) {
+    stream_puts(s, ",\"");
+    stream_puts(s, key);
+    stream_puts(s, "\":[");
+    for (int i = 0; i < count; i++) {
+        if (i > 0) stream_puts(s, ",");
+        stream_hex(s, rows[i], n);
+    }
+    stream_puts(s, "]");
+}
+
+// Write one signature line
+static void stream_witness(snark_stream *s, const xmss_params *params, const snark_witness *item) {
+    size_t n = params->n;
+    stream_puts(s, "{");
+    stream_int(s, "index", item->sig->index);
+    if (item->signer >= 0) {
+        stream_puts(s, ",");
+        stream_int(s, "signer", item->signer);
+    }
+    stream_puts(s, ",\"message\":");
+    stream_hex(s, item->msg, item->msg_len);
+    stream_puts(s, ",\"root\":");
+    stream_hex(s, item->root, n);
+    if (params->hash_mode == XMSS_HASH_TWEAKED && item->pub_seed) {
+        stream_puts(s, ",\"pub_seed\":");
+        stream_hex(s, item->pub_seed, XMSS_PUB_SEED_BYTES);
+    }
+    if (params->encoding == WOTS_ENCODING_TARGET_SUM) {
+        stream_puts(s, ",\"nonce\":");
+        stream_hex(s, item->sig->wots_sig->nonce, WOTS_NONCE_BYTES);
+    }
+    stream_rows(s, "wots_signature", item->sig->wots_sig->sig, params->wots_len, n);
+    stream_rows(s, "auth_path", item->sig->auth_path, params->h, n);
+    stream_puts(s, "}\n");
+}
+
+// Stream a bundle to a file descriptor
+int export_snark_ndjson_fd(int fd, const xmss_params *params, const snark_witness *items, size_t count) {
+    snark_stream *s = malloc(sizeof(snark_stream));
+    if (!s) return -1;
+    s->fd = fd;
+    s->failed = 0;
+    s->len = 0;
+
+    // Parameter line
+    stream_puts(s, "{");
+    stream_int(s, "h", params->h);
+    stream_puts(s, ",");
+    stream_int(s, "w", params->w);
+    stream_puts(s, ",");
+    stream_int(s, "n", params->n);
+    stream_puts(s, ",");
+    stream_int(s, "wots_len", params->wots_len);
+    stream_puts(s, params->encoding == WOTS_ENCODING_TARGET_SUM ? ",\"encoding\":\"target-sum\"," : ",\"encoding\":\"checksum\",");
+    stream_int(s, "target_sum", params->encoding == WOTS_ENCODING_TARGET_SUM ? params->target_sum : 0);
+    stream_puts(s, params->hash_mode == XMSS_HASH_TWEAKED ? ",\"hash_mode\":\"tweaked\"" : ",\"hash_mode\":\"plain\"");
+    stream_puts(s, ",\"hash\":\"");
+    stream_puts(s, params->hash->name);
+    stream_puts(s, "\"}\n");
+
+    for (size_t i = 0; i < count && !s->failed; i++) stream_witness(s, params, &items[i]);
+    stream_flush(s);
+
+    int result = s->failed ? -1 : 0;
+    free(s);
+    return result;
+}
+
+// Stream a bundle to a file
+int export_snark_ndjson(const char *filename, const xmss_params *params, const snark_witness *items, size_t count) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    int result = export_snark_ndjson_fd(fd, params, items, count);
+    if (close(fd) != 0) result = -1;
+    return result;
+}
+
+// Stream an aggregate
+int export_snark_aggregate_ndjson(const char *filename, const xmss_params *params, const uint8_t *msg, size_t msg_len,
+                                  const xmss_aggregate *agg, const xmss_key_registry *registry) {
+    snark_witness *items = calloc((size_t)agg->count + 1, sizeof(snark_witness));
+    int32_t words[XMSS_PARAMS_WORDS];
+    if (!items) return -1;
+    xmss_params_encode(params, words);
+    for (int i = 0; i < agg->count; i++) {
+        uint32_t signer = agg->signers[i];
+        if (!xmss_key_registry_holds(registry, words, signer)) {
+            free(items);
+            return -1;
+        }
+        items[i].msg = msg;
+        items[i].msg_len = msg_len;
+        items[i].sig = &agg->sigs[i];
+        items[i].root = xmss_key_registry_root(registry, params, signer);
+        items[i].pub_seed = xmss_key_registry_pub_seed(registry, signer);
+        items[i].signer = signer;
+    }
+    int result = export_snark_ndjson(filename, params, items, (size_t)agg->count);
+    free(items);
+    return result;
+}
+
+// Append raw bytes
+static void stream_bytes(snark_stream *s, const void *bytes, size_t len) {
+    const uint8_t *p = bytes;
+    while (len > 0) {
+        if (s->len == SNARK_STREAM_BUFFER) stream_flush(s);
+        size_t chunk = SNARK_STREAM_BUFFER - s->len;
+        if (chunk > len) chunk = len;
+        memcpy(s->buf + s->len, p, chunk);
+        s->len += chunk;
+        p += chunk;
+        len -= chunk;
+    }
+}
+
+// Append little-endian integers
+static void stream_u32(snark_stream *s, uint32_t x) {
+    uint8_t b[4] = { (uint8_t)x, (uint8_t)(x >> 8), (uint8_t)(x >> 16), (uint8_t)(x >> 24) };
+    stream_bytes(s, b, 4);
+}
+
+static void stream_u64(snark_stream *s, uint64_t x) {
+    stream_u32(s, (uint32_t)x);
+    stream_u32(s, (uint32_t)(x >> 32));
+}
+
+// Append a byte string packed into field elements (NULL writes zeros)
+static void stream_packed(snark_stream *s, const snark_bin_header *hd, const uint8_t *bytes, size_t len) {
+    static const uint8_t zeros[32];
+    for (size_t pos = 0; pos < len; pos += hd->chunk_bytes) {
+        size_t chunk = len - pos < hd->chunk_bytes ? len - pos : hd->chunk_bytes;
+        stream_bytes(s, bytes ? bytes + pos : zeros, chunk);
+        stream_bytes(s, zeros, hd->elem_bytes - chunk);
+    }
+}
+
+// Field parameters, indexed by SNARK_FIELD_*
+static const struct { const char *name; uint32_t chunk_bytes; uint32_t elem_bytes; } snark_fields[] = {
+    { "raw", 1, 1 }, { "bn254", 31, 32 }, { "goldilocks", 7, 8 }, { "babybear", 3, 4 },
+};
+
+// Look up a field by name
+int snark_field_from_name(const char *name) {
+    for (int i = 0; i < (int)(sizeof(snark_fields) / sizeof(snark_fields[0])); i++) {
+        if (strcmp(name, snark_fields[i].name) == 0) return i;
+    }
+    return -1;
+}
+
+// Round up to a multiple of 8
+static uint32_t align8(uint32_t x) {
+    return (x + 7) & ~7u;
+}
+
+// Compute the record layout
+int snark_bin_layout(const xmss_params *params, int field, uint64_t count, snark_bin_header *hd) {
+    if (field < 0 || field >= (int)(sizeof(snark_fields) / sizeof(snark_fields[0]))) return -1;
+    memset(hd, 0, sizeof(*hd));
+    hd->version = SNARK_BIN_VERSION;
+    hd->h = params->h;
+    hd->w = params->w;
+    hd->n = params->n;
+    hd->wots_len = params->wots_len;
+    hd->encoding = params->encoding;
+    hd->target_sum = params->encoding == WOTS_ENCODING_TARGET_SUM ? params->target_sum : 0;
+    hd->hash_mode = params->hash_mode;
+    hd->hash_backend = params->hash->id;
+    hd->field = field;
+    hd->chunk_bytes = snark_fields[field].chunk_bytes;
+    hd->elem_bytes = snark_fields[field].elem_bytes;
+    hd->digest_bytes = (hd->n + hd->chunk_bytes - 1) / hd->chunk_bytes * hd->elem_bytes;
+    hd->nonce_bytes = (WOTS_NONCE_BYTES + hd->chunk_bytes - 1) / hd->chunk_bytes * hd->elem_bytes;
+    uint32_t seed_bytes = (XMSS_PUB_SEED_BYTES + hd->chunk_bytes - 1) / hd->chunk_bytes * hd->elem_bytes;
+
+    // Every field starts 8-byte aligned
+    hd->off_index = 0;
+    hd->off_digest = 8;
+    hd->off_nonce = align8(hd->off_digest + hd->digest_bytes);
+    hd->off_root = align8(hd->off_nonce + hd->nonce_bytes);
+    hd->off_pub_seed = align8(hd->off_root + hd->digest_bytes);
+    hd->off_digits = align8(hd->off_pub_seed + seed_bytes);
+    hd->off_steps = align8(hd->off_digits + 4 * hd->wots_len);
+    hd->off_chains = align8(hd->off_steps + 4 * hd->wots_len);
+    hd->off_path_bits = align8(hd->off_chains + hd->wots_len * hd->digest_bytes);
+    hd->off_siblings = align8(hd->off_path_bits + 4 * hd->h);
+    hd->record_bytes = align8(hd->off_siblings + hd->h * hd->digest_bytes);
+    hd->count = count;
+    return 0;
+}
+
+// Pad a record to the next offset
+static void stream_pad(snark_stream *s, uint64_t *pos, uint64_t target) {
+    static const uint8_t zeros[8];
+    stream_bytes(s, zeros, (size_t)(target - *pos));
+    *pos = target;
+}
+
+// Write one record
+static int stream_record(snark_stream *s, const xmss_params *params, const snark_bin_header *hd,
+                         const snark_witness *item) {
+    size_t n = params->n;
+    const XMSSSignature *sig = item->sig;
+    uint8_t msg_hash[HASH_SIZE];
+    uint8_t digits[WOTS_LEN_MAX];
+    xmss_hash(params, item->msg, item->msg_len, msg_hash, n);
+    if (wots_verify_digits(params, msg_hash, sig->wots_sig, digits) != 0) return -1;
+
+    uint64_t pos = 0;
+    stream_u64(s, (uint64_t)sig->index);
+    pos += 8;
+    stream_packed(s, hd, msg_hash, n);
+    pos += hd->digest_bytes;
+    stream_pad(s, &pos, hd->off_nonce);
+    stream_packed(s, hd, params->encoding == WOTS_ENCODING_TARGET_SUM ? sig->wots_sig->nonce : NULL, WOTS_NONCE_BYTES);
+    pos += hd->nonce_bytes;
+    stream_pad(s, &pos, hd->off_root);
+    stream_packed(s, hd, item->root, n);
+    pos += hd->digest_bytes;
+    stream_pad(s, &pos, hd->off_pub_seed);
+    stream_packed(s, hd, params->hash_mode == XMSS_HASH_TWEAKED ? item->pub_seed : NULL, XMSS_PUB_SEED_BYTES);
+    pos += (XMSS_PUB_SEED_BYTES + hd->chunk_bytes - 1) / hd->chunk_bytes * hd->elem_bytes;
+
+    stream_pad(s, &pos, hd->off_digits);
+    for (int i = 0; i < params->wots_len; i++) stream_u32(s, digits[i]);
+    pos += 4 * params->wots_len;
+    stream_pad(s, &pos, hd->off_steps);
+    for (int i = 0; i < params->wots_len; i++) stream_u32(s, (uint32_t)(params->w - 1 - digits[i]));
+    pos += 4 * params->wots_len;
+    stream_pad(s, &pos, hd->off_chains);
+    for (int i = 0; i < params->wots_len; i++) stream_packed(s, hd, sig->wots_sig->sig[i], n);
+    pos += (uint64_t)params->wots_len * hd->digest_bytes;
+
+    stream_pad(s, &pos, hd->off_path_bits);
+    for (int t = 0; t < params->h; t++) stream_u32(s, (uint32_t)(((uint64_t)sig->index >> t) & 1));
+    pos += 4 * params->h;
+    stream_pad(s, &pos, hd->off_siblings);
+    for (int t = 0; t < params->h; t++) stream_packed(s, hd, sig->auth_path[t], n);
+    pos += (uint64_t)params->h * hd->digest_bytes;
+    stream_pad(s, &pos, hd->record_bytes);
+    return 0;
+}
+
+// Write a binary witness to a file descriptor
+int export_snark_bin_fd(int fd, const xmss_params *params, int field, const snark_witness *items, size_t count) {
+    snark_bin_header hd;
+    if (snark_bin_layout(params, field, count, &hd) != 0) return -1;
+    snark_stream *s = malloc(sizeof(snark_stream));
+    if (!s) return -1;
+    s->fd = fd;
+    s->failed = 0;
+    s->len = 0;
+
+    // Header fields in declaration order, then padding
+    const uint32_t fields[] = {
+        hd.version, hd.h, hd.w, hd.n, hd.wots_len, hd.encoding, hd.target_sum, hd.hash_mode,
+        hd.field, hd.chunk_bytes, hd.elem_bytes, hd.digest_bytes, hd.nonce_bytes,
+        hd.off_index, hd.off_digest, hd.off_nonce, hd.off_root, hd.off_pub_seed,
+        hd.off_digits, hd.off_steps, hd.off_chains, hd.off_path_bits, hd.off_siblings,
+    };
+    uint8_t pad[SNARK_BIN_HEADER] = {0};
+    size_t header_len = 4 + sizeof(fields) + 20;
+    stream_bytes(s, SNARK_BIN_MAGIC, 4);
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) stream_u32(s, fields[i]);
+    stream_u64(s, hd.count);
+    stream_u64(s, hd.record_bytes);
+    stream_u32(s, hd.hash_backend);
+    stream_bytes(s, pad, SNARK_BIN_HEADER - header_len);
+
+    int result = 0;
+    for (size_t i = 0; i < count && !s->failed && result == 0; i++) result = stream_record(s, params, &hd, &items[i]);
+    stream_flush(s);
+    if (s->failed) result = -1;
+    free(s);
+    return result;
+}
+
+// Write a binary witness to a file
+int export_snark_bin(const char *filename, const xmss_params *params, int field, const snark_witness *items,
+                     size_t count) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    int result = export_snark_bin_fd(fd, params, field, items, count);
+    if (close(fd) != 0) result = -1;
+    return result;
+}
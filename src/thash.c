@@ -0,0 +1,220 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include <openssl/evp.h>
+#include "thash.h"
+#include "hash.h"
+#include "xmss_arena.h"
+
+// Per-thread Keccak state with the PRF prefix and public seed already absorbed
+static _Thread_local struct {
+    uint8_t pub_seed[XMSS_PUB_SEED_BYTES];
+    size_t seed_len;
+    int valid;
+    EVP_MD_CTX *seeded; // SHAKE256 state after absorbing toByte(3, pad) || pub_seed
+    EVP_MD_CTX *work;   // Scratch state cloned from `seeded` for each call
+} seed_cache;
+
+// Reset the address and set all words to zero
+void adrs_init(xmss_adrs *adrs) {
+    memset(adrs, 0, sizeof(*adrs));
+}
+
+// Set the address type; the type-specific words are cleared
+void adrs_set_type(xmss_adrs *adrs, uint32_t type) {
+    adrs->word[3] = type;
+    adrs->word[4] = adrs->word[5] = adrs->word[6] = adrs->word[7] = 0;
+}
+
+// OTS address: word 4 = OTS index, word 5 = chain, word 6 = hash step
+void adrs_set_ots(xmss_adrs *adrs, uint32_t ots)     { adrs->word[4] = ots; }
+void adrs_set_chain(xmss_adrs *adrs, uint32_t chain) { adrs->word[5] = chain; }
+void adrs_set_hash(xmss_adrs *adrs, uint32_t hash)   { adrs->word[6] = hash; }
+
+// L-tree / hash tree address: word 4 = L-tree index, word 5 = tree height, word 6 = tree index
+void adrs_set_ltree(xmss_adrs *adrs, uint32_t ltree)         { adrs->word[4] = ltree; }
+void adrs_set_tree_height(xmss_adrs *adrs, uint32_t height)  { adrs->word[5] = height; }
+void adrs_set_tree_index(xmss_adrs *adrs, uint32_t index)    { adrs->word[6] = index; }
+
+// Word 7 selects the PRF output: 0 = key, 1 and 2 = bitmasks
+void adrs_set_key_and_mask(xmss_adrs *adrs, uint32_t key_and_mask) { adrs->word[7] = key_and_mask; }
+
+// Serialize the address as eight big-endian 32-bit words
+void adrs_to_bytes(const xmss_adrs *adrs, uint8_t out[XMSS_ADDR_BYTES]) {
+    for (int i = 0; i < 8; i++) {
+        out[4*i + 0] = (uint8_t)(adrs->word[i] >> 24);
+        out[4*i + 1] = (uint8_t)(adrs->word[i] >> 16);
+        out[4*i + 2] = (uint8_t)(adrs->word[i] >> 8);
+        out[4*i + 3] = (uint8_t)(adrs->word[i]);
+    }
+}
+
+// RFC 8391 domain prefixes toByte(x, pad)
+#define THASH_PREFIX_F   0
+#define THASH_PREFIX_H   1
+#define THASH_PREFIX_PRF 3
+
+// Length of the toByte() prefix: n, except 4 for n = 24 (NIST SP 800-208)
+static size_t prefix_len(size_t n) {
+    return n == 24 ? 4 : n;
+}
+
+// Write toByte(x, len): x as a big-endian integer of len bytes
+static void to_byte(uint8_t *out, uint32_t x, size_t len) {
+    memset(out, 0, len);
+    for (size_t i = 0; i < len && i < 4; i++) out[len - 1 - i] = (uint8_t)(x >> (8 * i));
+}
+
+// Absorb toByte(3, pad) || SEED once; later calls with the same seed only clone the state
+static int seed_cache_load(const uint8_t *pub_seed, size_t seed_len) {
+    if (seed_len > XMSS_PUB_SEED_BYTES) return -1;
+    if (seed_cache.valid && seed_cache.seed_len == seed_len &&
+        memcmp(seed_cache.pub_seed, pub_seed, seed_len) == 0) return 0;
+
+    if (!seed_cache.seeded) seed_cache.seeded = EVP_MD_CTX_new();
+    if (!seed_cache.work) seed_cache.work = EVP_MD_CTX_new();
+    if (!seed_cache.seeded || !seed_cache.work) return -1;
+
+    uint8_t prefix[HASH_SIZE];
+    to_byte(prefix, THASH_PREFIX_PRF, prefix_len(seed_len));
+    seed_cache.valid = 0;
+    if (EVP_DigestInit_ex(seed_cache.seeded, EVP_shake256(), NULL) != 1 ||
+        EVP_DigestUpdate(seed_cache.seeded, prefix, prefix_len(seed_len)) != 1 ||
+        EVP_DigestUpdate(seed_cache.seeded, pub_seed, seed_len) != 1) {
+        return -1;
+    }
+    memcpy(seed_cache.pub_seed, pub_seed, seed_len);
+    seed_cache.seed_len = seed_len;
+    seed_cache.valid = 1;
+    return 0;
+}
+
+// RFC 8391 PRF(SEED, ADRS) = H(toByte(3, pad) || SEED || ADRS)
+int thash_prf(const xmss_params *params, const uint8_t *pub_seed, const xmss_adrs *adrs, uint8_t *out) {
+    size_t n = (size_t)params->n, pad = prefix_len(n);
+    uint8_t adrs_bytes[XMSS_ADDR_BYTES];
+    adrs_to_bytes(adrs, adrs_bytes);
+
+    if (params->hash->id == HASH_BACKEND_SHAKE256) {
+        if (seed_cache_load(pub_seed, n) != 0 ||
+            EVP_MD_CTX_copy_ex(seed_cache.work, seed_cache.seeded) != 1 ||
+            EVP_DigestUpdate(seed_cache.work, adrs_bytes, XMSS_ADDR_BYTES) != 1 ||
+            EVP_DigestFinalXOF(seed_cache.work, out, n) != 1) {
+            // Never hand back a partial digest
+            memset(out, 0, n);
+            seed_cache.valid = 0;
+            return -1;
+        }
+        return 0;
+    }
+
+    // Other backends have no absorbed-seed state to clone: hash the whole input
+    uint8_t buffer[2 * HASH_SIZE + XMSS_ADDR_BYTES];
+    to_byte(buffer, THASH_PREFIX_PRF, pad);
+    memcpy(buffer + pad, pub_seed, n);
+    memcpy(buffer + pad + n, adrs_bytes, XMSS_ADDR_BYTES);
+    return params->hash->hash(buffer, pad + n + XMSS_ADDR_BYTES, out, n);
+}
+
+// RFC 8391 F (one block, prefix 0) and RAND_HASH (two blocks, prefix 1):
+// H(toByte(prefix, pad) || KEY || (in_0 ^ BM_0) [|| (in_1 ^ BM_1)]), with KEY = PRF(SEED, ADRS with
+// keyAndMask 0) and BM_i = PRF(SEED, ADRS with keyAndMask i + 1)
+static int thash_masked(const xmss_params *params, const uint8_t *pub_seed, const xmss_adrs *adrs,
+                        const uint8_t *in, int blocks, uint8_t *out) {
+    size_t n = (size_t)params->n, pad = prefix_len(n);
+    uint8_t buffer[HASH_SIZE + 3 * HASH_SIZE];
+    uint8_t mask[HASH_SIZE];
+    xmss_adrs local = *adrs;
+    int failed = 0;
+
+    to_byte(buffer, blocks == 1 ? THASH_PREFIX_F : THASH_PREFIX_H, pad);
+    adrs_set_key_and_mask(&local, 0);
+    failed |= thash_prf(params, pub_seed, &local, buffer + pad);
+    for (int b = 0; b < blocks; b++) {
+        adrs_set_key_and_mask(&local, (uint32_t)b + 1);
+        failed |= thash_prf(params, pub_seed, &local, mask);
+        uint8_t *block = buffer + pad + n + (size_t)b * n;
+        for (size_t i = 0; i < n; i++) block[i] = in[(size_t)b * n + i] ^ mask[i];
+    }
+    if (failed) {
+        memset(out, 0, n);
+        return -1;
+    }
+    return params->hash->hash(buffer, pad + n + (size_t)blocks * n, out, n);
+}
+
+// RFC 8391 L-tree: compress len n-byte nodes pairwise (an odd last node moves up) into one node
+static int thash_ltree(const xmss_params *params, const uint8_t *pub_seed, const xmss_adrs *adrs,
+                       const uint8_t *in, size_t inlen, uint8_t *out) {
+    size_t n = (size_t)params->n, len = inlen / n;
+    xmss_arena *arena = xmss_arena_thread();
+    size_t mark = xmss_arena_begin(arena);
+    uint8_t *nodes = xmss_arena_get(arena, inlen);
+    if (!nodes || len == 0 || inlen % n != 0) {
+        xmss_arena_end(arena, mark);
+        memset(out, 0, n);
+        return -1;
+    }
+    memcpy(nodes, in, inlen);
+
+    xmss_adrs local = *adrs;
+    int failed = 0;
+    for (uint32_t height = 0; len > 1; height++) {
+        adrs_set_tree_height(&local, height);
+        for (size_t i = 0; i < len / 2; i++) {
+            adrs_set_tree_index(&local, (uint32_t)i);
+            failed |= thash_masked(params, pub_seed, &local, nodes + 2 * i * n, 2, nodes + i * n);
+        }
+        if (len & 1) memmove(nodes + (len / 2) * n, nodes + (len - 1) * n, n);
+        len = (len + 1) / 2;
+    }
+    memcpy(out, nodes, n);
+    xmss_arena_put(arena, nodes);
+    xmss_arena_end(arena, mark);
+    if (failed) memset(out, 0, n);
+    return failed ? -1 : 0;
+}
+
+// Free the calling thread's cached Keccak states (worker threads call this before exiting)
+void thash_release_thread_state(void) {
+    EVP_MD_CTX_free(seed_cache.seeded);
+    EVP_MD_CTX_free(seed_cache.work);
+    seed_cache.seeded = NULL;
+    seed_cache.work = NULL;
+    seed_cache.valid = 0;
+    hash_release_thread_state();
+}
+
+// Tweakable hash: RFC 8391 F, RAND_HASH or L-tree, or plain H(in), with the key's backend
+int thash(const xmss_params *params, const uint8_t *pub_seed, const xmss_adrs *adrs,
+          const uint8_t *in, size_t inlen, uint8_t *out) {
+    size_t n = (size_t)params->n;
+    if (params->hash_mode != XMSS_HASH_TWEAKED) return params->hash->hash(in, inlen, out, n);
+    if (adrs->word[3] == XMSS_ADDR_TYPE_LTREE) return thash_ltree(params, pub_seed, adrs, in, inlen, out);
+    if (inlen == n || inlen == 2 * n) return thash_masked(params, pub_seed, adrs, in, (int)(inlen / n), out);
+    memset(out, 0, n);
+    return -1;
+}
+
+// Untweaked hash with the key's backend and an explicit output length (digests and PRFs)
+int xmss_hash(const xmss_params *params, const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen) {
+    return params->hash->hash(in, inlen, out, outlen);
+}
+
+// Hash two child nodes into their parent (RFC 8391: tree height of the children, index of the parent)
+int thash_node(const xmss_params *params, const uint8_t *pub_seed, int height, uint64_t index,
+               const uint8_t *left, const uint8_t *right, uint8_t *out) {
+    uint8_t buffer[2 * HASH_SIZE];
+    memcpy(buffer, left, params->n);
+    memcpy(buffer + params->n, right, params->n);
+
+    xmss_adrs adrs;
+    adrs_init(&adrs);
+    adrs_set_type(&adrs, XMSS_ADDR_TYPE_HASHTREE);
+    adrs_set_tree_height(&adrs, (uint32_t)(height - 1));
+    adrs_set_tree_index(&adrs, (uint32_t)index);
+    return thash(params, pub_seed, &adrs, buffer, 2 * params->n, out);
+}
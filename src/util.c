@@ -1,20 +1,156 @@
 // import standard libraries
 #include <string.h>
+#include <stdio.h>
 
 // import project-specific headers
 #include "util.h"
 
-// Securely zero out memory
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Hide a value from the optimizer, so a mask cannot be turned back into a branch
+#if defined(__GNUC__)
+#define CT_BARRIER(x) __asm__ volatile("" : "+r"(x))
+#else
+#define CT_BARRIER(x) ((void)0)
+#endif
+
+// Unaligned word access
+static inline uint64_t load64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store64(uint8_t *p, uint64_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// Securely zero out memory: a full-width memset the compiler may not drop as a dead store
+#if defined(__GNUC__)
 void secure_zero_memory(void *ptr, size_t len) {
-    volatile unsigned char *p = ptr;
-    while (len--) {
-        *p++ = 0;
-        }
+    memset(ptr, 0, len);
+    __asm__ volatile("" : : "r"(ptr) : "memory");
 }
+#else
+static void *(*const volatile memset_func)(void *, int, size_t) = memset;
 
-// Perform conditional selection based on a mask
+void secure_zero_memory(void *ptr, size_t len) {
+    memset_func(ptr, 0, len);
+}
+#endif
+
+// Perform conditional selection based on a mask: 16-byte vectors, then 64-bit words, then bytes
 void conditional_select(uint8_t *dst, const uint8_t *a, const uint8_t *b, uint32_t mask, size_t len) {
-for (size_t i = 0; i < len; i++) {
-    dst[i] = (mask & a[i]) | (~mask & b[i]);
+    uint64_t m = (uint64_t)mask | ((uint64_t)mask << 32);
+    CT_BARRIER(m);
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i vm = _mm_set1_epi64x((long long)m);
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_and_si128(vm, va), _mm_andnot_si128(vm, vb)));
+    }
+#elif defined(__ARM_NEON)
+    uint8x16_t vm = vreinterpretq_u8_u64(vdupq_n_u64(m));
+    for (; i + 16 <= len; i += 16) {
+        vst1q_u8(dst + i, vbslq_u8(vm, vld1q_u8(a + i), vld1q_u8(b + i)));
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        store64(dst + i, (m & load64(a + i)) | (~m & load64(b + i)));
+    }
+    for (; i < len; i++) {
+        dst[i] = (uint8_t)((m & a[i]) | (~m & b[i]));
+    }
+}
+
+// Compare in constant time: OR of the XOR of every word, reduced without a branch
+int constant_time_equal(const void *a, const void *b, size_t len) {
+    const uint8_t *x = a, *y = b;
+    uint64_t diff = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        acc = _mm_or_si128(acc, _mm_xor_si128(_mm_loadu_si128((const __m128i *)(x + i)),
+                                              _mm_loadu_si128((const __m128i *)(y + i))));
     }
-}
\ No newline at end of file
+    uint8_t lanes[16];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    diff = load64(lanes) | load64(lanes + 8);
+#elif defined(__ARM_NEON)
+    uint8x16_t acc = vdupq_n_u8(0);
+    for (; i + 16 <= len; i += 16) acc = vorrq_u8(acc, veorq_u8(vld1q_u8(x + i), vld1q_u8(y + i)));
+    uint64x2_t acc64 = vreinterpretq_u64_u8(acc);
+    diff = vgetq_lane_u64(acc64, 0) | vgetq_lane_u64(acc64, 1);
+#endif
+    for (; i + 8 <= len; i += 8) diff |= load64(x + i) ^ load64(y + i);
+    for (; i < len; i++) diff |= (uint64_t)(x[i] ^ y[i]);
+    CT_BARRIER(diff);
+    return (int)(1 ^ ((diff | (0 - diff)) >> 63));
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#include <io.h>
+
+// Replace dst with src (rename() does not overwrite on Windows)
+int replace_file(const char *src, const char *dst) {
+    return MoveFileExA(src, dst, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+}
+
+// Flush the stdio buffer and the OS cache of a file
+int fsync_file(FILE *f) {
+    return fflush(f) == 0 && _commit(_fileno(f)) == 0 ? 0 : -1;
+}
+
+// Open a file for writing (Windows ACLs are inherited from the directory)
+FILE *fopen_private(const char *path) {
+    return fopen(path, "wb");
+}
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Replace dst with src atomically, then sync the directory entry
+int replace_file(const char *src, const char *dst) {
+    if (rename(src, dst) != 0) return -1;
+    char dir[4096];
+    const char *slash = strrchr(dst, '/');
+    size_t len = slash ? (size_t)(slash - dst) : 0;
+    if (len >= sizeof(dir)) return 0;
+    if (slash) {
+        memcpy(dir, dst, len ? len : 1);
+        dir[len ? len : 1] = '\0';
+    } else {
+        strcpy(dir, ".");
+    }
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) return 0;
+    int r = fsync(fd);
+    close(fd);
+    return r == 0 ? 0 : -1;
+}
+
+// Flush the stdio buffer and the OS cache of a file
+int fsync_file(FILE *f) {
+    return fflush(f) == 0 && fsync(fileno(f)) == 0 ? 0 : -1;
+}
+
+// Create or truncate a file readable by the owner only
+FILE *fopen_private(const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return NULL;
+    // An existing file keeps its mode through O_TRUNC
+    if (fchmod(fd, 0600) != 0) { close(fd); return NULL; }
+    FILE *f = fdopen(fd, "wb");
+    if (!f) close(fd);
+    return f;
+}
+#endif
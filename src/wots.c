@@ -5,41 +5,49 @@
 
 // import project-specific headers
 #include "wots.h"
+#include "wots_kernels.h"
 #include "hash.h"
 #include "util.h"
+#include "csprng.h"
+#include "xmss_parallel.h"
+#include "xmss_secmem.h"
 
-// Allocate memory for WOTS signature chains
-static uint8_t** alloc_chains(int wots_len) {
-    uint8_t **chains = malloc(wots_len * sizeof(uint8_t*));
+// Point the row pointers at the rows that follow them
+static uint8_t** set_rows(uint8_t **chains, int wots_len, int n) {
     if (!chains) return NULL;
-    for (int i = 0; i < wots_len; i++) {
-        chains[i] = malloc(HASH_SIZE);
-        if (!chains[i]) {
-            // Rollback on failure
-            for (int j = 0; j < i; j++) free(chains[j]);
-            free(chains);
-            return NULL;
-        }
-    }
+    uint8_t *rows = (uint8_t *)(chains + wots_len);
+    for (int i = 0; i < wots_len; i++) chains[i] = rows + (size_t)i * n;
     return chains;
 }
 
-// Free allocated for WOTS signature chains
-static void free_chains(uint8_t **chains, int wots_len) {
+// Allocate WOTS chains: the row pointers and all rows in one block
+static uint8_t** alloc_chains(int wots_len, int n, xmss_arena *arena) {
+    return set_rows(xmss_arena_get(arena, (size_t)wots_len * (sizeof(uint8_t*) + n)), wots_len, n);
+}
+
+// Free WOTS chains
+static void free_chains(uint8_t **chains, xmss_arena *arena) {
     if (!chains) return;
-    for (int i = 0; i < wots_len; i++) {
-        free(chains[i]);
-    }
-    free(chains);
+    xmss_arena_put(arena, chains);
+}
+
+// Secret chains (same layout) come from the locked secure heap, which wipes them on release
+static uint8_t** alloc_secret_chains(int wots_len, int n) {
+    return set_rows(xmss_secmem_alloc((size_t)wots_len * (sizeof(uint8_t*) + n)), wots_len, n);
 }
 
 // Allocate memory for WOTS Key
 int wots_alloc_key(WOTSKey *key, const xmss_params *params) {
-    key->sk = alloc_chains(params->wots_len);
-    key->pk = alloc_chains(params->wots_len);
+    return wots_alloc_key_arena(key, params, NULL);
+}
+
+// Allocate memory for WOTS Key, from an arena if given
+int wots_alloc_key_arena(WOTSKey *key, const xmss_params *params, xmss_arena *arena) {
+    key->sk = alloc_secret_chains(params->wots_len, params->n);
+    key->pk = alloc_chains(params->wots_len, params->n, arena);
     if (!key->sk || !key->pk) {
-        free_chains(key->sk, params->wots_len);
-        free_chains(key->pk, params->wots_len);
+        xmss_secmem_free(key->sk);
+        free_chains(key->pk, arena);
         return -1;
     }
     return 0;
@@ -47,143 +55,262 @@ int wots_alloc_key(WOTSKey *key, const xmss_params *params) {
 
 // Free allocated memory for WOTS Key
 void wots_free_key(WOTSKey *key, const xmss_params *params) {
+    wots_free_key_arena(key, params, NULL);
+}
+
+// Free a WOTS Key allocated with wots_alloc_key_arena()
+void wots_free_key_arena(WOTSKey *key, const xmss_params *params, xmss_arena *arena) {
+    (void)params;
     if (key) {
-        free_chains(key->sk, params->wots_len);
-        free_chains(key->pk, params->wots_len);
+        xmss_secmem_free(key->sk);
+        free_chains(key->pk, arena);
     }
 }
 
 // Allocate memory for WOTS Signature
 int wots_alloc_sig(WOTSSignature *sig, const xmss_params *params) {
-    sig->sig = alloc_chains(params->wots_len);
+    return wots_alloc_sig_arena(sig, params, NULL);
+}
+
+// Allocate memory for WOTS Signature, from an arena if given
+int wots_alloc_sig_arena(WOTSSignature *sig, const xmss_params *params, xmss_arena *arena) {
+    sig->sig = alloc_chains(params->wots_len, params->n, arena);
     return sig->sig ? 0 : -1;
 }
 
 // Free allocated memory for WOTS Signature
 void wots_free_sig(WOTSSignature *sig, const xmss_params *params) {
+    wots_free_sig_arena(sig, params, NULL);
+}
+
+// Free a WOTS Signature allocated with wots_alloc_sig_arena()
+void wots_free_sig_arena(WOTSSignature *sig, const xmss_params *params, xmss_arena *arena) {
+    (void)params;
     if (sig) {
-        free_chains(sig->sig, params->wots_len);
+        free_chains(sig->sig, arena);
     }
 }
 
 
-// Compute WOTS chain with constant-time hashing
-static void wots_chain_ct(uint8_t out[HASH_SIZE], const uint8_t in[HASH_SIZE], int start, int steps, int w) {
-    uint8_t current_hash[HASH_SIZE];
-    uint8_t next_hash[HASH_SIZE];
-    memcpy(current_hash, in, HASH_SIZE);
-
-    for (int i = 0; i < w - 1; i++) {
-        // Always compute the next hash to keep timing consistent
-        hash_shake256(current_hash, HASH_SIZE, next_hash, HASH_SIZE);
-        
-        // Conditionally select the next hash if we are within the desired step range
-        uint32_t cond = (i >= start && i < start + steps);
-        uint32_t mask = cond ? -1 : 0; // Create a mask of all 1s or all 0s
-        conditional_select(current_hash, next_hash, current_hash, mask, HASH_SIZE);
+// Compute WOTS chain for verification. Signatures and digits are public, so only the
+// remaining steps are hashed and the verifier cost follows the encoding's digit sum.
+static void wots_chain_public(const xmss_params *params, const uint8_t *pub_seed, xmss_adrs *adrs,
+                              uint8_t *out, const uint8_t *in, int start, int steps) {
+    memcpy(out, in, params->n);
+    for (int i = start; i < start + steps; i++) {
+        adrs_set_hash(adrs, (uint32_t)i);
+        thash(params, pub_seed, adrs, out, params->n, out);
     }
-    memcpy(out, current_hash, HASH_SIZE);
-    
-    // Clean up stack variables
-    secure_zero_memory(current_hash, HASH_SIZE);
-    secure_zero_memory(next_hash, HASH_SIZE);
 }
 
+// Copy the caller's OTS address (plain mode callers may pass NULL)
+static void wots_adrs(xmss_adrs *dst, const xmss_adrs *src) {
+    if (src) *dst = *src;
+    else adrs_init(dst);
+}
+
+// Target-sum encoding: base-w digits of H(nonce || msg), no checksum.
+// Returns 1 if the digits sum to the target, 0 otherwise, and -1 if the hash failed.
+static int base_w_target_sum(const uint8_t *msg, const uint8_t nonce[WOTS_NONCE_BYTES],
+                             const xmss_params *params, uint8_t *output) {
+    uint8_t buffer[WOTS_NONCE_BYTES + HASH_SIZE];
+    uint8_t digest[HASH_SIZE];
+    memcpy(buffer, nonce, WOTS_NONCE_BYTES);
+    memcpy(buffer + WOTS_NONCE_BYTES, msg, params->n);
+    if (xmss_hash(params, buffer, WOTS_NONCE_BYTES + params->n, digest, params->n) != 0) return -1;
 
-// Convert msg hash -> base-w digits and compute checksum
-static void base_w_and_checksum(const uint8_t *input, const xmss_params *params, uint8_t *output) {
     int in = 0;
-    int out = 0;
     uint32_t total = 0;
     int bits = 0;
-    uint16_t checksum = 0;
-    
-    // Message part
+    int sum = 0;
     for (int i = 0; i < params->wots_len1; i++) {
         if (bits < params->log_w) {
-            total = (total << 8) | input[in++];
+            total = (total << 8) | digest[in++];
             bits += 8;
         }
         bits -= params->log_w;
-        output[out++] = (total >> bits) & (params->w - 1);
-        checksum += params->w - 1 - output[i];
+        output[i] = (total >> bits) & (params->w - 1);
+        sum += output[i];
     }
 
-    // Checksum part
-    checksum <<= (8 - ((params->wots_len2 * params->log_w) % 8)) % 8;
-    for (int i = 0; i < params->wots_len2; i++) {
-        output[out++] = (checksum >> ((params->wots_len2 - 1 - i) * params->log_w)) & (params->w - 1);
+    secure_zero_memory(digest, params->n);
+    return sum == params->target_sum;
+}
+
+// One call's chains, evaluated chain by chain (possibly on several threads)
+typedef struct {
+    const xmss_params *params;
+    const uint8_t *pub_seed;
+    xmss_adrs adrs;          // OTS address; each chain sets its own chain field
+    uint8_t **out;
+    uint8_t *const *in;
+    const uint8_t *digits;   // Chain i starts at digits[i] (NULL = 0)
+    int steps;               // Constant steps per chain, or -1 for w - 1 - digits[i]
+} wots_chains_job;
+
+// Evaluate chain i of a job
+static void wots_chain_item(void *ctx, int i) {
+    const wots_chains_job *job = ctx;
+    xmss_adrs adrs = job->adrs;
+    adrs_set_chain(&adrs, (uint32_t)i);
+    if (job->steps >= 0) {
+        int steps = job->digits ? job->digits[i] : job->steps;
+        job->params->kernels->chain_ct(job->params, job->pub_seed, &adrs, job->out[i], job->in[i], steps);
+    } else {
+        int start = job->digits[i];
+        wots_chain_public(job->params, job->pub_seed, &adrs, job->out[i], job->in[i], start,
+                          job->params->w - 1 - start);
     }
 }
 
+// Evaluate all chains of a job. Constant-time chains always cost w - 1 hashes each.
+static void wots_run_chains(wots_chains_job *job) {
+    long hashes = (long)job->params->wots_len * (job->params->w - 1);
+    xmss_parallel_for(job->params->wots_len, hashes, wots_chain_item, job);
+}
+
 // Compute pk from existing sk
-void wots_compute_pk(const xmss_params *params, WOTSKey *key) {
-    for (int i = 0; i < params->wots_len; i++) {
-        wots_chain_ct(key->pk[i], key->sk[i], 0, params->w - 1, params->w);
+void wots_compute_pk(const xmss_params *params, WOTSKey *key, const uint8_t *pub_seed, const xmss_adrs *ots_adrs) {
+    wots_chains_job job = { params, pub_seed, {{0}}, key->pk, key->sk, NULL, params->w - 1 };
+    wots_adrs(&job.adrs, ots_adrs);
+    wots_run_chains(&job);
+}
+
+// Digest the message and encode it into base-w digits (drawing the target-sum nonce into sig).
+// Returns 0, or -1 if a hash failed (nothing may be signed then).
+static int wots_encode(const xmss_params *params, const uint8_t *msg, size_t msg_len, WOTSSignature *sig,
+                       uint8_t *base_w_digits) {
+    uint8_t msg_hash[HASH_SIZE];
+    int r = xmss_hash(params, msg, msg_len, msg_hash, params->n);
+
+    if (r == 0 && params->encoding == WOTS_ENCODING_TARGET_SUM) {
+        // Rehash with fresh randomness until the digits hit the target sum
+        int hit;
+        do {
+            csprng_random_bytes(sig->nonce, WOTS_NONCE_BYTES);
+            hit = base_w_target_sum(msg_hash, sig->nonce, params, base_w_digits);
+        } while (hit == 0);
+        if (hit < 0) r = -1;
+    } else if (r == 0) {
+        params->kernels->base_w_checksum(params, msg_hash, base_w_digits);
     }
+    secure_zero_memory(msg_hash, params->n);
+    return r;
 }
 
 // Sign a message using WOTS
-void wots_sign(const xmss_params *params, const uint8_t *msg, size_t msg_len, WOTSKey *key, WOTSSignature *sig) {
-    uint8_t msg_hash[HASH_SIZE];
-    hash_shake256(msg, msg_len, msg_hash, HASH_SIZE);
+int wots_sign(const xmss_params *params, const uint8_t *msg, size_t msg_len, WOTSKey *key, WOTSSignature *sig,
+              const uint8_t *pub_seed, const xmss_adrs *ots_adrs) {
+    uint8_t base_w_digits[WOTS_LEN_MAX];
+    if (wots_encode(params, msg, msg_len, sig, base_w_digits) != 0) return -1;
 
-    uint8_t base_w_digits[params->wots_len];
-    base_w_and_checksum(msg_hash, params, base_w_digits);
+    wots_chains_job job = { params, pub_seed, {{0}}, sig->sig, key->sk, base_w_digits, 0 };
+    wots_adrs(&job.adrs, ots_adrs);
+    wots_run_chains(&job);
+    
+    secure_zero_memory(base_w_digits, sizeof(base_w_digits));
+    return 0;
+}
 
+// Walk every chain once and keep all w values (step j of chain i at table + (i*w + j)*n)
+void wots_precompute_chains(const xmss_params *params, const WOTSKey *key, uint8_t *table,
+                            const uint8_t *pub_seed, const xmss_adrs *ots_adrs) {
+    size_t n = params->n;
+    xmss_adrs adrs;
+    wots_adrs(&adrs, ots_adrs);
     for (int i = 0; i < params->wots_len; i++) {
-        wots_chain_ct(sig->sig[i], key->sk[i], 0, base_w_digits[i], params->w);
+        uint8_t *chain = table + (size_t)i * params->w * n;
+        adrs_set_chain(&adrs, (uint32_t)i);
+        memcpy(chain, key->sk[i], n);
+        for (int j = 1; j < params->w; j++) {
+            adrs_set_hash(&adrs, (uint32_t)(j - 1));
+            thash(params, pub_seed, &adrs, chain + (j - 1) * n, n, chain + j * n);
+        }
     }
-    
-    secure_zero_memory(msg_hash, HASH_SIZE);
+}
+
+// Sign from a precomputed chain table. Every chain scans all w entries, so the
+// memory access pattern does not depend on the digits.
+int wots_sign_precomputed(const xmss_params *params, const uint8_t *msg, size_t msg_len, const uint8_t *table,
+                          WOTSSignature *sig) {
+    size_t n = params->n;
+    uint8_t base_w_digits[WOTS_LEN_MAX];
+    if (wots_encode(params, msg, msg_len, sig, base_w_digits) != 0) return -1;
+
+    for (int i = 0; i < params->wots_len; i++) {
+        const uint8_t *chain = table + (size_t)i * params->w * n;
+        for (int j = 0; j < params->w; j++) {
+            uint32_t diff = (uint32_t)j ^ base_w_digits[i];
+            uint32_t mask = (uint32_t)0 - ((diff - 1) >> 31); // All 1s iff j == digit
+            conditional_select(sig->sig[i], chain + j * n, sig->sig[i], mask, n);
+        }
+    }
+
     secure_zero_memory(base_w_digits, sizeof(base_w_digits));
+    return 0;
 }
 
 
-// Verify a WOTS signature
-void wots_verify(const xmss_params *params, const uint8_t *msg, const WOTSSignature *sig, WOTSKey *pk_from_sig) {
+// Encode a message for verification. Returns 0 on success, -1 if the encoding is invalid.
+int wots_verify_digits(const xmss_params *params, const uint8_t *msg, const WOTSSignature *sig, uint8_t *digits) {
     uint8_t msg_hash[HASH_SIZE];
-    hash_shake256(msg, HASH_SIZE, msg_hash, HASH_SIZE);
-    
-    uint8_t base_w_digits[params->wots_len];
-    base_w_and_checksum(msg_hash, params, base_w_digits);
-    
-    for (int i = 0; i < params->wots_len; i++) {
-        int steps = params->w - 1 - base_w_digits[i];
-        wots_chain_ct(pk_from_sig->pk[i], sig->sig[i], base_w_digits[i], steps, params->w);
+    int ok = xmss_hash(params, msg, params->n, msg_hash, params->n) == 0;
+
+    if (ok && params->encoding == WOTS_ENCODING_TARGET_SUM) {
+        // A digit vector off the target sum could be comparable to a previous one, so reject it
+        ok = base_w_target_sum(msg_hash, sig->nonce, params, digits) == 1;
+    } else if (ok) {
+        params->kernels->base_w_checksum(params, msg_hash, digits);
     }
+    secure_zero_memory(msg_hash, params->n);
+    return ok ? 0 : -1;
+}
+
+// Finish every chain of a signature from its digits
+void wots_pk_from_digits(const xmss_params *params, const uint8_t *digits, const WOTSSignature *sig,
+                         WOTSKey *pk_from_sig, const uint8_t *pub_seed, const xmss_adrs *ots_adrs) {
+    wots_chains_job job = { params, pub_seed, {{0}}, pk_from_sig->pk, sig->sig, digits, -1 };
+    wots_adrs(&job.adrs, ots_adrs);
+    wots_run_chains(&job);
+}
 
-    secure_zero_memory(msg_hash, HASH_SIZE);
+// Verify a WOTS signature (recover the public key). Returns 0 on success, -1 if the encoding is invalid.
+int wots_verify(const xmss_params *params, const uint8_t *msg, const WOTSSignature *sig, WOTSKey *pk_from_sig,
+                const uint8_t *pub_seed, const xmss_adrs *ots_adrs) {
+    uint8_t base_w_digits[WOTS_LEN_MAX];
+    int ok = wots_verify_digits(params, msg, sig, base_w_digits) == 0;
+    if (ok) wots_pk_from_digits(params, base_w_digits, sig, pk_from_sig, pub_seed, ots_adrs);
     secure_zero_memory(base_w_digits, sizeof(base_w_digits));
+    return ok ? 0 : -1;
 }
 
 // VULNERABLE hash chain function. The number of loops depends on 'steps'.
-static void wots_chain_vulnerable(uint8_t out[HASH_SIZE], const uint8_t in[HASH_SIZE], int start, int steps) {
+static void wots_chain_vulnerable(uint8_t *out, const uint8_t *in, int start, int steps, size_t n) {
     uint8_t tmp[HASH_SIZE];
-    memcpy(tmp, in, HASH_SIZE);
+    memcpy(tmp, in, n);
     // The loop bound is data-dependent, which is the source of the timing leak.
     for (int i = start; i < start + steps; i++) {
-        hash_shake256(tmp, HASH_SIZE, tmp, HASH_SIZE);
+        hash_shake256(tmp, n, tmp, n);
     }
-    memcpy(out, tmp, HASH_SIZE);
+    memcpy(out, tmp, n);
 }
 
 // VULNERABLE WOTS sign function using the leaky hash chain.
 void wots_sign_vulnerable(const xmss_params *params, const uint8_t *msg, size_t msg_len, WOTSKey *key, WOTSSignature *sig) {
     uint8_t msg_hash[HASH_SIZE];
-    hash_shake256(msg, msg_len, msg_hash, HASH_SIZE);
+    xmss_hash(params, msg, msg_len, msg_hash, params->n);
 
-    uint8_t base_w_digits[params->wots_len];
+    uint8_t base_w_digits[WOTS_LEN_MAX];
     // This is a simplified base-w conversion for the PoC.
     // In a real attack, the attacker would use the proper checksummed base-w digits.
     for (int i = 0; i < params->wots_len; i++) {
-        base_w_digits[i] = msg_hash[i % HASH_SIZE] % params->w;
+        base_w_digits[i] = msg_hash[i % params->n] % params->w;
     }
 
     for (int i = 0; i < params->wots_len; i++) {
-        wots_chain_vulnerable(sig->sig[i], key->sk[i], 0, base_w_digits[i]);
+        wots_chain_vulnerable(sig->sig[i], key->sk[i], 0, base_w_digits[i], params->n);
     }
     
-    secure_zero_memory(msg_hash, HASH_SIZE);
+    secure_zero_memory(msg_hash, params->n);
     secure_zero_memory(base_w_digits, sizeof(base_w_digits));
 }
\ No newline at end of file
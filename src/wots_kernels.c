@@ -0,0 +1,145 @@
+// import standard libraries
+#include <string.h>
+
+// import project-specific headers
+#include "wots_kernels.h"
+#include "hash.h"
+#include "util.h"
+
+// ---------------------------------------------------------------------------
+// Generic kernels: w, n and the chain counts are read from params at runtime
+// ---------------------------------------------------------------------------
+
+// Compute WOTS chain with constant-time hashing
+static void chain_ct_generic(const xmss_params *params, const uint8_t *pub_seed, xmss_adrs *adrs,
+                             uint8_t *out, const uint8_t *in, int steps) {
+    size_t n = params->n;
+    uint8_t current_hash[HASH_SIZE];
+    uint8_t next_hash[HASH_SIZE];
+    memcpy(current_hash, in, n);
+
+    for (int i = 0; i < params->w - 1; i++) {
+        // Always compute the next hash to keep timing consistent
+        adrs_set_hash(adrs, (uint32_t)i);
+        thash(params, pub_seed, adrs, current_hash, n, next_hash);
+
+        // Conditionally select the next hash if we are within the desired step range
+        uint32_t mask = (uint32_t)0 - (uint32_t)(i < steps); // All 1s or all 0s
+        conditional_select(current_hash, next_hash, current_hash, mask, n);
+    }
+    memcpy(out, current_hash, n);
+
+    // Clean up stack variables
+    secure_zero_memory(current_hash, HASH_SIZE);
+    secure_zero_memory(next_hash, HASH_SIZE);
+}
+
+// Convert msg hash -> base-w digits and compute checksum
+static void base_w_checksum_generic(const xmss_params *params, const uint8_t *input, uint8_t *output) {
+    int in = 0;
+    int out = 0;
+    uint32_t total = 0;
+    int bits = 0;
+    uint32_t checksum = 0;
+
+    // Message part
+    for (int i = 0; i < params->wots_len1; i++) {
+        if (bits < params->log_w) {
+            total = (total << 8) | input[in++];
+            bits += 8;
+        }
+        bits -= params->log_w;
+        output[out++] = (total >> bits) & (params->w - 1);
+        checksum += params->w - 1 - output[i];
+    }
+
+    // Checksum part: wots_len2 * log_w bits always cover the largest checksum
+    for (int i = 0; i < params->wots_len2; i++) {
+        output[out++] = (checksum >> ((params->wots_len2 - 1 - i) * params->log_w)) & (params->w - 1);
+    }
+}
+
+static const wots_kernels kernels_generic = { 0, 0, chain_ct_generic, base_w_checksum_generic };
+
+// ---------------------------------------------------------------------------
+// Specialized kernels: every trip count, length and shift is a compile-time constant.
+// The hash mode is resolved once per chain, so the plain step loop never touches params.
+// Only defined for log_w dividing 8, so each input byte yields a whole number of digits.
+// ---------------------------------------------------------------------------
+
+#define DEFINE_WOTS_KERNELS(W, LOG_W, N, LEN1, LEN2)                                                   \
+static void chain_ct_w##W##_n##N(const xmss_params *params, const uint8_t *pub_seed, xmss_adrs *adrs,  \
+                                 uint8_t *out, const uint8_t *in, int steps) {                          \
+    uint8_t current_hash[N];                                                                            \
+    uint8_t next_hash[N];                                                                               \
+    memcpy(current_hash, in, N);                                                                        \
+                                                                                                        \
+    if (params->hash_mode == XMSS_HASH_TWEAKED) {                                                       \
+        for (int i = 0; i < (W) - 1; i++) {                                                             \
+            adrs_set_hash(adrs, (uint32_t)i);                                                           \
+            thash(params, pub_seed, adrs, current_hash, N, next_hash);                                  \
+            conditional_select(current_hash, next_hash, current_hash,                                   \
+                               (uint32_t)0 - (uint32_t)(i < steps), N);                                 \
+        }                                                                                               \
+    } else {                                                                                            \
+        for (int i = 0; i < (W) - 1; i++) {                                                             \
+            hash_shake256(current_hash, N, next_hash, N);                                               \
+            conditional_select(current_hash, next_hash, current_hash,                                   \
+                               (uint32_t)0 - (uint32_t)(i < steps), N);                                 \
+        }                                                                                               \
+    }                                                                                                   \
+    memcpy(out, current_hash, N);                                                                       \
+                                                                                                        \
+    secure_zero_memory(current_hash, N);                                                                \
+    secure_zero_memory(next_hash, N);                                                                   \
+}                                                                                                       \
+                                                                                                        \
+static void base_w_checksum_w##W##_n##N(const xmss_params *params, const uint8_t *input,               \
+                                        uint8_t *output) {                                              \
+    (void)params;                                                                                       \
+    uint32_t checksum = 0;                                                                              \
+    for (int i = 0; i < (N); i++) {                                                                     \
+        _Pragma("GCC unroll 8")                                                                         \
+        for (int j = 0; j < 8 / (LOG_W); j++) {                                                         \
+            uint8_t digit = (input[i] >> (8 - (LOG_W) * (j + 1))) & ((W) - 1);                          \
+            output[i * (8 / (LOG_W)) + j] = digit;                                                      \
+            checksum += (W) - 1 - digit;                                                                \
+        }                                                                                               \
+    }                                                                                                   \
+    _Pragma("GCC unroll 8")                                                                             \
+    for (int i = 0; i < (LEN2); i++) {                                                                  \
+        output[(LEN1) + i] = (checksum >> (((LEN2) - 1 - i) * (LOG_W))) & ((W) - 1);                    \
+    }                                                                                                   \
+}                                                                                                       \
+                                                                                                        \
+static const wots_kernels kernels_w##W##_n##N = {                                                      \
+    W, N, chain_ct_w##W##_n##N, base_w_checksum_w##W##_n##N                                             \
+};
+
+DEFINE_WOTS_KERNELS(4,   2, 32, 128, 5)
+DEFINE_WOTS_KERNELS(16,  4, 32, 64,  3)
+DEFINE_WOTS_KERNELS(256, 8, 32, 32,  2)
+
+// Specialized tables with the chain counts they were generated for
+static const struct {
+    const wots_kernels *kernels;
+    int len1;
+    int len2;
+} specialized[] = {
+    { &kernels_w4_n32,   128, 5 },
+    { &kernels_w16_n32,  64,  3 },
+    { &kernels_w256_n32, 32,  2 },
+};
+
+// Pick the specialized table for (w, n), or the generic one (always for backends other than SHAKE256)
+const wots_kernels *wots_kernels_select(const xmss_params *params) {
+    if (params->hash->id != HASH_BACKEND_SHAKE256) return &kernels_generic;
+    for (size_t i = 0; i < sizeof(specialized) / sizeof(specialized[0]); i++) {
+        const wots_kernels *k = specialized[i].kernels;
+        if (k->w == params->w && k->n == params->n &&
+            specialized[i].len1 == params->wots_len1 && specialized[i].len2 == params->wots_len2) {
+            return k;
+        }
+    }
+    return &kernels_generic;
+}
@@ -2,94 +2,139 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
 
 // import project-specific headers
 #include "xmss.h"
+#include "xmss_precomp.h"
+#include "xmss_pregen.h"
+#include "xmss_cache.h"
+#include "xmss_keygen.h"
+#include "xmss_parallel.h"
+#include "xmss_vcache.h"
+#include "xmss_pathcache.h"
+#include "xmss_secmem.h"
 #include "util.h"
 #include "csprng.h"
 
 // Allocate memory for WOTS signature
 int xmss_alloc_sig(XMSSSignature *sig, const xmss_params *params) {
+    return xmss_alloc_sig_arena(sig, params, NULL);
+}
+
+// Allocate a signature, from an arena if given. The auth path rows share one block with their pointers.
+int xmss_alloc_sig_arena(XMSSSignature *sig, const xmss_params *params, xmss_arena *arena) {
     if (!sig || !params) return -1;  // Defensive checks
 
     // Initialize the signature structure
-    sig->wots_sig = malloc(sizeof(WOTSSignature));
-    if (!sig->wots_sig || wots_alloc_sig(sig->wots_sig, params) != 0) {
-        free(sig->wots_sig);
+    sig->wots_sig = xmss_arena_get(arena, sizeof(WOTSSignature));
+    if (!sig->wots_sig || wots_alloc_sig_arena(sig->wots_sig, params, arena) != 0) {
+        xmss_arena_put(arena, sig->wots_sig);
         sig->wots_sig = NULL;
         return -1;
     }
 
     // Allocate memory for the authentication path
-    sig->auth_path = malloc(params->h * sizeof(uint8_t*));
+    size_t ptr_bytes = (size_t)params->h * sizeof(uint8_t*);
+    sig->auth_path = xmss_arena_get(arena, ptr_bytes + (size_t)params->h * params->n);
     if (!sig->auth_path) {
-        wots_free_sig(sig->wots_sig, params);
-        free(sig->wots_sig);
+        wots_free_sig_arena(sig->wots_sig, params, arena);
+        xmss_arena_put(arena, sig->wots_sig);
         sig->wots_sig = NULL;
         return -1;
     }
-
-    // Allocate memory for each authentication path element
-    for (int i = 0; i < params->h; i++) {
-        sig->auth_path[i] = malloc(HASH_SIZE);
-        if (!sig->auth_path[i]) {
-            for (int j = 0; j < i; j++) free(sig->auth_path[j]);
-            free(sig->auth_path);
-            sig->auth_path = NULL;
-            wots_free_sig(sig->wots_sig, params);
-            free(sig->wots_sig);
-            sig->wots_sig = NULL;
-            return -1;
-        }
-    }
+    for (int i = 0; i < params->h; i++) sig->auth_path[i] = (uint8_t *)sig->auth_path + ptr_bytes + (size_t)i * params->n;
 
     return 0;
 }
 
 // Free memory allocated for WOTS signature
 void xmss_free_sig(XMSSSignature *sig, const xmss_params *params) {
+    xmss_free_sig_arena(sig, params, NULL);
+}
+
+// Free a signature allocated with xmss_alloc_sig_arena()
+void xmss_free_sig_arena(XMSSSignature *sig, const xmss_params *params, xmss_arena *arena) {
     if (!sig) return;
 
     // Free the authentication path
     if (sig->auth_path) {
-        for (int i = 0; i < params->h; i++) {
-            free(sig->auth_path[i]);
-        }
-        free(sig->auth_path);
+        xmss_arena_put(arena, sig->auth_path);
         sig->auth_path = NULL;
     }
 
     // Free the WOTS signature
     if (sig->wots_sig) {
-        wots_free_sig(sig->wots_sig, params);
-        free(sig->wots_sig);
+        wots_free_sig_arena(sig->wots_sig, params, arena);
+        xmss_arena_put(arena, sig->wots_sig);
         sig->wots_sig = NULL;
     }
 }
 
+// Key in the secure heap
+XMSSKey *xmss_key_alloc(void) {
+    return xmss_secmem_alloc(sizeof(XMSSKey));
+}
+
+// Wipe and release a key from xmss_key_alloc()
+void xmss_key_free(XMSSKey *key) {
+    xmss_secmem_free(key);
+}
+
+// Compress a WOTS public key into its Merkle leaf
+static int compute_leaf(const xmss_params *params, const uint8_t *pub_seed, uint64_t index,
+                        const WOTSKey *wots_key, uint8_t *node) {
+    // The public key rows are one contiguous block after their pointers (wots_alloc_key_arena())
+    return xmss_compress_leaf(params, pub_seed, index, wots_key->pk[0], node);
+}
+
+// Compress a concatenated WOTS public key into its leaf
+int xmss_compress_leaf(const xmss_params *params, const uint8_t *pub_seed, uint64_t index,
+                       const uint8_t *pk_concat, uint8_t *node) {
+    xmss_adrs adrs;
+    adrs_init(&adrs);
+    adrs_set_type(&adrs, XMSS_ADDR_TYPE_LTREE);
+    adrs_set_ltree(&adrs, (uint32_t)index);
+    return thash(params, pub_seed, &adrs, pk_concat, params->wots_len * params->n, node);
+}
 
-// Compute the node hash for XMSS
-void compute_node(const xmss_params *params, uint8_t *node, XMSSKey *key, int height, uint64_t index);
+// Derive a pseudorandom filler for a subtree that lies entirely outside the activation window.
+// Inactive subtrees are never expanded, so keygen only pays for the active leaves plus O(h) fillers.
+void compute_inactive_node(const xmss_params *params, uint8_t *node, const XMSSKey *key, int height, uint64_t index) {
+    // PRF input: master_seed || 0xFF || height || index (distinct length from the leaf PRF input)
+    uint8_t buffer[XMSS_SEED_BYTES + 1 + sizeof(int) + sizeof(uint64_t)];
+    memcpy(buffer, key->seed, XMSS_SEED_BYTES);
+    buffer[XMSS_SEED_BYTES] = 0xFF;
+    memcpy(buffer + XMSS_SEED_BYTES + 1, &height, sizeof(int));
+    memcpy(buffer + XMSS_SEED_BYTES + 1 + sizeof(int), &index, sizeof(uint64_t));
+    xmss_hash(params, buffer, sizeof(buffer), node, params->n);
+    secure_zero_memory(buffer, sizeof(buffer));
+}
 
 // This function computes the node hash for a given height and index
 void compute_node(const xmss_params *params, uint8_t *node, XMSSKey *key, int height, uint64_t index) {
+    // Skip subtrees that do not intersect the activation window
+    if (!xmss_params_subtree_active(params, height, index)) {
+        compute_inactive_node(params, node, key, height, index);
+        return;
+    }
+
     if (height == 0) {
         WOTSKey wots_key;
+        xmss_arena *arena = xmss_arena_thread();
+        size_t mark = xmss_arena_begin(arena);
         
         // Generate WOTS key for the given index
-        if (wots_alloc_key(&wots_key, params) != 0) abort();
-        xmss_generate_wots_key(params, key, index, &wots_key);
-        wots_compute_pk(params, &wots_key);
+        if (wots_alloc_key_arena(&wots_key, params, arena) != 0) abort();
+        xmss_generate_wots_key(params, key, index, &wots_key); // also derives the public key
         
-        // Concatenate the public key parts into a single node
-        uint8_t *pk_concat = malloc(params->wots_len * HASH_SIZE);
-        if(!pk_concat) abort();
-        for(int i=0; i<params->wots_len; i++) memcpy(pk_concat + i*HASH_SIZE, wots_key.pk[i], HASH_SIZE);
-        hash_shake256(pk_concat, params->wots_len * HASH_SIZE, node, HASH_SIZE);
+        // Compress the public key parts into a single node
+        compute_leaf(params, key->pub_seed, index, &wots_key, node);
         
-        // Securely wipe the WOTS key
-        free(pk_concat);
-        wots_free_key(&wots_key, params);
+        // Release the WOTS key; the arena wipes it when the outermost operation ends
+        wots_free_key_arena(&wots_key, params, arena);
+        xmss_arena_end(arena, mark);
         return;
     }
 
@@ -98,145 +143,427 @@ void compute_node(const xmss_params *params, uint8_t *node, XMSSKey *key, int he
     compute_node(params, left, key, height - 1, index * 2);
     compute_node(params, right, key, height - 1, index * 2 + 1);
     
-    // Concatenate the left and right hashes and hash them together
-    uint8_t buffer[2 * HASH_SIZE];
-    memcpy(buffer, left, HASH_SIZE);
-    memcpy(buffer + HASH_SIZE, right, HASH_SIZE);
-    hash_shake256(buffer, 2 * HASH_SIZE, node, HASH_SIZE);
+    // Hash the left and right children together
+    thash_node(params, key->pub_seed, height, index, left, right, node);
 }
 
-// Generate a new XMSS key
-void xmss_keygen(const xmss_params *params, XMSSKey *key) {
+// Draw the secret seed (and the public seed in tweaked mode) of a new key
+void xmss_keygen_seeds(const xmss_params *params, XMSSKey *key) {
     csprng_random_bytes(key->seed, XMSS_SEED_BYTES);
+    memset(key->pub_seed, 0, XMSS_PUB_SEED_BYTES);
+    if (params->hash_mode == XMSS_HASH_TWEAKED) csprng_random_bytes(key->pub_seed, XMSS_PUB_SEED_BYTES);
+}
+
+// Build the root of a key whose seeds are set (only the activation window is expanded)
+void xmss_keygen_root(const xmss_params *params, XMSSKey *key) {
     compute_node(params, key->root, key, params->h, 0);
 }
 
+// Generate a new XMSS key
+void xmss_keygen(const xmss_params *params, XMSSKey *key) {
+    xmss_keygen_seeds(params, key);
+    xmss_keygen_root(params, key);
+}
+
+// Sibling subtrees of an auth path, split into equal parts of 2^part leaves for the worker pool
+typedef struct {
+    const xmss_params *params;
+    XMSSKey *key;
+    uint64_t idx;
+    int part;                // Height of one part
+    int first[33];           // First part of each split level (-1 = computed whole or cached)
+    uint8_t *nodes;          // Part roots
+} auth_path_job;
+
+// Compute one part: the node at height job->part inside the sibling subtree of some level
+static void auth_path_item(void *ctx, int i) {
+    auth_path_job *job = ctx;
+    int h = job->params->h - 1;
+    while (job->first[h] < 0 || job->first[h] > i) h--;
+    uint64_t sibling = (job->idx >> h) ^ 1;
+    uint64_t index = (sibling << (h - job->part)) + (uint64_t)(i - job->first[h]);
+    compute_node(job->params, job->nodes + (size_t)i * job->params->n, job->key, job->part, index);
+}
+
+// Hash split parts back up to the sibling node, with the same fillers as compute_node()
+static void auth_path_combine(const xmss_params *params, const XMSSKey *key, uint8_t *nodes,
+                              int part, int height, uint64_t sibling, uint8_t *out) {
+    for (int t = part + 1; t <= height; t++) {
+        uint64_t count = 1ULL << (height - t);
+        uint64_t base = sibling << (height - t);
+        for (uint64_t j = 0; j < count; j++) {
+            uint8_t *node = nodes + j * params->n;
+            if (xmss_params_subtree_active(params, t, base + j)) {
+                thash_node(params, key->pub_seed, t, base + j, nodes + 2 * j * params->n,
+                           nodes + (2 * j + 1) * params->n, node);
+            } else {
+                compute_inactive_node(params, node, key, t, base + j);
+            }
+        }
+    }
+    memcpy(out, nodes, params->n);
+}
+
+// Compute the authentication path (sibling nodes from the leaf up) of a leaf. With a worker
+// pool, uncached siblings above the part height are split into subtrees of equal size.
+void xmss_compute_auth_path(const xmss_params *params, XMSSKey *key, uint64_t idx, uint8_t **auth_path) {
+    const xmss_node_cache *cache = xmss_cache_for(params, key->root);
+    auth_path_job job = { params, key, idx, 0, {0}, NULL };
+    int parts = 0;
+    if (xmss_parallel_threads() > 0) {
+        // Aim for about four parts per thread on the largest sibling
+        int top = 0;
+        for (int h = 0; h < params->h; h++) {
+            if (!xmss_cache_node(cache, h, (idx >> h) ^ 1)) top = h;
+        }
+        int split = 0;
+        while ((1 << split) < 4 * (xmss_parallel_threads() + 1)) split++;
+        job.part = top > split ? top - split : 0;
+    }
+
+    for (int h = 0; h < params->h; h++) {
+        uint64_t sibling = (idx >> h) ^ 1;
+        const uint8_t *cached = xmss_cache_node(cache, h, sibling);
+        job.first[h] = -1;
+        if (cached) {
+            memcpy(auth_path[h], cached, params->n);
+        } else if (xmss_parallel_threads() == 0 || h <= job.part || !xmss_params_subtree_active(params, h, sibling)) {
+            compute_node(params, auth_path[h], key, h, sibling);
+        } else {
+            job.first[h] = parts;
+            parts += 1 << (h - job.part);
+        }
+    }
+    if (parts == 0) return;
+
+    xmss_arena *arena = xmss_arena_thread();
+    size_t mark = xmss_arena_begin(arena);
+    job.nodes = xmss_arena_get(arena, (size_t)parts * params->n);
+    if (!job.nodes) abort();
+    long hashes = (long)parts * (1L << job.part) * params->wots_len * params->w;
+    xmss_parallel_for(parts, hashes, auth_path_item, &job);
+    for (int h = 0; h < params->h; h++) {
+        if (job.first[h] < 0) continue;
+        auth_path_combine(params, key, job.nodes + (size_t)job.first[h] * params->n, job.part, h,
+                          (idx >> h) ^ 1, auth_path[h]);
+    }
+    xmss_arena_put(arena, job.nodes);
+    xmss_arena_end(arena, mark);
+}
+
 // Sign a message using XMSS
-void xmss_sign_index(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig, int idx) {
+int xmss_sign_index(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig, int idx) {
 
-    uint64_t max_keys = ((uint64_t)1) << params->h;
-    if (idx < 0 || (uint64_t)idx >= max_keys) return;
-    
-    sig->index = idx;
+    // Reject indices outside the tree or the activation window before doing any work
+    if (idx < 0 || !xmss_params_is_active(params, (uint64_t)idx)) return -1;
     
     uint8_t msg_hash[HASH_SIZE];
-    hash_shake256(msg, strlen((const char*)msg), msg_hash, HASH_SIZE);
-    
+    if (xmss_hash(params, msg, strlen((const char*)msg), msg_hash, params->n) != 0) return -1;
+    return xmss_sign_digest(params, msg_hash, key, sig, idx);
+}
+
+// Sign an n-byte message digest using XMSS
+int xmss_sign_digest(const xmss_params *params, const uint8_t *msg_hash, XMSSKey *key, XMSSSignature *sig, int idx) {
+    if (idx < 0 || !xmss_params_is_active(params, (uint64_t)idx)) return -1;
+
+    sig->index = idx;
+
+    // One arena operation: the WOTS key and every leaf of the auth path are wiped together at the end
+    xmss_arena *arena = xmss_arena_thread();
+    size_t mark = xmss_arena_begin(arena);
+
     WOTSKey wots_key;
-    if (wots_alloc_key(&wots_key, params) != 0) abort();
-    // Call the function which is now defined in xmss_wots.c
-    xmss_generate_wots_key(params, key, idx, &wots_key);
-    
-    wots_sign(params, msg_hash, HASH_SIZE, &wots_key, sig->wots_sig);
+    if (wots_alloc_key_arena(&wots_key, params, arena) != 0) abort();
+    // Call the function which is now defined in xmss_wots.c; a failed PRF or digest signs nothing
+    xmss_adrs ots_adrs;
+    xmss_ots_adrs(&ots_adrs, (uint64_t)idx);
+    int failed = xmss_generate_wots_key(params, key, idx, &wots_key) != 0 ||
+                 wots_sign(params, msg_hash, params->n, &wots_key, sig->wots_sig, key->pub_seed, &ots_adrs) != 0;
 
     // Securely wipe the one-time secret key after use
-    for(int i=0; i<params->wots_len; i++) secure_zero_memory(wots_key.sk[i], HASH_SIZE);
-    
-    uint64_t node_idx = idx;
-    for (int h = 0; h < params->h; h++) {
-        uint64_t sibling_idx = node_idx ^ 1;
-        compute_node(params, sig->auth_path[h], key, h, sibling_idx);
-        node_idx >>= 1;
+    for(int i=0; i<params->wots_len; i++) secure_zero_memory(wots_key.sk[i], params->n);
+    if (failed) {
+        wots_free_key_arena(&wots_key, params, arena);
+        xmss_arena_end(arena, mark);
+        return -1;
     }
+    
+    xmss_compute_auth_path(params, key, (uint64_t)idx, sig->auth_path);
 
-    wots_free_key(&wots_key, params);
+    wots_free_key_arena(&wots_key, params, arena);
+    xmss_arena_end(arena, mark);
+    return 0;
 }
 
-// Sign a message using XMSS with automatic key management
-void xmss_sign_auto(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig) {
+// Sign a message using XMSS with automatic key management. Leaves prepared in the
+// optional precompute pool are signed online; any other leaf takes the full path.
+int xmss_sign_auto(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig,
+                   xmss_precomp_pool *pool) {
     
     // Load the current index from the state file
     int current_index;
     if (xmss_load_state(&current_index) < 0) {
         fprintf(stderr, "Error reading XMSS state file\n");
-        exit(1);
+        return -1;
     }
 
-    int max_keys = 1 << params->h;
+    // Leaves before the activation window are never used
+    if ((uint64_t)current_index < params->act_start) current_index = (int)params->act_start;
 
-    // If the XMSS leaves are exhausted, generate a new keypair
-    if (current_index >=max_keys) {
+    // If the XMSS leaves are exhausted, switch to the pre-generated key or generate a new keypair
+    if (!xmss_params_is_active(params, (uint64_t)current_index) && xmss_pregen_rotate(params, key) == 1) {
+        printf("INFO: XMSS leaves exhausted. Switched to the pre-generated keypair.\n");
+        current_index = (int)params->act_start;
+    } else if (!xmss_params_is_active(params, (uint64_t)current_index)) {
+        // Build the new key with its node cache and install all three files like a pre-generated key
         printf("INFO: XMSS leaves exhausted. Generating new keypair...\n");
-        xmss_keygen(params, key);
-        if (xmss_save_key(key, params) != 0) {
+        xmss_node_cache cache = {0};
+        XMSSKey *next = xmss_key_alloc();
+        int ok = next && xmss_cache_init(&cache, params) == 0 &&
+                 xmss_keygen_resumable(params, next, &cache, NULL, 0) == 0 &&
+                 xmss_pregen_stage(params, next, &cache) == 0;
+        xmss_cache_free(&cache);
+        xmss_key_free(next);
+        if (!ok || xmss_pregen_rotate(params, key) != 1) {
             fprintf(stderr, "ERROR: Failed to save new XMSS key.\n");
-            exit(1);
+            return -1;
         }
-        current_index = 0;
-        xmss_save_state(0);
+        current_index = (int)params->act_start;
     }
 
-    // Sign the message with the current index and save the state
+    // Sign the message with the current index; the state only advances past a leaf that signed
     sig->index = current_index;
-    xmss_sign_index(params, msg, key, sig, current_index);
-    xmss_save_state(current_index + 1);
+    if (!pool || xmss_precomp_sign(pool, params, msg, key, sig, (uint64_t)current_index) != 0) {
+        if (xmss_sign_index(params, msg, key, sig, current_index) != 0) return -1;
+    }
+    if (xmss_save_state(current_index + 1) != 0) {
+        // The leaf may not be used again, so this signature must not be released either
+        fprintf(stderr, "ERROR: Failed to save XMSS state; discarding the signature.\n");
+        return -1;
+    }
+
+    // Start building the next key in the background once the usage threshold is crossed
+    xmss_pregen_check(params, (uint64_t)current_index + 1);
+    return 0;
 }
 
-// Verify a signed message using XMSS
-int xmss_verify(const xmss_params *params, const uint8_t *msg, XMSSSignature *sig, const uint8_t *root) {
-    
-    // Generate the message hash
-    uint8_t msg_hash[HASH_SIZE];
-    hash_shake256(msg, strlen((const char*)msg), msg_hash, HASH_SIZE);
+// Sign a message for an explicit epoch (leaf index) of the activation window
+int xmss_sign_epoch(const xmss_params *params, const uint8_t *msg, XMSSKey *key, XMSSSignature *sig, uint64_t epoch) {
+
+    // Epochs outside the activation window are rejected without computing anything
+    if (!xmss_params_is_active(params, epoch) || epoch > INT32_MAX) {
+        fprintf(stderr, "ERROR: Epoch %llu is outside the key's activation window [%llu, %llu).\n",
+                (unsigned long long)epoch, (unsigned long long)params->act_start,
+                (unsigned long long)(params->act_start + params->act_count));
+        return -1;
+    }
+
+    // The state file holds the next unused index, so epochs may only move forward
+    int next_index;
+    if (xmss_load_state(&next_index) < 0) {
+        fprintf(stderr, "Error reading XMSS state file\n");
+        return -1;
+    }
+    if (epoch < (uint64_t)next_index) {
+        fprintf(stderr, "ERROR: Epoch %llu has already been used or skipped (next usable epoch is %d).\n",
+                (unsigned long long)epoch, next_index);
+        return -1;
+    }
+
+    // Persist the state before signing so a crash can never reuse the leaf
+    if (xmss_save_state((int)epoch + 1) != 0) return -1;
+    return xmss_sign_index(params, msg, key, sig, (int)epoch);
+}
+
+// Verify a signature against the message digest
+static int verify_digest(const xmss_params *params, const uint8_t *msg_hash, XMSSSignature *sig, const uint8_t *root,
+                         const uint8_t *pub_seed) {
+
+    // A leaf outside the tree has no OTS address or auth path to check
+    if (sig->index < 0 || (uint64_t)sig->index >= params->max_keys) return 0;
 
     // Extract the WOTS public key from the signature
     WOTSKey wots_pk_from_sig;
-    if (wots_alloc_key(&wots_pk_from_sig, params) != 0) abort();
-    wots_verify(params, msg_hash, sig->wots_sig, &wots_pk_from_sig);
+    xmss_adrs ots_adrs;
+    xmss_arena *arena = xmss_arena_thread();
+    size_t mark = xmss_arena_begin(arena);
+    xmss_ots_adrs(&ots_adrs, (uint64_t)sig->index);
+    if (wots_alloc_key_arena(&wots_pk_from_sig, params, arena) != 0) abort();
+    if (wots_verify(params, msg_hash, sig->wots_sig, &wots_pk_from_sig, pub_seed, &ots_adrs) != 0) {
+        wots_free_key_arena(&wots_pk_from_sig, params, arena);
+        xmss_arena_end(arena, mark);
+        return 0;
+    }
     
+    // Compress the WOTS public key into the leaf node
     uint8_t node[HASH_SIZE];
-    uint8_t buffer[2 * HASH_SIZE];
-    
-    // Concatenate the WOTS public key parts into a single node
-    uint8_t *pk_concat = malloc(params->wots_len * HASH_SIZE);
-    if (!pk_concat) abort();
-    for(int i=0; i<params->wots_len; i++) memcpy(pk_concat + i*HASH_SIZE, wots_pk_from_sig.pk[i], HASH_SIZE);
-    hash_shake256(pk_concat, params->wots_len * HASH_SIZE, node, HASH_SIZE);
-    free(pk_concat);
-
-    // Calculate the root from the authentication path
+    int failed = compute_leaf(params, pub_seed, (uint64_t)sig->index, &wots_pk_from_sig, node);
+
+    // Calculate the root from the authentication path, stopping at a node already proven for this root
+    xmss_path_cache *proven = sig->index >= 0 && (uint64_t)sig->index < params->max_keys ?
+                              xmss_pathcache_for(params, root, pub_seed) : NULL;
+    uint8_t path[32][HASH_SIZE];
     uint64_t idx = sig->index;
-    for (int h = 0; h < params->h; h++) {
+    int valid = -1, h;
+    for (h = 0; h < params->h; h++) {
+        if (proven) {
+            valid = xmss_pathcache_check(proven, h, idx, node, sig->auth_path);
+            if (valid >= 0) break;
+            memcpy(path[h], node, params->n);
+        }
         if (idx & 1) {
-            memcpy(buffer, sig->auth_path[h], HASH_SIZE);
-            memcpy(buffer + HASH_SIZE, node, HASH_SIZE);
+            failed |= thash_node(params, pub_seed, h + 1, idx >> 1, sig->auth_path[h], node, node);
         } else {
-            memcpy(buffer, node, HASH_SIZE);
-            memcpy(buffer + HASH_SIZE, sig->auth_path[h], HASH_SIZE);
+            failed |= thash_node(params, pub_seed, h + 1, idx >> 1, node, sig->auth_path[h], node);
         }
-        hash_shake256(buffer, 2 * HASH_SIZE, node, HASH_SIZE);
         idx >>= 1;
     }
-    wots_free_key(&wots_pk_from_sig, params);
+    wots_free_key_arena(&wots_pk_from_sig, params, arena);
+    xmss_arena_end(arena, mark);
+
+    // Compare the computed root with the expected root (a failed hash never verifies)
+    if (failed) return 0;
+    if (valid < 0) valid = constant_time_equal(node, root, params->n);
+    if (proven && valid) xmss_pathcache_insert(proven, (uint64_t)sig->index, h, path, sig->auth_path);
+    return valid;
+}
+
+// Verify a signature, answering duplicates from the attached verified-signature cache
+int xmss_verify(const xmss_params *params, const uint8_t *msg, XMSSSignature *sig, const uint8_t *root,
+                const uint8_t *pub_seed) {
+
+    // Generate the message hash; a failed digest never verifies
+    uint8_t msg_hash[HASH_SIZE];
+    if (xmss_hash(params, msg, strlen((const char*)msg), msg_hash, params->n) != 0) return 0;
+
+    xmss_verify_cache *vcache = xmss_vcache_attached();
+    if (!vcache) return verify_digest(params, msg_hash, sig, root, pub_seed);
+
+    // Without a digest the cache is bypassed: every failed hash would share the zero key
+    uint8_t digest[HASH_SIZE];
+    if (xmss_vcache_digest(params, msg_hash, sig, root, pub_seed, digest) != 0) {
+        return verify_digest(params, msg_hash, sig, root, pub_seed);
+    }
+    int result = xmss_vcache_lookup(vcache, digest);
+    if (result < 0) {
+        result = verify_digest(params, msg_hash, sig, root, pub_seed);
+        xmss_vcache_insert(vcache, digest, result);
+    }
+    return result;
+}
+
+// One xmss_verify_batch() call
+typedef struct {
+    const xmss_params *params;
+    const uint8_t *const *msgs;
+    XMSSSignature *const *sigs;
+    const uint8_t *const *roots;
+    const uint8_t *const *pub_seeds;
+    int *results;
+} verify_batch_job;
+
+// Verify signature i of a batch
+static void verify_batch_item(void *ctx, int i) {
+    const verify_batch_job *job = ctx;
+    job->results[i] = xmss_verify(job->params, job->msgs[i], job->sigs[i], job->roots[i],
+                                  job->pub_seeds ? job->pub_seeds[i] : NULL);
+}
+
+// Verify several signatures under the same parameters, spread over the worker pool
+int xmss_verify_batch(const xmss_params *params, int count, const uint8_t *const *msgs, XMSSSignature *const *sigs,
+                      const uint8_t *const *roots, const uint8_t *const *pub_seeds, int *results) {
+    verify_batch_job job = { params, msgs, sigs, roots, pub_seeds, results };
+    long hashes = (long)count * params->wots_len * params->w / 2;
+    xmss_parallel_for(count, hashes, verify_batch_item, &job);
 
-    // Compare the computed root with the expected root
-    return memcmp(node, root, HASH_SIZE) == 0;
+    int valid = 0;
+    for (int i = 0; i < count; i++) valid += results[i];
+    return valid;
 }
 
-// Save the XMSS key to a file
+// Save the XMSS key to the default key file
 int xmss_save_key(const XMSSKey *key, const xmss_params *params) {
-    FILE *f = fopen(XMSS_KEY_FILE, "wb");
+    return xmss_save_key_file(XMSS_KEY_FILE, key, params);
+}
+
+// Finish an interrupted key rotation before reading the live files
+static int recover_rotation(void) {
+    int r = xmss_pregen_recover();
+    if (r < 0) fprintf(stderr, "ERROR: Could not finish the interrupted key rotation (%s exists).\n", XMSS_ROTATE_MARKER);
+    if (r > 0) printf("INFO: Finished an interrupted key rotation.\n");
+    return r < 0 ? -1 : 0;
+}
+
+// Load the XMSS key from the default key file
+int xmss_load_key(XMSSKey *key, xmss_params *params) {
+    if (recover_rotation() != 0) return -1;
+    return xmss_load_key_file(XMSS_KEY_FILE, key, params);
+}
+
+// Save the XMSS key to a file (owner-only, since it holds the seed)
+int xmss_save_key_file(const char *path, const XMSSKey *key, const xmss_params *params) {
+    FILE *f = fopen_private(path);
     if (!f) return -1;
+    uint32_t version = XMSS_KEY_VERSION;
 
-    // Write params first
-    if (fwrite(&params->h, sizeof(int), 1, f) != 1) { fclose(f); return -1; }
-    if (fwrite(&params->w, sizeof(int), 1, f) != 1) { fclose(f); return -1; }
+    // Write the header and params first
+    if (fwrite(XMSS_KEY_MAGIC, 4, 1, f) != 1 || fwrite(&version, sizeof(version), 1, f) != 1) { fclose(f); return -1; }
+    if (xmss_params_write(f, params) != 0) { fclose(f); return -1; }
+    if (fwrite(&params->act_start, sizeof(uint64_t), 1, f) != 1) { fclose(f); return -1; }
+    if (fwrite(&params->act_count, sizeof(uint64_t), 1, f) != 1) { fclose(f); return -1; }
     // Write key data
     if (fwrite(key, sizeof(XMSSKey), 1, f) != 1) { fclose(f); return -1; }
-    fclose(f);
-    return 0;
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+// Original headerless layout: int h, int w, seed, root (SHAKE256, n = 32)
+typedef struct {
+    int h, w;
+    uint8_t seed[XMSS_SEED_BYTES];
+    uint8_t root[HASH_SIZE];
+} xmss_legacy_key;
+
+// Migrate an original-format key file, or fail
+static int load_legacy_key(FILE *f, const char *path, XMSSKey *key, xmss_params *params) {
+    xmss_legacy_key legacy;
+    int ok = fseek(f, 0, SEEK_SET) == 0 && fread(&legacy, sizeof(legacy), 1, f) == 1 && fgetc(f) == EOF &&
+             xmss_params_init(params, legacy.h, legacy.w) == 0;
+    if (ok) {
+        memset(key, 0, sizeof(*key));
+        memcpy(key->seed, legacy.seed, XMSS_SEED_BYTES);
+        memcpy(key->root, legacy.root, HASH_SIZE);
+        fprintf(stderr, "Note: %s uses the original headerless key format (h=%d, w=%d); loaded as SHAKE256, n=32.\n",
+                path, legacy.h, legacy.w);
+    }
+    secure_zero_memory(&legacy, sizeof(legacy));
+    return ok ? 1 : -1;
 }
 
 // Load the XMSS key from a file
-int xmss_load_key(XMSSKey *key, xmss_params *params) {
-    FILE *f = fopen(XMSS_KEY_FILE, "rb");
+int xmss_load_key_file(const char *path, XMSSKey *key, xmss_params *params) {
+    FILE *f = fopen(path, "rb");
     if (!f) return 0;
-    int h, w;
-    if (fread(&h, sizeof(int), 1, f) != 1) { fclose(f); return -1; }
-    if (fread(&w, sizeof(int), 1, f) != 1) { fclose(f); return -1; }
+    char magic[4];
+    uint32_t version;
+    uint64_t act_start, act_count;
+
+    if (fread(magic, 4, 1, f) != 1 || memcmp(magic, XMSS_KEY_MAGIC, 4) != 0) {
+        int r = load_legacy_key(f, path, key, params);
+        if (r < 0) fprintf(stderr, "%s is not an XMSS key file\n", path);
+        fclose(f);
+        return r;
+    }
+    if (fread(&version, sizeof(version), 1, f) != 1 || version != XMSS_KEY_VERSION) {
+        fprintf(stderr, "%s: unsupported key file version\n", path);
+        fclose(f);
+        return -1;
+    }
 
     // Initialize params with the loaded values
-    if (xmss_params_init(params, h, w) != 0) {
+    if (xmss_params_read(f, params) != 0 ||
+        fread(&act_start, sizeof(uint64_t), 1, f) != 1 ||
+        fread(&act_count, sizeof(uint64_t), 1, f) != 1 ||
+        xmss_params_set_activation(params, act_start, act_count) != 0) {
         fprintf(stderr, "Failed to init params from key file\n");
         fclose(f);
         return -1;
@@ -248,18 +575,48 @@ int xmss_load_key(XMSSKey *key, xmss_params *params) {
     return 1;
 }
 
-// Load the XMSS state (current index) from a file
+// One signer at a time per process: the default state file and the CSPRNG are shared
+static pthread_mutex_t sign_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Take the process-wide signing lock
+void xmss_sign_lock(void) {
+    pthread_mutex_lock(&sign_lock);
+}
+
+// Release the process-wide signing lock
+void xmss_sign_unlock(void) {
+    pthread_mutex_unlock(&sign_lock);
+}
+
+// Load the XMSS state (current index) from the default state file
 int xmss_load_state(int *index) {
-    FILE *f = fopen(XMSS_STATE_FILE, "rb");
+    if (recover_rotation() != 0) return -1;
+    return xmss_load_state_file(XMSS_STATE_FILE, index);
+}
+
+// Load the XMSS state (current index) from a file
+int xmss_load_state_file(const char *path, int *index) {
+    FILE *f = fopen(path, "rb");
     if (!f) { *index = 0; return 0; }
     if (fread(index, sizeof(int), 1, f) != 1) { fclose(f); return -1; }
     fclose(f); return 1;
 }
 
-// Save the XMSS state (current index) to a file
+// Save the XMSS state (current index) to the default state file
 int xmss_save_state(int index) {
-    FILE *f = fopen(XMSS_STATE_FILE, "wb");
+    return xmss_save_state_file(XMSS_STATE_FILE, index);
+}
+
+// Save the XMSS state (current index) to a file. The index is written to a temporary file and
+// synced before it replaces the old state, so a crash leaves either the old or the new index.
+int xmss_save_state_file(const char *path, int index) {
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    FILE *f = fopen(tmp, "wb");
     if (!f) return -1;
-    fwrite(&index, sizeof(int), 1, f);
-    fclose(f); return 0;
+    int ok = fwrite(&index, sizeof(int), 1, f) == 1 && fsync_file(f) == 0;
+    if (fclose(f) != 0) ok = 0;
+    ok = ok && replace_file(tmp, path) == 0;
+    if (!ok) remove(tmp);
+    return ok ? 0 : -1;
 }
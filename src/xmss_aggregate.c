@@ -0,0 +1,173 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_aggregate.h"
+#include "xmss_eth.h"
+#include "xmss_parallel.h"
+#include "util.h"
+#include "wots_kernels.h"
+
+/* Little-endian u32 helpers */
+static void u32le_store(uint8_t b[4], uint32_t x) {
+    b[0] = (uint8_t)x; b[1] = (uint8_t)(x >> 8); b[2] = (uint8_t)(x >> 16); b[3] = (uint8_t)(x >> 24);
+}
+
+// Load a 32-bit unsigned integer from little-endian byte array
+static uint32_t u32le_load(const uint8_t b[4]) {
+    return ((uint32_t)b[0]) | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+// Allocate an aggregate of count signatures
+int xmss_aggregate_alloc(xmss_aggregate *agg, const xmss_params *params, int count) {
+    memset(agg, 0, sizeof(*agg));
+    if (count < 0) return -1;
+    agg->signers = calloc((size_t)count + 1, sizeof(uint32_t));
+    agg->sigs = calloc((size_t)count + 1, sizeof(XMSSSignature));
+    if (!agg->signers || !agg->sigs) {
+        xmss_aggregate_free(agg, params);
+        return -1;
+    }
+    for (; agg->count < count; agg->count++) {
+        if (xmss_alloc_sig(&agg->sigs[agg->count], params) != 0) {
+            xmss_aggregate_free(agg, params);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Free an aggregate
+void xmss_aggregate_free(xmss_aggregate *agg, const xmss_params *params) {
+    if (agg->sigs) {
+        for (int i = 0; i < agg->count; i++) xmss_free_sig(&agg->sigs[i], params);
+    }
+    free(agg->sigs);
+    free(agg->signers);
+    memset(agg, 0, sizeof(*agg));
+}
+
+// Serialize: count, signer positions, then the signatures in the Ethereum compact form
+int xmss_aggregate_serialize(const xmss_params *params, const xmss_aggregate *agg, uint8_t *out, size_t out_cap,
+                             size_t *out_len) {
+    size_t need = xmss_aggregate_size(params, agg->count);
+    size_t sig_size = xmss_eth_sig_size(params);
+    if (!out || out_cap < need) return -1;
+
+    u32le_store(out, (uint32_t)agg->count);
+    size_t pos = 4;
+    for (int i = 0; i < agg->count; i++, pos += 4) u32le_store(out + pos, agg->signers[i]);
+    for (int i = 0; i < agg->count; i++, pos += sig_size) {
+        if (xmss_eth_serialize(params, &agg->sigs[i], out + pos, sig_size, NULL) != 0) return -1;
+    }
+
+    if (out_len) *out_len = pos;
+    return 0;
+}
+
+// Parse a serialized aggregate
+int xmss_aggregate_deserialize(const xmss_params *params, xmss_aggregate *agg, const uint8_t *in, size_t in_len) {
+    size_t sig_size = xmss_eth_sig_size(params);
+    if (!in || in_len < 4) return -1;
+    uint32_t count = u32le_load(in);
+    if (count > (uint32_t)INT32_MAX || (in_len - 4) / (sig_size + 4) < count ||
+        in_len != xmss_aggregate_size(params, (int)count)) {
+        fprintf(stderr, "ERROR: xmss_aggregate_deserialize: input length %zu does not match the signature count\n", in_len);
+        return -1;
+    }
+    if (xmss_aggregate_alloc(agg, params, (int)count) != 0) return -1;
+
+    size_t pos = 4;
+    for (uint32_t i = 0; i < count; i++, pos += 4) agg->signers[i] = u32le_load(in + pos);
+    for (uint32_t i = 0; i < count; i++, pos += sig_size) {
+        xmss_params sig_params = *params;
+        if (xmss_eth_deserialize(&sig_params, &agg->sigs[i], in + pos, sig_size) != 0) {
+            xmss_aggregate_free(agg, params);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// One xmss_aggregate_verify() call
+typedef struct {
+    const xmss_params *params;
+    const uint8_t *msg_hash;
+    const uint8_t *digits;   // Shared digits, or NULL if every signature carries its own nonce
+    const xmss_aggregate *agg;
+    const xmss_key_registry *registry;
+    int32_t words[XMSS_PARAMS_WORDS];   // Parameter words every signer's key must have
+    int *results;
+} aggregate_job;
+
+// Verify signature i: finish its chains, compress the leaf and walk the auth path to the signer's root
+static void aggregate_item(void *ctx, int i) {
+    const aggregate_job *job = ctx;
+    const xmss_params *params = job->params;
+    const XMSSSignature *sig = &job->agg->sigs[i];
+    uint32_t signer = job->agg->signers[i];
+    size_t n = params->n;
+    job->results[i] = 0;
+    if (!xmss_key_registry_holds(job->registry, job->words, signer) || sig->index < 0 ||
+        (uint64_t)sig->index >= (1ULL << params->h)) {
+        return;
+    }
+
+    const uint8_t *root = xmss_key_registry_root(job->registry, params, signer);
+    const uint8_t *pub_seed = xmss_key_registry_pub_seed(job->registry, signer);
+
+    uint8_t digits[WOTS_LEN_MAX];
+    if (!job->digits) {
+        if (wots_verify_digits(params, job->msg_hash, sig->wots_sig, digits) != 0) return;
+    }
+
+    // The recovered chains land in one buffer, ready for leaf compression
+    uint8_t pk_concat[WOTS_LEN_MAX * HASH_SIZE];
+    uint8_t *rows[WOTS_LEN_MAX];
+    for (int c = 0; c < params->wots_len; c++) rows[c] = pk_concat + c * n;
+    WOTSKey pk = { NULL, rows };
+    xmss_adrs ots_adrs;
+    xmss_ots_adrs(&ots_adrs, (uint64_t)sig->index);
+    wots_pk_from_digits(params, job->digits ? job->digits : digits, sig->wots_sig, &pk, pub_seed, &ots_adrs);
+
+    uint8_t node[HASH_SIZE];
+    int failed = xmss_compress_leaf(params, pub_seed, (uint64_t)sig->index, pk_concat, node);
+    uint64_t idx = (uint64_t)sig->index;
+    for (int h = 0; h < params->h; h++, idx >>= 1) {
+        if (idx & 1) failed |= thash_node(params, pub_seed, h + 1, idx >> 1, sig->auth_path[h], node, node);
+        else failed |= thash_node(params, pub_seed, h + 1, idx >> 1, node, sig->auth_path[h], node);
+    }
+    job->results[i] = !failed && constant_time_equal(node, root, n);
+}
+
+// Verify an aggregate
+int xmss_aggregate_verify(const xmss_params *params, const uint8_t *msg, const xmss_aggregate *agg,
+                          const xmss_key_registry *registry, int *results) {
+    int *own = NULL;
+    if (!results) {
+        results = own = calloc((size_t)agg->count + 1, sizeof(int));
+        if (!results) return 0;
+    }
+
+    // Digest and encode the message once; without the target-sum nonce the digits are shared
+    uint8_t msg_hash[HASH_SIZE];
+    uint8_t digits[WOTS_LEN_MAX];
+    xmss_hash(params, msg, strlen((const char*)msg), msg_hash, params->n);
+    int shared = params->encoding != WOTS_ENCODING_TARGET_SUM;
+    if (shared && agg->count > 0) wots_verify_digits(params, msg_hash, agg->sigs[0].wots_sig, digits);
+
+    aggregate_job job = { params, msg_hash, shared ? digits : NULL, agg, registry, {0}, results };
+    xmss_params_encode(params, job.words);
+    long hashes = (long)agg->count * params->wots_len * params->w / 2;
+    xmss_parallel_for(agg->count, hashes, aggregate_item, &job);
+
+    int valid = agg->count > 0;
+    for (int i = 0; i < agg->count; i++) {
+        if (!results[i] || (i > 0 && agg->signers[i] <= agg->signers[i - 1])) valid = 0;
+    }
+    secure_zero_memory(digits, sizeof(digits));
+    free(own);
+    return valid;
+}
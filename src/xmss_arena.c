@@ -0,0 +1,103 @@
+// import standard libraries
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_arena.h"
+#include "util.h"
+
+#define ARENA_ALIGN 16
+
+// Per-thread arena
+static _Thread_local xmss_arena *thread_arena;
+
+// Set up an arena
+int xmss_arena_init(xmss_arena *arena, size_t cap) {
+    memset(arena, 0, sizeof(*arena));
+    arena->base = aligned_alloc(ARENA_ALIGN, (cap + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+    if (!arena->base) return -1;
+    arena->cap = cap;
+    return 0;
+}
+
+// Wipe and release an arena
+void xmss_arena_free(xmss_arena *arena) {
+    if (!arena || !arena->base) return;
+    xmss_arena_reset(arena);
+    free(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
+
+// Bump allocation
+void *xmss_arena_alloc(xmss_arena *arena, size_t bytes) {
+    size_t size = (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (!arena || !arena->base || size < bytes || size > arena->cap - arena->used) return NULL;
+    void *p = arena->base + arena->used;
+    arena->used += size;
+    if (arena->used > arena->high) arena->high = arena->used;
+    return p;
+}
+
+// Arena memory with a heap fallback. A heap block starts with a header holding its size, so
+// xmss_arena_put() can wipe it; the header keeps the returned pointer ARENA_ALIGN-aligned.
+void *xmss_arena_get(xmss_arena *arena, size_t bytes) {
+    void *p = xmss_arena_alloc(arena, bytes);
+    if (p || bytes > SIZE_MAX - ARENA_ALIGN) return p;
+    uint8_t *block = aligned_alloc(ARENA_ALIGN, (bytes + 2 * ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+    if (!block) return NULL;
+    memcpy(block, &bytes, sizeof(bytes));
+    return block + ARENA_ALIGN;
+}
+
+// Wipe and free heap fallbacks; arena blocks are left to xmss_arena_end()
+void xmss_arena_put(xmss_arena *arena, void *ptr) {
+    if (!ptr) return;
+    if (arena && arena->base && (uint8_t *)ptr >= arena->base && (uint8_t *)ptr < arena->base + arena->cap) return;
+    uint8_t *block = (uint8_t *)ptr - ARENA_ALIGN;
+    size_t bytes;
+    memcpy(&bytes, block, sizeof(bytes));
+    secure_zero_memory(block, ARENA_ALIGN + bytes);
+    free(block);
+}
+
+// Start an operation
+size_t xmss_arena_begin(const xmss_arena *arena) {
+    return arena ? arena->used : 0;
+}
+
+// End an operation: rewind, or wipe everything when the outermost one ends
+void xmss_arena_end(xmss_arena *arena, size_t mark) {
+    if (!arena) return;
+    if (mark == 0) xmss_arena_reset(arena);
+    else arena->used = mark;
+}
+
+// Wipe up to the high-water mark
+void xmss_arena_reset(xmss_arena *arena) {
+    if (!arena || !arena->base) return;
+    secure_zero_memory(arena->base, arena->high);
+    arena->used = 0;
+    arena->high = 0;
+}
+
+// The calling thread's arena
+xmss_arena *xmss_arena_thread(void) {
+    if (thread_arena) return thread_arena;
+    xmss_arena *arena = malloc(sizeof(*arena));
+    if (!arena) return NULL;
+    if (xmss_arena_init(arena, XMSS_ARENA_THREAD_BYTES) != 0) {
+        free(arena);
+        return NULL;
+    }
+    thread_arena = arena;
+    return arena;
+}
+
+// Wipe and free the calling thread's arena (worker threads call this before exiting)
+void xmss_arena_release_thread(void) {
+    if (!thread_arena) return;
+    xmss_arena_free(thread_arena);
+    free(thread_arena);
+    thread_arena = NULL;
+}
@@ -0,0 +1,126 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// import project-specific headers
+#include "xmss_async.h"
+#include "thash.h"
+#include "xmss_arena.h"
+
+// Queue: a bounded ring of pending jobs, served by a fixed set of workers
+struct xmss_async {
+    pthread_mutex_t lock;
+    pthread_cond_t  ready;      // Signalled when jobs are queued or on shutdown
+    xmss_async_job **ring;
+    int capacity;
+    int head;
+    int count;
+    int stop;
+    int threads;
+    pthread_t *workers;
+};
+
+// Report a finished job. The callback may free or reuse the job, so read notify_fd first.
+static void complete(xmss_async_job *job) {
+    int notify_fd = job->notify_fd;
+    if (job->done) job->done(job);
+    if (notify_fd >= 0) {
+        uint64_t one = 1;
+        if (write(notify_fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+            fprintf(stderr, "WARNING: Failed to notify completion of an async XMSS job\n");
+        }
+    }
+}
+
+// Worker: serve jobs until shutdown and an empty queue
+static void *async_worker(void *arg) {
+    xmss_async *q = arg;
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (q->count == 0 && !q->stop) pthread_cond_wait(&q->ready, &q->lock);
+        if (q->count == 0) {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        // One job at a time, so queued verifies spread over every worker
+        xmss_async_job *job = q->ring[q->head];
+        q->head = (q->head + 1) % q->capacity;
+        q->count--;
+        pthread_mutex_unlock(&q->lock);
+
+        if (job->op == XMSS_ASYNC_VERIFY) {
+            job->result = xmss_verify(job->params, job->msg, job->sig, job->root, job->pub_seed);
+        } else {
+            // Signing advances the state file and draws from the CSPRNG: one signer per process
+            xmss_sign_lock();
+            job->result = xmss_sign_auto(job->params, job->msg, job->key, job->sig, NULL);
+            xmss_sign_unlock();
+        }
+        complete(job);
+    }
+    thash_release_thread_state();
+    xmss_arena_release_thread();
+    return NULL;
+}
+
+// Start a queue and its workers
+xmss_async *xmss_async_create(int threads, int capacity) {
+    if (threads <= 0 || capacity <= 0) return NULL;
+    xmss_async *q = calloc(1, sizeof(xmss_async));
+    if (!q) return NULL;
+    q->ring = calloc((size_t)capacity, sizeof(xmss_async_job *));
+    q->workers = calloc((size_t)threads, sizeof(pthread_t));
+    if (!q->ring || !q->workers) {
+        free(q->ring);
+        free(q->workers);
+        free(q);
+        return NULL;
+    }
+    q->capacity = capacity;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->ready, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&q->workers[i], NULL, async_worker, q) != 0) break;
+        q->threads++;
+    }
+    if (q->threads == 0) {
+        xmss_async_destroy(q);
+        return NULL;
+    }
+    return q;
+}
+
+// Queue a job without blocking
+int xmss_async_submit(xmss_async *q, xmss_async_job *job) {
+    if (job->op != XMSS_ASYNC_SIGN && job->op != XMSS_ASYNC_VERIFY) return -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->stop || q->count == q->capacity) {
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+    q->ring[(q->head + q->count) % q->capacity] = job;
+    q->count++;
+    pthread_cond_signal(&q->ready);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+// Drain the queue, stop the workers and free everything
+void xmss_async_destroy(xmss_async *q) {
+    if (!q) return;
+    pthread_mutex_lock(&q->lock);
+    q->stop = 1;
+    pthread_cond_broadcast(&q->ready);
+    pthread_mutex_unlock(&q->lock);
+    for (int i = 0; i < q->threads; i++) pthread_join(q->workers[i], NULL);
+
+    pthread_cond_destroy(&q->ready);
+    pthread_mutex_destroy(&q->lock);
+    free(q->workers);
+    free(q->ring);
+    free(q);
+}
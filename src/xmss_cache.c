@@ -0,0 +1,111 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_cache.h"
+
+// Cache attached for auth path computation, and the calling thread's own attachment
+static const xmss_node_cache *attached;
+static _Thread_local const xmss_node_cache *thread_attached;
+
+// Lowest cached height: all levels for small trees, the top XMSS_CACHE_LEVELS otherwise
+int xmss_cache_base(const xmss_params *params) {
+    return params->h > XMSS_CACHE_LEVELS ? params->h - XMSS_CACHE_LEVELS : 0;
+}
+
+// Number of cached nodes: 2^(h-base+1) - 1
+static uint64_t cache_count(const xmss_node_cache *cache) {
+    return (1ULL << (cache->h - cache->base + 1)) - 1;
+}
+
+// Size of the node array in bytes
+size_t xmss_cache_bytes(const xmss_node_cache *cache) {
+    return (size_t)cache_count(cache) * cache->n;
+}
+
+// Allocate an empty cache for the given parameters
+int xmss_cache_init(xmss_node_cache *cache, const xmss_params *params) {
+    memset(cache, 0, sizeof(*cache));
+    cache->h = params->h;
+    cache->n = params->n;
+    cache->base = xmss_cache_base(params);
+    cache->nodes = calloc((size_t)cache_count(cache), (size_t)cache->n);
+    return cache->nodes ? 0 : -1;
+}
+
+// Free the cache (and detach it if attached)
+void xmss_cache_free(xmss_node_cache *cache) {
+    if (!cache) return;
+    if (attached == cache) attached = NULL;
+    free(cache->nodes);
+    cache->nodes = NULL;
+}
+
+// Height t starts after the 2^(h-base+1) - 2^(h-t+1) nodes of the levels below it
+uint8_t *xmss_cache_node(const xmss_node_cache *cache, int height, uint64_t index) {
+    if (!cache || !cache->nodes || height < cache->base || height > cache->h) return NULL;
+    uint64_t offset = (1ULL << (cache->h - cache->base + 1)) - (1ULL << (cache->h - height + 1));
+    return cache->nodes + (size_t)(offset + index) * cache->n;
+}
+
+// Save the cache to a file
+int xmss_cache_save(const char *path, const xmss_node_cache *cache, const xmss_params *params) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int ok = xmss_params_write(f, params) == 0 &&
+             fwrite(&params->act_start, sizeof(uint64_t), 1, f) == 1 &&
+             fwrite(&params->act_count, sizeof(uint64_t), 1, f) == 1 &&
+             fwrite(&cache->base, sizeof(int), 1, f) == 1 &&
+             fwrite(cache->root, 1, cache->n, f) == (size_t)cache->n &&
+             fwrite(cache->nodes, 1, xmss_cache_bytes(cache), f) == xmss_cache_bytes(cache);
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+// Load a cache written for the same parameters. Returns 1 on success, 0 if there is no cache file, -1 on error.
+int xmss_cache_load(const char *path, xmss_node_cache *cache, const xmss_params *params) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+
+    xmss_params file_params;
+    uint64_t act_start, act_count;
+    int base;
+    if (xmss_params_read(f, &file_params) != 0 ||
+        fread(&act_start, sizeof(uint64_t), 1, f) != 1 ||
+        fread(&act_count, sizeof(uint64_t), 1, f) != 1 ||
+        xmss_params_set_activation(&file_params, act_start, act_count) != 0 ||
+        fread(&base, sizeof(int), 1, f) != 1 ||
+        !xmss_params_equal(&file_params, params) || base != xmss_cache_base(params) ||
+        xmss_cache_init(cache, params) != 0) {
+        fclose(f);
+        return -1;
+    }
+
+    int ok = fread(cache->root, 1, cache->n, f) == (size_t)cache->n &&
+             fread(cache->nodes, 1, xmss_cache_bytes(cache), f) == xmss_cache_bytes(cache);
+    fclose(f);
+    if (!ok) {
+        xmss_cache_free(cache);
+        return -1;
+    }
+    return 1;
+}
+
+// Attach a cache for auth path computation
+void xmss_cache_use(const xmss_node_cache *cache) {
+    attached = cache;
+}
+
+// Attach a cache for the calling thread
+void xmss_cache_use_thread(const xmss_node_cache *cache) {
+    thread_attached = cache;
+}
+
+// The attached cache, if it was built for this key (the thread's own attachment first)
+const xmss_node_cache *xmss_cache_for(const xmss_params *params, const uint8_t *root) {
+    const xmss_node_cache *cache = thread_attached ? thread_attached : attached;
+    if (!cache || cache->h != params->h || cache->n != params->n) return NULL;
+    return memcmp(cache->root, root, params->n) == 0 ? cache : NULL;
+}
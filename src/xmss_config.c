@@ -5,6 +5,7 @@
 // import project-specific headers
 #include "xmss_config.h"
 #include "hash.h"
+#include "wots_kernels.h"
 
 // Helper to calculate log2 for integer powers of 2
 int int_log2(int n) {
@@ -17,6 +18,19 @@ int int_log2(int n) {
     return log;
 }
 
+// Derive the WOTS+ chain counts from n and w
+static void compute_wots_lengths(xmss_params *params) {
+    params->wots_len1 = (8 * params->n) / params->log_w;
+    int checksum_bits = params->wots_len1 * (params->w - 1);
+    int checksum_log = 0;
+    if (checksum_bits > 0) {
+        checksum_log = (int)floor(log2(checksum_bits)) + 1;
+    }
+    params->wots_len2 = (checksum_log + params->log_w - 1) / params->log_w;
+    params->wots_len = params->wots_len1 + params->wots_len2;
+    params->kernels = wots_kernels_select(params);
+}
+
 // Initialize XMSS parameters
 int xmss_params_init(xmss_params *params, int h, int w) {
     if (h <= 0 || h > 32) {
@@ -25,23 +39,161 @@ int xmss_params_init(xmss_params *params, int h, int w) {
     }
     params->h = h;
     params->max_keys = 1ULL << h;
+    params->act_start = 0;
+    // Leaf indices and the state file are int: an h = 32 tree can only sign its first 2^31 leaves
+    params->act_count = params->max_keys < XMSS_MAX_SIGN_LEAVES ? params->max_keys : XMSS_MAX_SIGN_LEAVES;
 
     params->log_w = int_log2(w);
-    if (params->log_w == -1) {
-        fprintf(stderr, "Invalid Winternitz parameter w=%d. Must be a power of 2.\n", w);
+    if (params->log_w <= 0 || w > 256) {
+        fprintf(stderr, "Invalid Winternitz parameter w=%d. Must be a power of 2 in [2, 256].\n", w);
         return -1;
     }
     params->w = w;
+    params->n = HASH_SIZE;
+    params->hash = hash_backend_get(HASH_BACKEND_SHAKE256);
 
     // Calculate WOTS+ lengths
-    params->wots_len1 = (8 * HASH_SIZE) / params->log_w;
-    int checksum_bits = params->wots_len1 * (w - 1);
-    int checksum_log = 0;
-    if (checksum_bits > 0) {
-        checksum_log = (int)floor(log2(checksum_bits)) + 1;
+    compute_wots_lengths(params);
+
+    params->encoding = WOTS_ENCODING_CHECKSUM;
+    params->target_sum = 0;
+    params->hash_mode = XMSS_HASH_PLAIN;
+
+    return 0;
+}
+
+// Select the hash output length and recompute the chain counts
+int xmss_params_set_n(xmss_params *params, int n) {
+    if (n != 16 && n != 24 && n != 32) {
+        fprintf(stderr, "Invalid hash length n=%d. Must be 16, 24 or 32.\n", n);
+        return -1;
+    }
+    params->n = n;
+    compute_wots_lengths(params);
+    return xmss_params_set_encoding(params, params->encoding, 0);
+}
+
+// Select the WOTS+ encoding and recompute the chain count
+int xmss_params_set_encoding(xmss_params *params, int encoding, int target_sum) {
+    int max_sum = params->wots_len1 * (params->w - 1);
+
+    if (encoding == WOTS_ENCODING_CHECKSUM) {
+        params->encoding = encoding;
+        params->target_sum = 0;
+        params->wots_len = params->wots_len1 + params->wots_len2;
+        return 0;
     }
-    params->wots_len2 = (checksum_log + params->log_w - 1) / params->log_w;
-    params->wots_len = params->wots_len1 + params->wots_len2;
 
+    if (encoding != WOTS_ENCODING_TARGET_SUM) {
+        fprintf(stderr, "Invalid WOTS+ encoding %d.\n", encoding);
+        return -1;
+    }
+
+    // Target-sum drops the checksum chains; the digit sum is fixed instead.
+    // The default sits one standard deviation above the mean digit sum, which trims the
+    // verifier's remaining chain steps at the cost of a few more (cheap) signer rehashes.
+    double sigma = sqrt(params->wots_len1 * ((double)params->w * params->w - 1) / 12.0);
+    int mean = (max_sum + 1) / 2;
+    if (target_sum == 0) target_sum = mean + (int)sigma;
+
+    // Targets far from the mean would make the signer's rehashing loop practically endless
+    int lo = mean - (int)(3 * sigma), hi = mean + (int)(3 * sigma);
+    if (lo < 0) lo = 0;
+    if (hi > max_sum) hi = max_sum;
+    if (target_sum < lo || target_sum > hi) {
+        fprintf(stderr, "Invalid target sum %d. Must be in [%d, %d] for w=%d.\n", target_sum, lo, hi, params->w);
+        return -1;
+    }
+    params->encoding = encoding;
+    params->target_sum = target_sum;
+    params->wots_len = params->wots_len1;
     return 0;
-}
\ No newline at end of file
+}
+
+// Select the hash mode
+int xmss_params_set_hash_mode(xmss_params *params, int hash_mode) {
+    if (hash_mode != XMSS_HASH_PLAIN && hash_mode != XMSS_HASH_TWEAKED) {
+        fprintf(stderr, "Invalid hash mode %d.\n", hash_mode);
+        return -1;
+    }
+    params->hash_mode = hash_mode;
+    return 0;
+}
+
+// Select the hash backend; the specialized kernels are SHAKE256-only, so the kernels are re-selected
+int xmss_params_set_hash_backend(xmss_params *params, int backend) {
+    const hash_backend *hash = hash_backend_get(backend);
+    if (!hash) {
+        fprintf(stderr, "Invalid hash backend %d.\n", backend);
+        return -1;
+    }
+    params->hash = hash;
+    params->kernels = wots_kernels_select(params);
+    return 0;
+}
+
+// Encode the parameter header as words
+void xmss_params_encode(const xmss_params *params, int32_t words[XMSS_PARAMS_WORDS]) {
+    words[0] = params->h;
+    words[1] = params->w;
+    words[2] = params->n;
+    words[3] = params->encoding;
+    words[4] = params->target_sum;
+    words[5] = params->hash_mode | (params->hash->id << 8);
+}
+
+// Initialize the parameter structure from header words
+int xmss_params_decode(xmss_params *params, const int32_t words[XMSS_PARAMS_WORDS]) {
+    if (xmss_params_init(params, words[0], words[1]) != 0) return -1;
+    if (xmss_params_set_n(params, words[2]) != 0) return -1;
+    if (words[3] == WOTS_ENCODING_TARGET_SUM && words[4] == 0) return -1;
+    if (xmss_params_set_encoding(params, words[3], words[4]) != 0) return -1;
+    if (xmss_params_set_hash_backend(params, words[5] >> 8) != 0) return -1;
+    return xmss_params_set_hash_mode(params, words[5] & 0xFF);
+}
+
+// Write the parameter header shared by key and signature files
+int xmss_params_write(FILE *f, const xmss_params *params) {
+    int32_t words[XMSS_PARAMS_WORDS];
+    xmss_params_encode(params, words);
+    return fwrite(words, sizeof(int32_t), XMSS_PARAMS_WORDS, f) == XMSS_PARAMS_WORDS ? 0 : -1;
+}
+
+// Read the parameter header and initialize the parameter structure from it
+int xmss_params_read(FILE *f, xmss_params *params) {
+    int32_t words[XMSS_PARAMS_WORDS];
+    if (fread(words, sizeof(int32_t), XMSS_PARAMS_WORDS, f) != XMSS_PARAMS_WORDS) return -1;
+    return xmss_params_decode(params, words);
+}
+
+// Restrict the key to an activation window of leaves (epochs)
+int xmss_params_set_activation(xmss_params *params, uint64_t start, uint64_t count) {
+    uint64_t limit = params->max_keys < XMSS_MAX_SIGN_LEAVES ? params->max_keys : XMSS_MAX_SIGN_LEAVES;
+    if (count == 0 || start >= limit || count > limit - start) {
+        fprintf(stderr, "Invalid activation window [%llu, %llu). Must be non-empty and within [0, %llu).\n",
+                (unsigned long long)start, (unsigned long long)(start + count), (unsigned long long)limit);
+        return -1;
+    }
+    params->act_start = start;
+    params->act_count = count;
+    return 0;
+}
+
+// Check whether a leaf index lies inside the activation window
+int xmss_params_is_active(const xmss_params *params, uint64_t index) {
+    return index >= params->act_start && index - params->act_start < params->act_count;
+}
+
+// Check whether the subtree at (height, index) contains at least one leaf of the activation window
+int xmss_params_subtree_active(const xmss_params *params, int height, uint64_t index) {
+    uint64_t first_leaf = index << height;
+    uint64_t last_leaf  = first_leaf + (1ULL << height) - 1;
+    return !(last_leaf < params->act_start || first_leaf >= params->act_start + params->act_count);
+}
+
+// Compare everything that determines a key's tree (two keys are interchangeable only if this holds)
+int xmss_params_equal(const xmss_params *a, const xmss_params *b) {
+    return a->h == b->h && a->w == b->w && a->n == b->n && a->encoding == b->encoding &&
+           a->target_sum == b->target_sum && a->hash_mode == b->hash_mode && a->hash->id == b->hash->id &&
+           a->act_start == b->act_start && a->act_count == b->act_count;
+}
@@ -28,14 +28,20 @@ int xmss_eth_serialize(const xmss_params *params, const XMSSSignature *sig,
     u32le_store(out, (uint32_t)sig->index);
     size_t pos = 4;
 
+    // Target-sum signatures carry the randomizer used for message rehashing
+    if (params->encoding == WOTS_ENCODING_TARGET_SUM) {
+        memcpy(out + pos, sig->wots_sig->nonce, WOTS_NONCE_BYTES);
+        pos += WOTS_NONCE_BYTES;
+    }
+
     for (int i = 0; i < params->wots_len; i++) {
-        memcpy(out + pos, sig->wots_sig->sig[i], HASH_SIZE);
-        pos += HASH_SIZE;
+        memcpy(out + pos, sig->wots_sig->sig[i], params->n);
+        pos += params->n;
     }
 
     for (int i = 0; i < params->h; i++) {
-        memcpy(out + pos, sig->auth_path[i], HASH_SIZE);
-        pos += HASH_SIZE;
+        memcpy(out + pos, sig->auth_path[i], params->n);
+        pos += params->n;
     }
 
     if (out_len) *out_len = pos;
@@ -57,14 +63,19 @@ int xmss_eth_deserialize(xmss_params *params, XMSSSignature *sig,
     sig->index = (int)u32le_load(in + pos);
     pos += 4;
 
+    if (params->encoding == WOTS_ENCODING_TARGET_SUM) {
+        memcpy(sig->wots_sig->nonce, in + pos, WOTS_NONCE_BYTES);
+        pos += WOTS_NONCE_BYTES;
+    }
+
     for (int i = 0; i < params->wots_len; i++) {
-        memcpy(sig->wots_sig->sig[i], in + pos, HASH_SIZE);
-        pos += HASH_SIZE;
+        memcpy(sig->wots_sig->sig[i], in + pos, params->n);
+        pos += params->n;
     }
 
     for (int i = 0; i < params->h; i++) {
-        memcpy(sig->auth_path[i], in + pos, HASH_SIZE);
-        pos += HASH_SIZE;
+        memcpy(sig->auth_path[i], in + pos, params->n);
+        pos += params->n;
     }
     return 0;
 }
@@ -86,41 +97,25 @@ int xmss_eth_save_sig(const char *path, const XMSSSignature *sig, const xmss_par
 
     printf("Loaded key (h=%d, w=%d)\n", params->h, params->w);
     
-    // Write params first, then the signature data
+    // Write the header and params first, then the signature data
+    uint32_t version = XMSS_SIG_VERSION;
     int ok = 1;
-    if (fwrite(&params->h, sizeof(int), 1, f) != 1) ok = 0;
-    if (ok && fwrite(&params->w, sizeof(int), 1, f) != 1) ok = 0;
+    if (fwrite(XMSS_SIG_MAGIC, 4, 1, f) != 1 || fwrite(&version, sizeof(version), 1, f) != 1) ok = 0;
+    if (ok && xmss_params_write(f, params) != 0) ok = 0;
     if (ok && fwrite(buf, written, 1, f) != 1) ok = 0;
     
-    fclose(f);
+    if (fclose(f) != 0) ok = 0;
     free(buf);
     return ok ? 0 : -1;
 }
 
-// Load the Ethereum compact format from a file
-int xmss_eth_load_sig(const char *path, XMSSSignature *sig, xmss_params *params) {
-    FILE *f = fopen(path, "rb");
-    if (!f) return 0; /* not found */
-
-    int h, w;
-    if (fread(&h, sizeof(int), 1, f) != 1) { fclose(f); return -1; }
-    if (fread(&w, sizeof(int), 1, f) != 1) { fclose(f); return -1; }
-
-    printf("Loaded key (h=%d, w=%d)\n", h, w);
-
-    if (xmss_params_init(params, h, w) != 0) {
-        fprintf(stderr, "Failed to init params from signature file\n");
-        fclose(f);
-        return -1;
-    }
-
+// Read the rest of the file as one signature for params
+static int load_sig_payload(FILE *f, XMSSSignature *sig, xmss_params *params) {
     size_t need = xmss_eth_sig_size(params);
-    uint8_t *buf = malloc(need);
-    if (!buf) { fclose(f); return -1; }
+    uint8_t *buf = malloc(need + 1);
+    if (!buf) return -1;
 
     size_t got = fread(buf, 1, need + 1, f); // Read one extra byte to check for trailing data
-    fclose(f);
-
     if (got != need) {
         fprintf(stderr, "ERROR: Signature file size mismatch. Got %zu, expected %zu.\n", got, need);
         free(buf);
@@ -135,6 +130,45 @@ int xmss_eth_load_sig(const char *path, XMSSSignature *sig, xmss_params *params)
 
     int result = xmss_eth_deserialize(params, sig, buf, got);
     free(buf);
-    
     return (result == 0) ? 1 : -1;
-}
\ No newline at end of file
+}
+
+// Migrate an original-format signature file (int h, int w, then a SHAKE256, n = 32 signature), or fail
+static int load_legacy_sig(FILE *f, const char *path, XMSSSignature *sig, xmss_params *params) {
+    int hw[2];
+    long size;
+    if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0 ||
+        fread(hw, sizeof(int), 2, f) != 2 || xmss_params_init(params, hw[0], hw[1]) != 0 ||
+        (size_t)size != sizeof(hw) + xmss_eth_sig_size(params)) {
+        fprintf(stderr, "%s is not an XMSS signature file (no %s header, and not the original layout)\n",
+                path, XMSS_SIG_MAGIC);
+        return -1;
+    }
+    fprintf(stderr, "Note: %s uses the original headerless signature format (h=%d, w=%d); loaded as SHAKE256, n=32.\n",
+            path, hw[0], hw[1]);
+    return load_sig_payload(f, sig, params);
+}
+
+// Load the Ethereum compact format from a file
+int xmss_eth_load_sig(const char *path, XMSSSignature *sig, xmss_params *params) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0; /* not found */
+
+    char magic[4];
+    uint32_t version;
+    int r;
+    if (fread(magic, 4, 1, f) != 1 || memcmp(magic, XMSS_SIG_MAGIC, 4) != 0) {
+        r = load_legacy_sig(f, path, sig, params);
+    } else if (fread(&version, sizeof(version), 1, f) != 1 || version != XMSS_SIG_VERSION) {
+        fprintf(stderr, "%s: unsupported signature file version\n", path);
+        r = -1;
+    } else if (xmss_params_read(f, params) != 0) {
+        fprintf(stderr, "Failed to init params from signature file\n");
+        r = -1;
+    } else {
+        printf("Loaded key (h=%d, w=%d)\n", params->h, params->w);
+        r = load_sig_payload(f, sig, params);
+    }
+    fclose(f);
+    return r;
+}
@@ -0,0 +1,200 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_keygen.h"
+#include "thash.h"
+#include "util.h"
+
+// Start a treehash at the given leaf
+void xmss_treehash_init(xmss_treehash_state *st, uint64_t first_leaf) {
+    memset(st, 0, sizeof(*st));
+    st->next_leaf = first_leaf;
+}
+
+// Push a completed subtree root and merge equal-height neighbours into their parents
+void xmss_treehash_push(const xmss_params *params, const XMSSKey *key, xmss_node_cache *cache,
+                        xmss_treehash_state *st, int height, uint64_t index, const uint8_t *node) {
+    uint8_t *slot = xmss_cache_node(cache, height, index);
+    if (slot) memcpy(slot, node, params->n);
+
+    st->stack[st->top].height = height;
+    st->stack[st->top].index = index;
+    memcpy(st->stack[st->top].node, node, params->n);
+    st->top++;
+
+    while (st->top >= 2 && st->stack[st->top - 1].height == st->stack[st->top - 2].height) {
+        int parent_height = st->stack[st->top - 1].height + 1;
+        uint64_t parent_index = st->stack[st->top - 1].index >> 1;
+        if (xmss_params_subtree_active(params, parent_height, parent_index)) {
+            thash_node(params, key->pub_seed, parent_height, parent_index,
+                       st->stack[st->top - 2].node, st->stack[st->top - 1].node, st->stack[st->top - 2].node);
+        } else {
+            // Only reachable when merging shard roots: inactive siblings collapse into the parent's filler
+            compute_inactive_node(params, st->stack[st->top - 2].node, key, parent_height, parent_index);
+        }
+        st->stack[st->top - 2].height = parent_height;
+        st->stack[st->top - 2].index = parent_index;
+        st->top--;
+
+        slot = xmss_cache_node(cache, parent_height, parent_index);
+        if (slot) memcpy(slot, st->stack[st->top - 1].node, params->n);
+    }
+}
+
+// Advance the treehash by one chunk. The chunk is the largest aligned subtree at the next leaf
+// that compute_node() would also evaluate as a whole: a filler for a subtree outside the
+// activation window, or a subtree of at most 2^base leaves. This keeps the root identical to
+// the recursive xmss_keygen().
+int xmss_treehash_step(const xmss_params *params, XMSSKey *key, xmss_node_cache *cache,
+                       xmss_treehash_state *st, uint64_t end_leaf) {
+    uint64_t pos = st->next_leaf;
+    if (pos >= end_leaf) return 0;
+
+    int chunk = xmss_cache_base(params);
+    int t = pos == 0 ? params->h : __builtin_ctzll(pos);
+    if (t > params->h) t = params->h;
+    while (t > 0 && pos + (1ULL << t) > end_leaf) t--;
+
+    uint8_t node[HASH_SIZE];
+    for (;; t--) {
+        if (!xmss_params_subtree_active(params, t, pos >> t)) {
+            compute_inactive_node(params, node, key, t, pos >> t);
+            break;
+        }
+        if (t <= chunk) {
+            compute_node(params, node, key, t, pos >> t);
+            break;
+        }
+    }
+
+    xmss_treehash_push(params, key, cache, st, t, pos >> t, node);
+    st->next_leaf = pos + (1ULL << t);
+    return st->next_leaf < end_leaf;
+}
+
+// Write the progress file (via a temporary file, so a crash never leaves a torn checkpoint)
+static int save_progress(const char *path, const xmss_params *params, const XMSSKey *key,
+                         const xmss_node_cache *cache, const xmss_treehash_state *st) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen_private(tmp);
+    if (!f) return -1;
+
+    int has_cache = cache != NULL;
+    int ok = xmss_params_write(f, params) == 0 &&
+             fwrite(&params->act_start, sizeof(uint64_t), 1, f) == 1 &&
+             fwrite(&params->act_count, sizeof(uint64_t), 1, f) == 1 &&
+             fwrite(key, sizeof(XMSSKey), 1, f) == 1 &&
+             fwrite(&st->next_leaf, sizeof(uint64_t), 1, f) == 1 &&
+             fwrite(&st->top, sizeof(int), 1, f) == 1;
+    for (int i = 0; ok && i < st->top; i++) {
+        ok = fwrite(&st->stack[i].height, sizeof(int), 1, f) == 1 &&
+             fwrite(&st->stack[i].index, sizeof(uint64_t), 1, f) == 1 &&
+             fwrite(st->stack[i].node, 1, params->n, f) == (size_t)params->n;
+    }
+    ok = ok && fwrite(&has_cache, sizeof(int), 1, f) == 1;
+    if (ok && has_cache) ok = fwrite(cache->nodes, 1, xmss_cache_bytes(cache), f) == xmss_cache_bytes(cache);
+    if (fclose(f) != 0) ok = 0;
+
+    if (!ok || replace_file(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// Read a progress file. Returns 1 if resumed, 0 if there is none, -1 if it cannot be used.
+static int load_progress(const char *path, const xmss_params *params, XMSSKey *key,
+                         xmss_node_cache *cache, xmss_treehash_state *st) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+
+    xmss_params file_params;
+    uint64_t act_start, act_count;
+    int has_cache = 0;
+    int ok = xmss_params_read(f, &file_params) == 0 &&
+             fread(&act_start, sizeof(uint64_t), 1, f) == 1 &&
+             fread(&act_count, sizeof(uint64_t), 1, f) == 1 &&
+             xmss_params_set_activation(&file_params, act_start, act_count) == 0 &&
+             xmss_params_equal(&file_params, params) &&
+             fread(key, sizeof(XMSSKey), 1, f) == 1 &&
+             fread(&st->next_leaf, sizeof(uint64_t), 1, f) == 1 &&
+             fread(&st->top, sizeof(int), 1, f) == 1 &&
+             st->top >= 0 && st->top <= params->h + 1;
+    for (int i = 0; ok && i < st->top; i++) {
+        ok = fread(&st->stack[i].height, sizeof(int), 1, f) == 1 &&
+             fread(&st->stack[i].index, sizeof(uint64_t), 1, f) == 1 &&
+             fread(st->stack[i].node, 1, params->n, f) == (size_t)params->n;
+    }
+    ok = ok && fread(&has_cache, sizeof(int), 1, f) == 1 && has_cache == (cache != NULL);
+    if (ok && has_cache) ok = fread(cache->nodes, 1, xmss_cache_bytes(cache), f) == xmss_cache_bytes(cache);
+    fclose(f);
+
+    // The stack must be aligned subtrees of strictly decreasing height covering [0, next_leaf)
+    uint64_t covered = 0;
+    for (int i = 0; ok && i < st->top; i++) {
+        int height = st->stack[i].height;
+        ok = height >= 0 && height <= params->h && (i == 0 || height < st->stack[i - 1].height) &&
+             st->stack[i].index < (params->max_keys >> height) && st->stack[i].index << height == covered;
+        covered += 1ULL << height;
+    }
+    ok = ok && st->next_leaf == covered && st->next_leaf < params->max_keys;
+
+    if (!ok) {
+        fprintf(stderr, "ERROR: %s does not match the requested key parameters or is damaged.\n", path);
+        secure_zero_memory(key, sizeof(XMSSKey));
+        return -1;
+    }
+    return 1;
+}
+
+// Run the treehash to the end of the tree, checkpointing when a progress path is given
+static int treehash_build(const xmss_params *params, XMSSKey *key, xmss_node_cache *cache, xmss_treehash_state *st,
+                          const char *progress_path, uint64_t checkpoint_leaves) {
+    if (checkpoint_leaves == 0) checkpoint_leaves = XMSS_CHECKPOINT_DEFAULT;
+
+    uint64_t last_checkpoint = st->next_leaf;
+    while (xmss_treehash_step(params, key, cache, st, params->max_keys)) {
+        if (progress_path && st->next_leaf - last_checkpoint >= checkpoint_leaves) {
+            if (save_progress(progress_path, params, key, cache, st) != 0) {
+                fprintf(stderr, "WARNING: Failed to write key generation checkpoint %s\n", progress_path);
+            }
+            last_checkpoint = st->next_leaf;
+        }
+    }
+
+    if (st->top != 1 || st->stack[0].height != params->h) return -1;
+    memcpy(key->root, st->stack[0].node, params->n);
+    if (cache) memcpy(cache->root, key->root, params->n);
+    return 0;
+}
+
+// Treehash keygen with optional checkpointing
+int xmss_keygen_resumable(const xmss_params *params, XMSSKey *key, xmss_node_cache *cache,
+                          const char *progress_path, uint64_t checkpoint_leaves) {
+    xmss_treehash_state st;
+    xmss_treehash_init(&st, 0);
+
+    int resumed = 0;
+    if (progress_path) {
+        resumed = load_progress(progress_path, params, key, cache, &st);
+        if (resumed < 0) return -1;
+        if (resumed) printf("Resuming key generation at leaf %llu of %llu\n",
+                            (unsigned long long)st.next_leaf, (unsigned long long)params->max_keys);
+    }
+    if (!resumed) xmss_keygen_seeds(params, key);
+
+    if (treehash_build(params, key, cache, &st, progress_path, checkpoint_leaves) != 0) return -1;
+    if (progress_path) remove(progress_path);
+    return 0;
+}
+
+// Treehash keygen from seeds that are already drawn
+int xmss_keygen_cached(const xmss_params *params, XMSSKey *key, xmss_node_cache *cache) {
+    xmss_treehash_state st;
+    xmss_treehash_init(&st, 0);
+    return treehash_build(params, key, cache, &st, NULL, 0);
+}
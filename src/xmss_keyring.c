@@ -0,0 +1,269 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// import project-specific headers
+#include "xmss_keyring.h"
+#include "xmss_keygen.h"
+#include "xmss_parallel.h"
+#include "util.h"
+
+// Longest path of a keyring file
+#define KEYRING_PATH_MAX 4096
+
+// Order entries by id
+static int entry_cmp(const void *a, const void *b) {
+    uint32_t x = ((const xmss_keyring_entry *)a)->id, y = ((const xmss_keyring_entry *)b)->id;
+    return (x > y) - (x < y);
+}
+
+// Load one key with its state and cache
+static int load_entry(const xmss_keyring *ring, uint32_t id, xmss_keyring_entry *e) {
+    char path[KEYRING_PATH_MAX];
+    memset(e, 0, sizeof(*e));
+    e->id = id;
+    e->key = xmss_key_alloc();
+    if (!e->key) return -1;
+    snprintf(path, sizeof(path), XMSS_KEYRING_KEY_FMT, ring->dir, id);
+    if (xmss_load_key_file(path, e->key, &e->params) != 1) {
+        fprintf(stderr, "ERROR: Failed to load keyring key %s\n", path);
+        xmss_key_free(e->key);
+        return -1;
+    }
+    snprintf(path, sizeof(path), XMSS_KEYRING_STATE_FMT, ring->dir, id);
+    // Every key is added with its state; a missing state file must not restart the key at leaf 0
+    if (xmss_load_state_file(path, &e->next_index) != 1) {
+        fprintf(stderr, "ERROR: Missing or unreadable keyring state %s\n", path);
+        xmss_key_free(e->key);
+        return -1;
+    }
+    snprintf(path, sizeof(path), XMSS_KEYRING_CACHE_FMT, ring->dir, id);
+    e->have_cache = xmss_cache_load(path, &e->cache, &e->params) == 1;
+    return 0;
+}
+
+// Open a keyring directory
+int xmss_keyring_open(xmss_keyring *ring, const char *dir) {
+    memset(ring, 0, sizeof(*ring));
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        perror(dir);
+        return -1;
+    }
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror(dir);
+        return -1;
+    }
+    ring->dir = strdup(dir);
+    pthread_mutex_init(&ring->lock, NULL);
+    if (!ring->dir) {
+        closedir(d);
+        xmss_keyring_close(ring);
+        return -1;
+    }
+
+    // Every key_<id>.bin is one entry
+    int cap = 0;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        unsigned int id;
+        int end = 0;
+        if (sscanf(de->d_name, "key_%u.bin%n", &id, &end) != 1 || de->d_name[end] != '\0' || end == 0) continue;
+        if (ring->count == cap) {
+            cap = cap ? 2 * cap : 16;
+            xmss_keyring_entry *grown = realloc(ring->entries, (size_t)cap * sizeof(*grown));
+            if (!grown) {
+                closedir(d);
+                xmss_keyring_close(ring);
+                return -1;
+            }
+            ring->entries = grown;
+        }
+        if (load_entry(ring, id, &ring->entries[ring->count]) != 0) {
+            closedir(d);
+            xmss_keyring_close(ring);
+            return -1;
+        }
+        ring->count++;
+    }
+    closedir(d);
+    if (ring->count > 0) qsort(ring->entries, (size_t)ring->count, sizeof(*ring->entries), entry_cmp);
+    return 0;
+}
+
+// Wipe and free everything
+void xmss_keyring_close(xmss_keyring *ring) {
+    for (int i = 0; i < ring->count; i++) {
+        xmss_key_free(ring->entries[i].key);
+        if (ring->entries[i].have_cache) xmss_cache_free(&ring->entries[i].cache);
+    }
+    if (ring->dir) pthread_mutex_destroy(&ring->lock);
+    free(ring->entries);
+    free(ring->dir);
+    memset(ring, 0, sizeof(*ring));
+}
+
+// Binary search by id
+xmss_keyring_entry *xmss_keyring_find(const xmss_keyring *ring, uint32_t id) {
+    xmss_keyring_entry probe;
+    probe.id = id;
+    if (ring->count == 0) return NULL;
+    return bsearch(&probe, ring->entries, (size_t)ring->count, sizeof(*ring->entries), entry_cmp);
+}
+
+// Generate, save and insert a new key
+int xmss_keyring_generate(xmss_keyring *ring, uint32_t id, const xmss_params *params) {
+    if (xmss_keyring_find(ring, id)) {
+        fprintf(stderr, "ERROR: Key id %u already exists in keyring %s\n", id, ring->dir);
+        return -1;
+    }
+    xmss_keyring_entry e;
+    memset(&e, 0, sizeof(e));
+    e.id = id;
+    e.params = *params;
+    e.next_index = (int)params->act_start;
+    e.key = xmss_key_alloc();
+    if (!e.key || xmss_cache_init(&e.cache, params) != 0 ||
+        xmss_keygen_resumable(params, e.key, &e.cache, NULL, 0) != 0) {
+        xmss_cache_free(&e.cache);
+        xmss_key_free(e.key);
+        return -1;
+    }
+    e.have_cache = 1;
+
+    // State and cache first: the key file is what makes the id visible
+    char path[KEYRING_PATH_MAX];
+    int ok = 1;
+    snprintf(path, sizeof(path), XMSS_KEYRING_STATE_FMT, ring->dir, id);
+    ok = ok && xmss_save_state_file(path, e.next_index) == 0;
+    snprintf(path, sizeof(path), XMSS_KEYRING_CACHE_FMT, ring->dir, id);
+    ok = ok && xmss_cache_save(path, &e.cache, params) == 0;
+    snprintf(path, sizeof(path), XMSS_KEYRING_KEY_FMT, ring->dir, id);
+    ok = ok && xmss_save_key_file(path, e.key, params) == 0;
+
+    xmss_keyring_entry *grown = ok ? realloc(ring->entries, (size_t)(ring->count + 1) * sizeof(*grown)) : NULL;
+    if (!grown) {
+        fprintf(stderr, "ERROR: Failed to store key id %u in keyring %s\n", id, ring->dir);
+        xmss_cache_free(&e.cache);
+        xmss_key_free(e.key);
+        return -1;
+    }
+    ring->entries = grown;
+    int pos = ring->count;
+    while (pos > 0 && ring->entries[pos - 1].id > id) pos--;
+    memmove(&ring->entries[pos + 1], &ring->entries[pos], (size_t)(ring->count - pos) * sizeof(*grown));
+    ring->entries[pos] = e;
+    ring->count++;
+    return 0;
+}
+
+// Reserve the next unused leaf of an entry, persisting the state before it is used
+static int reserve_leaf(xmss_keyring *ring, xmss_keyring_entry *e) {
+    pthread_mutex_lock(&ring->lock);
+    uint64_t next = (uint64_t)e->next_index < e->params.act_start ? e->params.act_start : (uint64_t)e->next_index;
+    int idx = -1;
+    if (!xmss_params_is_active(&e->params, next) || next >= INT32_MAX) {
+        fprintf(stderr, "ERROR: Key id %u has no unused leaves left.\n", e->id);
+    } else {
+        char path[KEYRING_PATH_MAX];
+        snprintf(path, sizeof(path), XMSS_KEYRING_STATE_FMT, ring->dir, e->id);
+        if (xmss_save_state_file(path, (int)next + 1) == 0) {
+            e->next_index = (int)next + 1;
+            idx = (int)next;
+        }
+    }
+    pthread_mutex_unlock(&ring->lock);
+    return idx;
+}
+
+// Sign with one key
+int xmss_keyring_sign(xmss_keyring *ring, uint32_t id, const uint8_t *msg, XMSSSignature *sig) {
+    xmss_keyring_entry *e = xmss_keyring_find(ring, id);
+    if (!e) return -1;
+    int idx = reserve_leaf(ring, e);
+    if (idx < 0) return -1;
+    xmss_cache_use_thread(e->have_cache ? &e->cache : NULL);
+    int r = xmss_sign_index(&e->params, msg, e->key, sig, idx);
+    xmss_cache_use_thread(NULL);
+    return r;
+}
+
+// One xmss_keyring_sign_batch() call
+typedef struct {
+    const uint8_t *msg;
+    const xmss_params *digest_params;  // Parameters the shared digest was made for
+    const uint8_t *digest;
+    xmss_keyring_entry **entries;
+    const int *leaves;
+    XMSSSignature *sigs;
+    int *results;
+} batch_job;
+
+// Sign under key i with its own cache
+static void batch_item(void *ctx, int i) {
+    const batch_job *job = ctx;
+    xmss_keyring_entry *e = job->entries[i];
+    job->results[i] = 0;
+    if (!e || job->leaves[i] < 0) return;
+
+    // Keys with another backend or output length need their own digest
+    uint8_t own[HASH_SIZE];
+    const uint8_t *digest = job->digest;
+    if (e->params.hash != job->digest_params->hash || e->params.n != job->digest_params->n) {
+        xmss_hash(&e->params, job->msg, strlen((const char*)job->msg), own, e->params.n);
+        digest = own;
+    }
+    xmss_cache_use_thread(e->have_cache ? &e->cache : NULL);
+    job->results[i] = xmss_sign_digest(&e->params, digest, e->key, &job->sigs[i], job->leaves[i]) == 0;
+    xmss_cache_use_thread(NULL);
+}
+
+// Sign one message under many keys
+int xmss_keyring_sign_batch(xmss_keyring *ring, const uint8_t *msg, const uint32_t *ids, int count,
+                            XMSSSignature *sigs, int *results) {
+    if (count <= 0) return 0;
+    xmss_keyring_entry **entries = calloc((size_t)count, sizeof(*entries));
+    int *leaves = calloc((size_t)count, sizeof(int));
+    int *own = results ? NULL : calloc((size_t)count, sizeof(int));
+    if (!entries || !leaves || (!results && !own)) {
+        free(entries);
+        free(leaves);
+        free(own);
+        return 0;
+    }
+    if (!results) results = own;
+
+    // Reserve every leaf up front; unknown ids and exhausted keys are skipped
+    const xmss_params *digest_params = NULL;
+    long hashes = 0;
+    for (int i = 0; i < count; i++) {
+        entries[i] = xmss_keyring_find(ring, ids[i]);
+        leaves[i] = -1;
+        if (!entries[i]) {
+            fprintf(stderr, "ERROR: Key id %u is not in keyring %s\n", ids[i], ring->dir);
+            continue;
+        }
+        leaves[i] = reserve_leaf(ring, entries[i]);
+        if (!digest_params) digest_params = &entries[i]->params;
+        hashes += (long)entries[i]->params.wots_len * entries[i]->params.w;
+    }
+
+    // One digest for the common parameters
+    uint8_t digest[HASH_SIZE];
+    if (digest_params) xmss_hash(digest_params, msg, strlen((const char*)msg), digest, digest_params->n);
+
+    batch_job job = { msg, digest_params, digest, entries, leaves, sigs, results };
+    if (digest_params) xmss_parallel_for(count, hashes, batch_item, &job);
+    else memset(results, 0, (size_t)count * sizeof(int));
+
+    int made = 0;
+    for (int i = 0; i < count; i++) made += results[i];
+    free(entries);
+    free(leaves);
+    free(own);
+    return made;
+}
@@ -0,0 +1,137 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// import project-specific headers
+#include "xmss_parallel.h"
+#include "thash.h"
+#include "xmss_arena.h"
+
+// Upper bound on workers
+#define XMSS_PARALLEL_MAX 64
+
+// Claim counter value between jobs, so a late worker never claims an item of the next job
+#define PARKED (INT_MAX / 2)
+
+// Pool state. Jobs are posted by bumping the generation; workers claim items with an atomic
+// counter, so distribution costs one fetch-add per item.
+static struct {
+    int threads;               // Running workers (0 = pool off)
+    int stop;
+    int busy;                  // Owner is inside xmss_parallel_for()
+    pthread_t owner;
+    pthread_t workers[XMSS_PARALLEL_MAX];
+    pthread_mutex_t lock;
+    pthread_cond_t  start;     // Signalled when a job is posted
+    pthread_cond_t  finish;    // Signalled when the last item completes
+    unsigned long generation;
+
+    // Current job
+    void (*fn)(void *ctx, int i);
+    void *ctx;
+    int count;
+    int next;                  // Next unclaimed item (PARKED between jobs)
+    int done;                  // Completed items
+} pool = { .lock = PTHREAD_MUTEX_INITIALIZER, .start = PTHREAD_COND_INITIALIZER,
+           .finish = PTHREAD_COND_INITIALIZER, .next = PARKED };
+
+// Claim and run items of the current job until none are left
+static void run_items(void) {
+    for (;;) {
+        int i = __atomic_fetch_add(&pool.next, 1, __ATOMIC_SEQ_CST);
+        if (i >= __atomic_load_n(&pool.count, __ATOMIC_SEQ_CST)) return;
+        pool.fn(pool.ctx, i);
+        if (__atomic_add_fetch(&pool.done, 1, __ATOMIC_SEQ_CST) == pool.count) {
+            pthread_mutex_lock(&pool.lock);
+            pthread_cond_signal(&pool.finish);
+            pthread_mutex_unlock(&pool.lock);
+        }
+    }
+}
+
+// Worker: sleep until a job is posted, help with it, repeat
+static void *parallel_worker(void *arg) {
+    (void)arg;
+    unsigned long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool.lock);
+        while (pool.generation == seen && !pool.stop) pthread_cond_wait(&pool.start, &pool.lock);
+        seen = pool.generation;
+        int stop = pool.stop;
+        pthread_mutex_unlock(&pool.lock);
+        if (stop) break;
+        run_items();
+    }
+    thash_release_thread_state();
+    xmss_arena_release_thread();
+    return NULL;
+}
+
+// Start the worker pool
+int xmss_parallel_start(int threads) {
+    if (pool.threads > 0) xmss_parallel_stop();
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 1 ? (int)cores - 1 : 0;
+    }
+    if (threads > XMSS_PARALLEL_MAX) threads = XMSS_PARALLEL_MAX;
+
+    pool.stop = 0;
+    pool.owner = pthread_self();
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool.workers[i], NULL, parallel_worker, NULL) != 0) {
+            fprintf(stderr, "WARNING: Started only %d of %d worker threads\n", i, threads);
+            break;
+        }
+        pool.threads++;
+    }
+    return 0;
+}
+
+// Stop and join the workers
+void xmss_parallel_stop(void) {
+    if (pool.threads == 0) return;
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < pool.threads; i++) pthread_join(pool.workers[i], NULL);
+    pool.threads = 0;
+}
+
+// Number of running workers
+int xmss_parallel_threads(void) {
+    return pool.threads;
+}
+
+// Run a job on the pool, or serially when the pool cannot or should not be used
+void xmss_parallel_for(int count, long hashes, void (*fn)(void *ctx, int i), void *ctx) {
+    if (pool.threads == 0 || pool.busy || count < 2 || hashes < XMSS_PARALLEL_MIN_HASHES ||
+        !pthread_equal(pthread_self(), pool.owner)) {
+        for (int i = 0; i < count; i++) fn(ctx, i);
+        return;
+    }
+
+    // Post the job. next is reset last, so a worker that claims an item sees the job's fields.
+    pool.busy = 1;
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.ctx = ctx;
+    __atomic_store_n(&pool.count, count, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&pool.done, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&pool.next, 0, __ATOMIC_SEQ_CST);
+    pool.generation++;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+
+    // The caller works too, then waits for items still running on workers
+    run_items();
+    pthread_mutex_lock(&pool.lock);
+    while (__atomic_load_n(&pool.done, __ATOMIC_SEQ_CST) < count) pthread_cond_wait(&pool.finish, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    __atomic_store_n(&pool.next, PARKED, __ATOMIC_SEQ_CST);
+    pool.busy = 0;
+}
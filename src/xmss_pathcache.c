@@ -0,0 +1,113 @@
+// import standard libraries
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_pathcache.h"
+#include "util.h"
+
+// Caches attached to xmss_verify() (attach before verifying on several threads)
+static xmss_path_cache *attached;
+
+// Node offset: height t starts after the 2^(h-base+1) - 2^(h-t+1) nodes of the levels below it
+static uint64_t node_offset(const xmss_path_cache *cache, int height, uint64_t index) {
+    return (1ULL << (cache->h - cache->base + 1)) - (1ULL << (cache->h - height + 1)) + index;
+}
+
+// Allocate an empty cache for one trusted root
+int xmss_pathcache_init(xmss_path_cache *cache, const xmss_params *params, const uint8_t *root,
+                        const uint8_t *pub_seed) {
+    memset(cache, 0, sizeof(*cache));
+    cache->h = params->h;
+    cache->n = params->n;
+    cache->base = params->h > XMSS_PATHCACHE_LEVELS ? params->h - XMSS_PATHCACHE_LEVELS : 0;
+    memcpy(cache->root, root, params->n);
+    if (pub_seed && params->hash_mode == XMSS_HASH_TWEAKED) memcpy(cache->pub_seed, pub_seed, XMSS_PUB_SEED_BYTES);
+
+    uint64_t count = (1ULL << (cache->h - cache->base + 1)) - 2;
+    cache->nodes = malloc((size_t)count * cache->n);
+    cache->proven = calloc((size_t)count, 1);
+    if (!cache->nodes || !cache->proven) {
+        free(cache->nodes);
+        free(cache->proven);
+        return -1;
+    }
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+// Free the cache (and detach it if attached)
+void xmss_pathcache_free(xmss_path_cache *cache) {
+    if (!cache || !cache->nodes) return;
+    for (xmss_path_cache **p = &attached; *p; p = &(*p)->next) {
+        if (*p == cache) {
+            *p = cache->next;
+            break;
+        }
+    }
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->nodes);
+    free(cache->proven);
+    cache->nodes = NULL;
+    cache->proven = NULL;
+}
+
+// Compare a reconstructed node and the rest of its auth path with the proven nodes. Every stored
+// node's ancestors and their siblings are stored too, so a matching signature must carry exactly
+// the proven siblings; otherwise the same message would verify with or without the cache differently.
+int xmss_pathcache_check(xmss_path_cache *cache, int height, uint64_t index, const uint8_t *node,
+                         uint8_t *const *auth_path) {
+    if (height < cache->base || height >= cache->h) return -1;
+    uint64_t offset = node_offset(cache, height, index);
+    int result = -1;
+    pthread_mutex_lock(&cache->lock);
+    if (cache->proven[offset]) {
+        result = constant_time_equal(cache->nodes + offset * cache->n, node, cache->n);
+        for (int t = height; result == 1 && t < cache->h; t++) {
+            uint64_t sibling = node_offset(cache, t, (index >> (t - height)) ^ 1);
+            if (!cache->proven[sibling]) result = -1;
+            else if (!constant_time_equal(cache->nodes + sibling * cache->n, auth_path[t], cache->n)) result = 0;
+        }
+        if (result == 1) cache->hits++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return result;
+}
+
+// Store one proven node
+static void store(xmss_path_cache *cache, int height, uint64_t index, const uint8_t *node) {
+    uint64_t offset = node_offset(cache, height, index);
+    memcpy(cache->nodes + offset * cache->n, node, cache->n);
+    cache->proven[offset] = 1;
+}
+
+// Store the proven part of a path and its siblings
+void xmss_pathcache_insert(xmss_path_cache *cache, uint64_t leaf, int top, uint8_t (*path)[HASH_SIZE],
+                           uint8_t *const *auth_path) {
+    pthread_mutex_lock(&cache->lock);
+    for (int t = cache->base; t < top; t++) {
+        store(cache, t, leaf >> t, path[t]);
+        store(cache, t, (leaf >> t) ^ 1, auth_path[t]);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Attach a cache
+void xmss_pathcache_use(xmss_path_cache *cache) {
+    for (xmss_path_cache *p = attached; p; p = p->next) {
+        if (p == cache) return;
+    }
+    cache->next = attached;
+    attached = cache;
+}
+
+// Find the attached cache of a root (the public seed only matters in tweaked mode)
+xmss_path_cache *xmss_pathcache_for(const xmss_params *params, const uint8_t *root, const uint8_t *pub_seed) {
+    uint8_t seed[XMSS_PUB_SEED_BYTES] = {0};
+    if (pub_seed && params->hash_mode == XMSS_HASH_TWEAKED) memcpy(seed, pub_seed, XMSS_PUB_SEED_BYTES);
+    for (xmss_path_cache *p = attached; p; p = p->next) {
+        if (p->h == params->h && p->n == params->n && memcmp(p->root, root, params->n) == 0 &&
+            memcmp(p->pub_seed, seed, XMSS_PUB_SEED_BYTES) == 0) return p;
+    }
+    return NULL;
+}
@@ -0,0 +1,133 @@
+// import standard libraries
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_precomp.h"
+#include "xmss_secmem.h"
+#include "util.h"
+
+// Size of one leaf's chain table
+static size_t chains_bytes(const xmss_params *params) {
+    return (size_t)params->wots_len * params->w * params->n;
+}
+
+// Wipe the leaf at the head of the ring and advance past it
+static void drop_head(xmss_precomp_pool *pool, const xmss_params *params) {
+    xmss_precomp_leaf *leaf = &pool->leaves[pool->head];
+    secure_zero_memory(leaf->chains, chains_bytes(params));
+    secure_zero_memory(leaf->auth_path, (size_t)params->h * params->n);
+    pool->head = (pool->head + 1) % pool->capacity;
+    pool->count--;
+}
+
+// Drop every prepared leaf below 'index'; those leaves can never be signed with again
+static void drop_below(xmss_precomp_pool *pool, const xmss_params *params, uint64_t index) {
+    while (pool->count > 0 && pool->leaves[pool->head].index < index) drop_head(pool, params);
+}
+
+// Allocate a pool with room for 'capacity' leaves
+int xmss_precomp_init(xmss_precomp_pool *pool, const xmss_params *params, int capacity) {
+    if (!pool || !params || capacity <= 0) return -1;
+    memset(pool, 0, sizeof(*pool));
+
+    pool->leaves = calloc((size_t)capacity, sizeof(xmss_precomp_leaf));
+    if (!pool->leaves) return -1;
+    pool->capacity = capacity;
+
+    for (int i = 0; i < capacity; i++) {
+        pool->leaves[i].chains = xmss_secmem_alloc(chains_bytes(params));
+        pool->leaves[i].auth_path = malloc((size_t)params->h * params->n);
+        if (!pool->leaves[i].chains || !pool->leaves[i].auth_path) {
+            xmss_precomp_free(pool, params);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Wipe and free the pool (xmss_secmem_free() wipes the chain tables)
+void xmss_precomp_free(xmss_precomp_pool *pool, const xmss_params *params) {
+    (void)params;
+    if (!pool || !pool->leaves) return;
+    for (int i = 0; i < pool->capacity; i++) {
+        xmss_secmem_free(pool->leaves[i].chains);
+        free(pool->leaves[i].auth_path);
+    }
+    free(pool->leaves);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// Do all message-independent work of a leaf: its full chains and its auth path
+static int prepare_leaf(const xmss_params *params, XMSSKey *key, uint64_t index, xmss_precomp_leaf *leaf) {
+    WOTSKey wots_key;
+    if (wots_alloc_key(&wots_key, params) != 0) return -1;
+    if (xmss_derive_wots_sk(params, key, (int)index, &wots_key) != 0) {
+        wots_free_key(&wots_key, params);
+        return -1;
+    }
+
+    xmss_adrs ots_adrs;
+    xmss_ots_adrs(&ots_adrs, index);
+    wots_precompute_chains(params, &wots_key, leaf->chains, key->pub_seed, &ots_adrs);
+    for (int i = 0; i < params->wots_len; i++) secure_zero_memory(wots_key.sk[i], params->n);
+    wots_free_key(&wots_key, params);
+
+    uint8_t *rows[32]; // h <= 32
+    for (int h = 0; h < params->h; h++) rows[h] = leaf->auth_path + (size_t)h * params->n;
+    xmss_compute_auth_path(params, key, index, rows);
+
+    leaf->index = index;
+    return 0;
+}
+
+// Offline step: top the pool up with the leaves that will be signed next
+int xmss_precomp_fill(xmss_precomp_pool *pool, const xmss_params *params, XMSSKey *key, uint64_t next_index) {
+    if (!pool || !pool->leaves) return -1;
+
+    // Leaves of a previous key are useless (and must not be signed with)
+    if (memcmp(pool->root, key->root, params->n) != 0) {
+        while (pool->count > 0) drop_head(pool, params);
+        memcpy(pool->root, key->root, params->n);
+    }
+    drop_below(pool, params, next_index);
+
+    uint64_t index = next_index;
+    if (pool->count > 0) {
+        index = pool->leaves[(pool->head + pool->count - 1) % pool->capacity].index + 1;
+    }
+    while (pool->count < pool->capacity && xmss_params_is_active(params, index)) {
+        xmss_precomp_leaf *leaf = &pool->leaves[(pool->head + pool->count) % pool->capacity];
+        if (prepare_leaf(params, key, index, leaf) != 0) return -1;
+        pool->count++;
+        index++;
+    }
+    return pool->count;
+}
+
+// Online step: digest the message and select the chain values of a prepared leaf
+int xmss_precomp_sign(xmss_precomp_pool *pool, const xmss_params *params, const uint8_t *msg,
+                      const XMSSKey *key, XMSSSignature *sig, uint64_t index) {
+    if (!pool || pool->count == 0 || memcmp(pool->root, key->root, params->n) != 0) return -1;
+    drop_below(pool, params, index);
+    if (pool->count == 0 || pool->leaves[pool->head].index != index) return -1;
+
+    xmss_precomp_leaf *leaf = &pool->leaves[pool->head];
+    sig->index = (int)index;
+
+    // A failed digest signs nothing and keeps the leaf
+    uint8_t msg_hash[HASH_SIZE];
+    if (xmss_hash(params, msg, strlen((const char*)msg), msg_hash, params->n) != 0 ||
+        wots_sign_precomputed(params, msg_hash, params->n, leaf->chains, sig->wots_sig) != 0) {
+        secure_zero_memory(msg_hash, params->n);
+        return -1;
+    }
+    for (int h = 0; h < params->h; h++) {
+        memcpy(sig->auth_path[h], leaf->auth_path + (size_t)h * params->n, params->n);
+    }
+
+    // One-time key: the leaf is gone once it has signed
+    drop_head(pool, params);
+    secure_zero_memory(msg_hash, params->n);
+    return 0;
+}
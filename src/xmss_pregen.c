@@ -0,0 +1,183 @@
+// SCHED_IDLE is a Linux extension
+#define _GNU_SOURCE
+
+// import standard libraries
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+// import project-specific headers
+#include "xmss_pregen.h"
+#include "xmss_keygen.h"
+#include "thash.h"
+#include "util.h"
+#include "xmss_arena.h"
+
+// Pre-generation state. Only the signing thread starts, joins and reads it.
+static struct {
+    double threshold;   // Fraction of the activation window (0 = disabled)
+    int running;        // Worker started and not yet joined
+    int result;         // Worker outcome: 1 staged, -1 failed
+    pthread_t thread;
+    xmss_params params; // Parameters of the key being built
+    XMSSKey key;        // Seeds drawn by the signing thread; the worker only hashes
+    xmss_node_cache installed; // Node cache of the last installed key, attached with xmss_cache_use()
+} pregen;
+
+// Enable background pre-generation
+int xmss_pregen_enable(double threshold) {
+    if (!(threshold >= 0.0 && threshold <= 1.0)) {
+        fprintf(stderr, "Invalid pre-generation threshold %g. Must be in (0, 1], or 0 to disable.\n", threshold);
+        return -1;
+    }
+    pregen.threshold = threshold;
+    return 0;
+}
+
+// Check whether a file exists
+static int file_exists(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    fclose(f);
+    return 1;
+}
+
+// Stage the state, the node cache and then the key, each through a temporary file
+int xmss_pregen_stage(const xmss_params *params, const XMSSKey *key, const xmss_node_cache *cache) {
+    remove(XMSS_NEXT_KEY_FILE);
+    int ok = xmss_save_state_file(XMSS_NEXT_STATE_FILE, (int)params->act_start) == 0;
+    if (ok && cache) {
+        ok = xmss_cache_save(XMSS_NEXT_CACHE_FILE ".tmp", cache, params) == 0 &&
+             replace_file(XMSS_NEXT_CACHE_FILE ".tmp", XMSS_NEXT_CACHE_FILE) == 0;
+    } else if (ok) {
+        remove(XMSS_NEXT_CACHE_FILE);
+    }
+    ok = ok && xmss_save_key_file(XMSS_NEXT_KEY_FILE ".tmp", key, params) == 0 &&
+         replace_file(XMSS_NEXT_KEY_FILE ".tmp", XMSS_NEXT_KEY_FILE) == 0;
+    return ok ? 0 : -1;
+}
+
+// Worker: build the tree and its node cache, then stage them
+static void *pregen_worker(void *arg) {
+    (void)arg;
+    xmss_node_cache cache = {0};
+    int ok = xmss_cache_init(&cache, &pregen.params) == 0 &&
+             xmss_keygen_cached(&pregen.params, &pregen.key, &cache) == 0 &&
+             xmss_pregen_stage(&pregen.params, &pregen.key, &cache) == 0;
+
+    xmss_cache_free(&cache);
+    secure_zero_memory(&pregen.key, sizeof(XMSSKey));
+    thash_release_thread_state();
+    xmss_arena_release_thread();
+    pregen.result = ok ? 1 : -1;
+    return NULL;
+}
+
+// Start the worker with idle scheduling priority where available
+static int start_worker(void) {
+#ifdef SCHED_IDLE
+    pthread_attr_t attr;
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    if (pthread_attr_init(&attr) == 0) {
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_IDLE);
+        pthread_attr_setschedparam(&attr, &sp);
+        int r = pthread_create(&pregen.thread, &attr, pregen_worker, NULL);
+        pthread_attr_destroy(&attr);
+        if (r == 0) return 0;
+    }
+#endif
+    return pthread_create(&pregen.thread, NULL, pregen_worker, NULL) == 0 ? 0 : -1;
+}
+
+// Start pre-generating the next key once the usage threshold is crossed
+void xmss_pregen_check(const xmss_params *params, uint64_t next_index) {
+    if (pregen.threshold <= 0.0 || pregen.running || next_index < params->act_start) return;
+    if ((double)(next_index - params->act_start) < pregen.threshold * (double)params->act_count) return;
+    if (file_exists(XMSS_NEXT_KEY_FILE)) return;
+
+    // The CSPRNG is not thread-safe, so the seeds are drawn here
+    pregen.params = *params;
+    xmss_keygen_seeds(&pregen.params, &pregen.key);
+    pregen.result = 0;
+    if (start_worker() != 0) {
+        fprintf(stderr, "WARNING: Could not start key pre-generation thread.\n");
+        secure_zero_memory(&pregen.key, sizeof(XMSSKey));
+        return;
+    }
+    pregen.running = 1;
+}
+
+// Wait for a running pre-generation
+int xmss_pregen_wait(void) {
+    if (!pregen.running) return 0;
+    pthread_join(pregen.thread, NULL);
+    pregen.running = 0;
+    if (pregen.result != 1) fprintf(stderr, "WARNING: Key pre-generation failed to stage %s.\n", XMSS_NEXT_KEY_FILE);
+    return pregen.result;
+}
+
+// Roll a committed rotation forward: each staged file still present is renamed over its live file
+int xmss_pregen_recover(void) {
+    if (!file_exists(XMSS_ROTATE_MARKER)) return 0;
+    if (file_exists(XMSS_NEXT_STATE_FILE) && replace_file(XMSS_NEXT_STATE_FILE, XMSS_STATE_FILE) != 0) return -1;
+    if (file_exists(XMSS_NEXT_CACHE_FILE) && replace_file(XMSS_NEXT_CACHE_FILE, XMSS_CACHE_FILE) != 0) return -1;
+    if (file_exists(XMSS_NEXT_KEY_FILE) && replace_file(XMSS_NEXT_KEY_FILE, XMSS_KEY_FILE) != 0) return -1;
+    return remove(XMSS_ROTATE_MARKER) == 0 ? 1 : -1;
+}
+
+// Write the commit marker through a temporary file
+static int write_marker(void) {
+    FILE *f = fopen(XMSS_ROTATE_MARKER ".tmp", "wb");
+    if (!f) return -1;
+    int ok = fputs(XMSS_NEXT_KEY_FILE "\n", f) >= 0 && fsync_file(f) == 0;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? replace_file(XMSS_ROTATE_MARKER ".tmp", XMSS_ROTATE_MARKER) : -1;
+}
+
+// Install the staged key. Once the marker exists the rotation is committed: a crash at any later
+// point is finished by xmss_pregen_recover(), so the live key and state always belong together.
+int xmss_pregen_rotate(const xmss_params *params, XMSSKey *key) {
+    xmss_pregen_wait();
+    if (!file_exists(XMSS_NEXT_KEY_FILE)) return 0;
+
+    XMSSKey next;
+    xmss_params staged;
+    if (xmss_load_key_file(XMSS_NEXT_KEY_FILE, &next, &staged) != 1 || !xmss_params_equal(&staged, params)) {
+        fprintf(stderr, "WARNING: Discarding staged key %s (unreadable or parameters differ).\n", XMSS_NEXT_KEY_FILE);
+        remove(XMSS_NEXT_KEY_FILE);
+        remove(XMSS_NEXT_STATE_FILE);
+        remove(XMSS_NEXT_CACHE_FILE);
+        secure_zero_memory(&next, sizeof(XMSSKey));
+        return 0;
+    }
+
+    // The state is staged before the key; recreate it if it went missing. Without a staged cache
+    // the old one is removed with the rotation, as it belongs to the old key.
+    int ok = file_exists(XMSS_NEXT_STATE_FILE) ||
+             xmss_save_state_file(XMSS_NEXT_STATE_FILE, (int)params->act_start) == 0;
+    if (ok && !file_exists(XMSS_NEXT_CACHE_FILE)) {
+        ok = (remove(XMSS_CACHE_FILE) == 0 || !file_exists(XMSS_CACHE_FILE));
+    }
+    if (!ok || write_marker() != 0 || xmss_pregen_recover() != 1) {
+        fprintf(stderr, "WARNING: Could not install staged key %s.\n", XMSS_NEXT_KEY_FILE);
+        secure_zero_memory(&next, sizeof(XMSSKey));
+        return 0;
+    }
+
+    *key = next;
+    secure_zero_memory(&next, sizeof(XMSSKey));
+
+    // Sign under the new key with its cache from the first leaf on
+    xmss_node_cache loaded = {0};
+    if (xmss_cache_load(XMSS_CACHE_FILE, &loaded, params) == 1 && memcmp(loaded.root, key->root, params->n) == 0) {
+        xmss_cache_free(&pregen.installed);
+        pregen.installed = loaded;
+        xmss_cache_use(&pregen.installed);
+    } else {
+        xmss_cache_free(&loaded);
+    }
+    return 1;
+}
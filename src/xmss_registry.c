@@ -0,0 +1,178 @@
+// import standard libraries
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// import project-specific headers
+#include "xmss_registry.h"
+
+// Slots are added in blocks, so registering ids in order does not remap on every insert
+#define REGISTRY_GROW_SLOTS 1024
+
+_Static_assert(sizeof(xmss_registry_header) == 64, "registry header must be 64 bytes");
+_Static_assert(sizeof(xmss_registry_record) == 96, "registry records must be 96 bytes");
+
+// File size for a capacity
+static size_t registry_bytes(uint32_t capacity) {
+    return sizeof(xmss_registry_header) + (size_t)capacity * sizeof(xmss_registry_record);
+}
+
+// Map the first bytes of the file
+static int registry_map(xmss_registry *reg, size_t bytes) {
+    int prot = reg->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *map = mmap(NULL, bytes, prot, MAP_SHARED, reg->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("xmss_registry: mmap");
+        return -1;
+    }
+    reg->map = map;
+    reg->map_bytes = bytes;
+    reg->header = (xmss_registry_header *)reg->map;
+    reg->records = (xmss_registry_record *)(reg->map + sizeof(xmss_registry_header));
+    return 0;
+}
+
+// Open (and with writable, create) a registry file
+int xmss_registry_open(xmss_registry *reg, const char *path, int writable) {
+    memset(reg, 0, sizeof(*reg));
+    reg->writable = writable;
+    reg->fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (reg->fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    // Writers exclude each other and readers; taken before the size check so two creators cannot both
+    // write the header
+    if (flock(reg->fd, writable ? LOCK_EX : LOCK_SH) != 0) {
+        perror(path);
+        xmss_registry_close(reg);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(reg->fd, &st) != 0) {
+        perror(path);
+        xmss_registry_close(reg);
+        return -1;
+    }
+
+    // A new file starts with an empty table
+    if (st.st_size == 0 && writable) {
+        xmss_registry_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, XMSS_REGISTRY_MAGIC, 4);
+        header.version = XMSS_REGISTRY_VERSION;
+        header.record_bytes = sizeof(xmss_registry_record);
+        if (write(reg->fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+            perror(path);
+            xmss_registry_close(reg);
+            return -1;
+        }
+        st.st_size = sizeof(header);
+    }
+
+    if ((size_t)st.st_size < sizeof(xmss_registry_header) || registry_map(reg, (size_t)st.st_size) != 0) {
+        fprintf(stderr, "ERROR: %s is not a key registry.\n", path);
+        xmss_registry_close(reg);
+        return -1;
+    }
+    const xmss_registry_header *h = reg->header;
+    if (memcmp(h->magic, XMSS_REGISTRY_MAGIC, 4) != 0 || h->version != XMSS_REGISTRY_VERSION ||
+        h->record_bytes != sizeof(xmss_registry_record) || registry_bytes(h->capacity) != (size_t)st.st_size) {
+        fprintf(stderr, "ERROR: %s is not a version %d key registry or is truncated.\n", path, XMSS_REGISTRY_VERSION);
+        xmss_registry_close(reg);
+        return -1;
+    }
+    return 0;
+}
+
+// Flush and unmap
+void xmss_registry_close(xmss_registry *reg) {
+    if (reg->map) {
+        if (reg->writable) msync(reg->map, reg->map_bytes, MS_SYNC);
+        munmap(reg->map, reg->map_bytes);
+    }
+    if (reg->fd >= 0) close(reg->fd);
+    memset(reg, 0, sizeof(*reg));
+    reg->fd = -1;
+}
+
+// Direct slot lookup
+const xmss_registry_record *xmss_registry_lookup(const xmss_registry *reg, uint32_t id) {
+    if (!reg->map || id >= reg->header->capacity) return NULL;
+    const xmss_registry_record *rec = &reg->records[id];
+    return (rec->flags & XMSS_REGISTRY_PRESENT) ? rec : NULL;
+}
+
+// Extend the file so slot id exists and remap it
+static int registry_grow(xmss_registry *reg, uint32_t id) {
+    if (id >= UINT32_MAX - REGISTRY_GROW_SLOTS) {
+        fprintf(stderr, "ERROR: validator id %u is too large for the registry.\n", id);
+        return -1;
+    }
+    uint32_t capacity = (id / REGISTRY_GROW_SLOTS + 1) * REGISTRY_GROW_SLOTS;
+    size_t bytes = registry_bytes(capacity);
+    munmap(reg->map, reg->map_bytes);
+    reg->map = NULL;
+
+    // The new slots read as zero, i.e. empty
+    if (ftruncate(reg->fd, (off_t)bytes) != 0) {
+        perror("xmss_registry: ftruncate");
+        return -1;
+    }
+    if (registry_map(reg, bytes) != 0) return -1;
+    reg->header->capacity = capacity;
+    return 0;
+}
+
+// Insert or replace a key
+int xmss_registry_put(xmss_registry *reg, uint32_t id, const xmss_params *params, const uint8_t *root,
+                      const uint8_t *pub_seed) {
+    if (!reg->writable || !reg->map) return -1;
+    if (id >= reg->header->capacity && registry_grow(reg, id) != 0) return -1;
+
+    xmss_registry_record *rec = &reg->records[id];
+    if (!(rec->flags & XMSS_REGISTRY_PRESENT)) reg->header->count++;
+    memset(rec, 0, sizeof(*rec));
+    rec->id = id;
+    xmss_params_encode(params, rec->params);
+    memcpy(rec->root, root, params->n);
+    if (pub_seed) memcpy(rec->pub_seed, pub_seed, XMSS_PUB_SEED_BYTES);
+    rec->flags = XMSS_REGISTRY_PRESENT;
+    return 0;
+}
+
+// Clear a slot
+int xmss_registry_remove(xmss_registry *reg, uint32_t id) {
+    if (!reg->writable || !reg->map || !xmss_registry_lookup(reg, id)) return -1;
+    memset(&reg->records[id], 0, sizeof(xmss_registry_record));
+    reg->header->count--;
+    return 0;
+}
+
+// Parameters of a record
+int xmss_registry_record_params(const xmss_registry_record *rec, xmss_params *params) {
+    return xmss_params_decode(params, rec->params);
+}
+
+// Compare a record's parameter words with params
+int xmss_registry_record_matches(const xmss_registry_record *rec, const xmss_params *params) {
+    int32_t words[XMSS_PARAMS_WORDS];
+    xmss_params_encode(params, words);
+    return memcmp(words, rec->params, sizeof(words)) == 0;
+}
+
+// Strided view of the mapped table
+void xmss_registry_view(const xmss_registry *reg, xmss_key_registry *view) {
+    view->count = reg->header->capacity;
+    view->roots = reg->records[0].root;
+    view->pub_seeds = reg->records[0].pub_seed;
+    view->flags = &reg->records[0].flags;
+    view->params = reg->records[0].params;
+    view->stride = sizeof(xmss_registry_record);
+}
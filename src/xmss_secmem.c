@@ -0,0 +1,265 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// import project-specific headers
+#include "xmss_secmem.h"
+#include "util.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+// Size classes: 64 bytes << k, up to a quarter region (16 KiB)
+#define SECMEM_MIN_BLOCK 64
+#define SECMEM_CLASSES   9
+#define SECMEM_HEAP      0xFFFFFFFFu   // Class of a heap fallback block
+#define SECMEM_LARGE     0xFFFFFFFEu   // Class of a block with its own mapping
+#define SECMEM_LARGE_LOCKED 0xFFFFFFFDu
+#define SECMEM_MAGIC     0x5EC3E3A7u
+
+// Block header; the caller's memory starts right after it (16-byte aligned)
+typedef struct {
+    uint32_t cls;
+    uint32_t magic;
+    uint64_t bytes;   // Block size including the header
+} secmem_header;
+
+// A freed block; the link lives in the (wiped) caller part
+typedef struct secmem_free_block {
+    secmem_header header;
+    struct secmem_free_block *next;
+} secmem_free_block;
+
+// One mapping: guard page, data, guard page
+typedef struct {
+    uint8_t *map;
+    size_t map_bytes;
+    uint8_t *data;
+    size_t used;
+} secmem_region;
+
+// Only the region being carved is tracked; full regions live on through their blocks
+static pthread_mutex_t secmem_lock = PTHREAD_MUTEX_INITIALIZER;
+static secmem_region current;
+static secmem_free_block *free_lists[SECMEM_CLASSES];
+static size_t mapped_bytes, locked_bytes;
+static int lock_warned, heap_warned;
+
+// Release-time wipe: explicit_bzero where the C library has it
+static void secmem_wipe(void *ptr, size_t len) {
+#if defined(__GLIBC__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+    explicit_bzero(ptr, len);
+#else
+    secure_zero_memory(ptr, len);
+#endif
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+static size_t secmem_page(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+// Reserve data_bytes with no-access guard pages; returns 1 if the data pages were locked
+static int secmem_map(secmem_region *r, size_t data_bytes) {
+    size_t page = secmem_page();
+    DWORD old;
+    r->map_bytes = data_bytes + 2 * page;
+    r->map = VirtualAlloc(NULL, r->map_bytes, MEM_RESERVE | MEM_COMMIT, PAGE_NOACCESS);
+    if (!r->map) return -1;
+    r->data = r->map + page;
+    if (!VirtualProtect(r->data, data_bytes, PAGE_READWRITE, &old)) {
+        VirtualFree(r->map, 0, MEM_RELEASE);
+        return -1;
+    }
+    return VirtualLock(r->data, data_bytes) ? 1 : 0;
+}
+
+static void secmem_unmap(secmem_region *r, size_t data_bytes, int locked) {
+    if (locked) VirtualUnlock(r->data, data_bytes);
+    VirtualFree(r->map, 0, MEM_RELEASE);
+}
+#else
+static size_t secmem_page(void) {
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// Map data_bytes between PROT_NONE guard pages; returns 1 if the data pages were locked
+static int secmem_map(secmem_region *r, size_t data_bytes) {
+    size_t page = secmem_page();
+    r->map_bytes = data_bytes + 2 * page;
+    void *map = mmap(NULL, r->map_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) return -1;
+    r->map = map;
+    r->data = r->map + page;
+    if (mprotect(r->data, data_bytes, PROT_READ | PROT_WRITE) != 0) {
+        munmap(r->map, r->map_bytes);
+        return -1;
+    }
+#ifdef MADV_DONTDUMP
+    madvise(r->data, data_bytes, MADV_DONTDUMP);
+#endif
+    return mlock(r->data, data_bytes) == 0 ? 1 : 0;
+}
+
+static void secmem_unmap(secmem_region *r, size_t data_bytes, int locked) {
+    if (locked) munlock(r->data, data_bytes);
+    munmap(r->map, r->map_bytes);
+}
+#endif
+
+// Count a new mapping and warn once if it could not be locked (caller holds the lock)
+static void secmem_account(size_t data_bytes, int locked) {
+    if (!locked && !lock_warned) {
+        lock_warned = 1;
+        fprintf(stderr, "WARNING: Could not lock secure memory (see RLIMIT_MEMLOCK); secret keys may be swapped.\n");
+    }
+    mapped_bytes += data_bytes;
+    if (locked) locked_bytes += data_bytes;
+}
+
+// Start a new region (caller holds the lock); the remainder of the old one is abandoned
+static secmem_region *secmem_grow(void) {
+    secmem_region r;
+    int locked = secmem_map(&r, XMSS_SECMEM_REGION_BYTES);
+    if (locked < 0) return NULL;
+    secmem_account(XMSS_SECMEM_REGION_BYTES, locked);
+    r.used = 0;
+    current = r;
+    return &current;
+}
+
+// Smallest class holding bytes, or -1
+static int secmem_class(size_t bytes) {
+    for (int k = 0; k < SECMEM_CLASSES; k++) {
+        if (bytes <= (size_t)SECMEM_MIN_BLOCK << k) return k;
+    }
+    return -1;
+}
+
+// A block too large for the classes gets its own mapping, placed so it ends at the trailing guard page
+static secmem_header *secmem_alloc_large(size_t bytes) {
+    size_t page = secmem_page();
+    size_t block = sizeof(secmem_header) + ((bytes + 15) & ~(size_t)15);
+    size_t data_bytes = (block + page - 1) & ~(page - 1);
+    secmem_region r;
+    int locked = secmem_map(&r, data_bytes);
+    if (locked < 0) return NULL;
+    pthread_mutex_lock(&secmem_lock);
+    secmem_account(data_bytes, locked);
+    pthread_mutex_unlock(&secmem_lock);
+    secmem_header *h = (secmem_header *)(r.data + data_bytes - block);
+    h->cls = locked ? SECMEM_LARGE_LOCKED : SECMEM_LARGE;
+    h->bytes = block;
+    return h;
+}
+
+// Unmap a large block (its header lies in the first data page)
+static void secmem_free_large(secmem_header *h) {
+    size_t page = secmem_page();
+    size_t data_bytes = ((size_t)h->bytes + page - 1) & ~(page - 1);
+    int locked = h->cls == SECMEM_LARGE_LOCKED;
+    secmem_region r;
+    r.data = (uint8_t *)((uintptr_t)h & ~(uintptr_t)(page - 1));
+    r.map = r.data - page;
+    r.map_bytes = data_bytes + 2 * page;
+    secmem_wipe(h, sizeof(*h));
+    pthread_mutex_lock(&secmem_lock);
+    mapped_bytes -= data_bytes;
+    if (locked) locked_bytes -= data_bytes;
+    pthread_mutex_unlock(&secmem_lock);
+    secmem_unmap(&r, data_bytes, locked);
+}
+
+// Allocate from the pool, falling back to the heap only if no memory can be mapped
+void *xmss_secmem_alloc(size_t bytes) {
+    if (bytes > SIZE_MAX / 2) return NULL;
+    int k = secmem_class(bytes + sizeof(secmem_header));
+    secmem_header *h = NULL;
+    if (k >= 0) {
+        size_t block = (size_t)SECMEM_MIN_BLOCK << k;
+        pthread_mutex_lock(&secmem_lock);
+        if (free_lists[k]) {
+            secmem_free_block *f = free_lists[k];
+            free_lists[k] = f->next;
+            f->next = NULL;
+            h = &f->header;
+        } else {
+            secmem_region *r = current.data ? &current : NULL;
+            if (!r || XMSS_SECMEM_REGION_BYTES - r->used < block) r = secmem_grow();
+            if (r) {
+                h = (secmem_header *)(r->data + r->used);
+                r->used += block;
+            }
+        }
+        pthread_mutex_unlock(&secmem_lock);
+        if (h) {
+            h->cls = (uint32_t)k;
+            h->bytes = block;
+        }
+    } else {
+        h = secmem_alloc_large(bytes);
+    }
+    if (!h) {
+        pthread_mutex_lock(&secmem_lock);
+        if (!heap_warned) {
+            heap_warned = 1;
+            fprintf(stderr, "WARNING: Could not map secure memory; secret keys are kept on the ordinary heap.\n");
+        }
+        pthread_mutex_unlock(&secmem_lock);
+        h = calloc(1, sizeof(secmem_header) + bytes);
+        if (!h) return NULL;
+        h->cls = SECMEM_HEAP;
+        h->bytes = sizeof(secmem_header) + bytes;
+    }
+    h->magic = SECMEM_MAGIC;
+    return h + 1;
+}
+
+// Wipe and release
+void xmss_secmem_free(void *ptr) {
+    if (!ptr) return;
+    secmem_header *h = (secmem_header *)ptr - 1;
+    if (h->magic != SECMEM_MAGIC) {
+        fprintf(stderr, "xmss_secmem_free: not a secure-heap block\n");
+        abort();
+    }
+    secmem_wipe(ptr, (size_t)h->bytes - sizeof(secmem_header));
+    if (h->cls == SECMEM_HEAP) {
+        secmem_wipe(h, sizeof(*h));
+        free(h);
+        return;
+    }
+    if (h->cls == SECMEM_LARGE || h->cls == SECMEM_LARGE_LOCKED) {
+        secmem_free_large(h);
+        return;
+    }
+    h->magic = 0;
+    secmem_free_block *f = (secmem_free_block *)h;
+    pthread_mutex_lock(&secmem_lock);
+    f->next = free_lists[h->cls];
+    free_lists[h->cls] = f;
+    pthread_mutex_unlock(&secmem_lock);
+}
+
+// Pool statistics
+size_t xmss_secmem_mapped_bytes(void) {
+    pthread_mutex_lock(&secmem_lock);
+    size_t bytes = mapped_bytes;
+    pthread_mutex_unlock(&secmem_lock);
+    return bytes;
+}
+
+size_t xmss_secmem_locked_bytes(void) {
+    pthread_mutex_lock(&secmem_lock);
+    size_t bytes = locked_bytes;
+    pthread_mutex_unlock(&secmem_lock);
+    return bytes;
+}
@@ -0,0 +1,264 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_shard.h"
+#include "xmss_keygen.h"
+#include "util.h"
+
+// Public fingerprint of the seeds, so shards from different seeds are never merged
+static int seed_fingerprint(const XMSSKey *key, uint8_t out[HASH_SIZE]) {
+    uint8_t buffer[XMSS_SEED_BYTES + XMSS_PUB_SEED_BYTES];
+    memcpy(buffer, key->seed, XMSS_SEED_BYTES);
+    memcpy(buffer + XMSS_SEED_BYTES, key->pub_seed, XMSS_PUB_SEED_BYTES);
+    int r = hash_shake256(buffer, sizeof(buffer), out, HASH_SIZE);
+    secure_zero_memory(buffer, sizeof(buffer));
+    return r;
+}
+
+// Validate a shard number
+int xmss_shard_check(const xmss_params *params, int shard, int shards) {
+    int log_shards = int_log2(shards);
+    if (log_shards < 0 || log_shards > params->h || shard < 0 || shard >= shards) {
+        fprintf(stderr, "Invalid shard %d/%d. N must be a power of two <= 2^h and 0 <= i < N.\n", shard, shards);
+        return -1;
+    }
+    return 0;
+}
+
+// Load or create the shared seeds (xmss_save_key_file() writes it owner-only)
+int xmss_shard_seed(const xmss_params *params, XMSSKey *key) {
+    xmss_params file_params;
+    int r = xmss_load_key_file(XMSS_SEED_FILE, key, &file_params);
+    if (r == 1) {
+        if (!xmss_params_equal(&file_params, params)) {
+            fprintf(stderr, "ERROR: %s was created for different parameters.\n", XMSS_SEED_FILE);
+            secure_zero_memory(key, sizeof(XMSSKey));
+            return -1;
+        }
+        return 0;
+    }
+    if (r < 0) return -1;
+
+    // First shard: draw the seeds every other shard must share
+    xmss_keygen_seeds(params, key);
+    memset(key->root, 0, HASH_SIZE);
+    if (xmss_save_key_file(XMSS_SEED_FILE ".tmp", key, params) != 0 ||
+        replace_file(XMSS_SEED_FILE ".tmp", XMSS_SEED_FILE) != 0) {
+        secure_zero_memory(key, sizeof(XMSSKey));
+        return -1;
+    }
+    printf("Created %s; copy it to every host that computes shards of this key.\n", XMSS_SEED_FILE);
+    return 0;
+}
+
+// Compute one shard and write it to a file
+int xmss_shard_generate(const xmss_params *params, XMSSKey *key, int shard, int shards,
+                        int with_cache, const char *path) {
+    if (xmss_shard_check(params, shard, shards) != 0) return -1;
+    int height = params->h - int_log2(shards);
+    uint64_t first_leaf = (uint64_t)shard << height;
+
+    // Treehash over the shard's leaves leaves exactly its subtree root on the stack
+    xmss_node_cache cache;
+    if (with_cache && xmss_cache_init(&cache, params) != 0) return -1;
+    xmss_treehash_state st;
+    xmss_treehash_init(&st, first_leaf);
+    while (xmss_treehash_step(params, key, with_cache ? &cache : NULL, &st, first_leaf + (1ULL << height))) {}
+
+    uint8_t fingerprint[HASH_SIZE];
+    int ok = seed_fingerprint(key, fingerprint) == 0;
+    uint64_t index = (uint64_t)shard;
+
+    FILE *f = ok ? fopen(path, "wb") : NULL;
+    ok = f != NULL;
+    ok = ok && xmss_params_write(f, params) == 0 &&
+         fwrite(&params->act_start, sizeof(uint64_t), 1, f) == 1 &&
+         fwrite(&params->act_count, sizeof(uint64_t), 1, f) == 1 &&
+         fwrite(&height, sizeof(int), 1, f) == 1 &&
+         fwrite(&index, sizeof(uint64_t), 1, f) == 1 &&
+         fwrite(fingerprint, 1, HASH_SIZE, f) == HASH_SIZE &&
+         fwrite(st.stack[0].node, 1, params->n, f) == (size_t)params->n &&
+         fwrite(&with_cache, sizeof(int), 1, f) == 1;
+
+    // Cache segment: the shard's nodes at each cached height up to its root
+    for (int t = xmss_cache_base(params); ok && with_cache && t <= height; t++) {
+        uint64_t count = 1ULL << (height - t);
+        ok = fwrite(xmss_cache_node(&cache, t, index << (height - t)), params->n, count, f) == count;
+    }
+    if (f && fclose(f) != 0) ok = 0;
+    if (with_cache) xmss_cache_free(&cache);
+    return ok && st.top == 1 ? 0 : -1;
+}
+
+// One shard file as read by the merge
+typedef struct {
+    xmss_params params;
+    int height;
+    uint64_t index;
+    uint8_t fingerprint[HASH_SIZE];
+    uint8_t root[HASH_SIZE];
+    int has_cache;
+    long segment_offset; // File offset of the cache segment
+    const char *path;
+} shard_info;
+
+// Read a shard file header
+static int read_shard(const char *path, shard_info *info) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "ERROR: Cannot open shard %s\n", path);
+        return -1;
+    }
+    uint64_t act_start, act_count;
+    int ok = xmss_params_read(f, &info->params) == 0 &&
+             fread(&act_start, sizeof(uint64_t), 1, f) == 1 &&
+             fread(&act_count, sizeof(uint64_t), 1, f) == 1 &&
+             xmss_params_set_activation(&info->params, act_start, act_count) == 0 &&
+             fread(&info->height, sizeof(int), 1, f) == 1 &&
+             fread(&info->index, sizeof(uint64_t), 1, f) == 1 &&
+             fread(info->fingerprint, 1, HASH_SIZE, f) == HASH_SIZE &&
+             fread(info->root, 1, info->params.n, f) == (size_t)info->params.n &&
+             fread(&info->has_cache, sizeof(int), 1, f) == 1 &&
+             info->height >= 0 && info->height <= info->params.h &&
+             info->index < (1ULL << (info->params.h - info->height));
+    info->segment_offset = ftell(f);
+    info->path = path;
+    fclose(f);
+    if (!ok) fprintf(stderr, "ERROR: Invalid shard file %s\n", path);
+    return ok ? 0 : -1;
+}
+
+// Order shards by their first leaf
+static int compare_shards(const void *a, const void *b) {
+    const shard_info *x = a, *y = b;
+    uint64_t fx = x->index << x->height, fy = y->index << y->height;
+    return fx < fy ? -1 : fx > fy;
+}
+
+// Copy a shard's cache segment into the full cache
+static int load_segment(const shard_info *info, xmss_node_cache *cache) {
+    FILE *f = fopen(info->path, "rb");
+    if (!f || fseek(f, info->segment_offset, SEEK_SET) != 0) {
+        if (f) fclose(f);
+        return -1;
+    }
+    int ok = 1;
+    for (int t = cache->base; ok && t <= info->height; t++) {
+        uint64_t count = 1ULL << (info->height - t);
+        ok = fread(xmss_cache_node(cache, t, info->index << (info->height - t)), cache->n, count, f) == count;
+    }
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+// Zero the cached nodes below a filler, as a single-process keygen never computes them
+static void clear_inactive(const xmss_params *params, xmss_node_cache *cache) {
+    for (int t = cache->base; t < params->h; t++) {
+        for (uint64_t i = 0; i < (1ULL << (params->h - t)); i++) {
+            if (!xmss_params_subtree_active(params, t + 1, i >> 1)) memset(xmss_cache_node(cache, t, i), 0, cache->n);
+        }
+    }
+}
+
+// Merge shard files into the final key
+int xmss_shard_merge(const char *const *paths, int count, xmss_params *params, XMSSKey *key,
+                     xmss_node_cache *cache, int *have_cache) {
+    if (count <= 0) return -1;
+    shard_info *shards = calloc((size_t)count, sizeof(shard_info));
+    if (!shards) return -1;
+
+    int ok = 1;
+    for (int i = 0; ok && i < count; i++) ok = read_shard(paths[i], &shards[i]) == 0;
+    for (int i = 1; ok && i < count; i++) {
+        if (!xmss_params_equal(&shards[i].params, &shards[0].params) ||
+            memcmp(shards[i].fingerprint, shards[0].fingerprint, HASH_SIZE) != 0) {
+            fprintf(stderr, "ERROR: Shard %s belongs to a different key than %s\n", shards[i].path, shards[0].path);
+            ok = 0;
+        }
+    }
+
+    // The seeds come from the seed file and must be the ones the shards were built from
+    uint8_t fingerprint[HASH_SIZE];
+    if (ok) {
+        *params = shards[0].params;
+        xmss_params seed_params;
+        if (xmss_load_key_file(XMSS_SEED_FILE, key, &seed_params) != 1 || !xmss_params_equal(&seed_params, params)) {
+            fprintf(stderr, "ERROR: %s is missing or does not match the shards.\n", XMSS_SEED_FILE);
+            ok = 0;
+        } else {
+            if (seed_fingerprint(key, fingerprint) != 0 || memcmp(fingerprint, shards[0].fingerprint, HASH_SIZE) != 0) {
+                fprintf(stderr, "ERROR: The shards were not built from the seeds in %s.\n", XMSS_SEED_FILE);
+                ok = 0;
+            }
+        }
+    }
+
+    // The leaf ranges must tile [0, 2^h) exactly
+    if (ok) {
+        qsort(shards, (size_t)count, sizeof(shard_info), compare_shards);
+        uint64_t expected = 0;
+        for (int i = 0; ok && i < count; i++) {
+            uint64_t first = shards[i].index << shards[i].height;
+            if (first > expected) {
+                fprintf(stderr, "ERROR: Leaves [%llu, %llu) are not covered by any shard.\n",
+                        (unsigned long long)expected, (unsigned long long)first);
+                ok = 0;
+            } else if (first < expected) {
+                uint64_t last = first + (1ULL << shards[i].height);
+                fprintf(stderr, "ERROR: Shard %s overlaps leaves [%llu, %llu) of the previous shard.\n",
+                        shards[i].path, (unsigned long long)first,
+                        (unsigned long long)(last < expected ? last : expected));
+                ok = 0;
+            }
+            expected = first + (1ULL << shards[i].height);
+        }
+        if (ok && expected != params->max_keys) {
+            fprintf(stderr, "ERROR: Leaves [%llu, %llu) are not covered by any shard.\n",
+                    (unsigned long long)expected, (unsigned long long)params->max_keys);
+            ok = 0;
+        }
+    }
+
+    // Fill the cache from the segments, then treehash the shard roots left to right
+    *have_cache = 0;
+    if (ok) {
+        int segments = 1;
+        for (int i = 0; i < count; i++) segments &= shards[i].has_cache;
+        if (segments && xmss_cache_init(cache, params) == 0) {
+            *have_cache = 1;
+            for (int i = 0; *have_cache && i < count; i++) {
+                if (load_segment(&shards[i], cache) != 0) {
+                    fprintf(stderr, "WARNING: Damaged cache segment in %s; merging without a cache.\n", shards[i].path);
+                    xmss_cache_free(cache);
+                    *have_cache = 0;
+                }
+            }
+        }
+
+        xmss_treehash_state st;
+        xmss_treehash_init(&st, 0);
+        for (int i = 0; i < count; i++) {
+            xmss_treehash_push(params, key, *have_cache ? cache : NULL, &st,
+                               shards[i].height, shards[i].index, shards[i].root);
+        }
+        ok = st.top == 1 && st.stack[0].height == params->h;
+        if (ok) {
+            memcpy(key->root, st.stack[0].node, params->n);
+            if (*have_cache) {
+                clear_inactive(params, cache);
+                memcpy(cache->root, key->root, params->n);
+            }
+        }
+    }
+
+    if (!ok) {
+        secure_zero_memory(key, sizeof(XMSSKey));
+        if (*have_cache) xmss_cache_free(cache);
+        *have_cache = 0;
+    }
+    free(shards);
+    return ok ? 0 : -1;
+}
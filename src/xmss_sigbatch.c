@@ -0,0 +1,248 @@
+// import standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_sigbatch.h"
+#include "merkle.h"
+#include "util.h"
+
+/* Little-endian u32 helpers */
+static void u32le_store(uint8_t b[4], uint32_t x) {
+    b[0] = (uint8_t)x; b[1] = (uint8_t)(x >> 8); b[2] = (uint8_t)(x >> 16); b[3] = (uint8_t)(x >> 24);
+}
+
+// Load a 32-bit unsigned integer from little-endian byte array
+static uint32_t u32le_load(const uint8_t b[4]) {
+    return ((uint32_t)b[0]) | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+// Allocate a batch of count entries and proof_nodes proof nodes
+static int sigbatch_alloc(xmss_sigbatch *batch, const xmss_params *params, int count, int proof_nodes) {
+    memset(batch, 0, sizeof(*batch));
+    batch->indices = calloc((size_t)count, sizeof(uint64_t));
+    batch->wots = calloc((size_t)count, sizeof(WOTSSignature));
+    batch->proof = malloc((size_t)proof_nodes * params->n + 1);
+    if (!batch->indices || !batch->wots || !batch->proof) {
+        xmss_sigbatch_free(batch, params);
+        return -1;
+    }
+    for (; batch->count < count; batch->count++) {
+        if (wots_alloc_sig(&batch->wots[batch->count], params) != 0) {
+            xmss_sigbatch_free(batch, params);
+            return -1;
+        }
+    }
+    batch->proof_nodes = proof_nodes;
+    return 0;
+}
+
+// Free a batch
+void xmss_sigbatch_free(xmss_sigbatch *batch, const xmss_params *params) {
+    if (batch->wots) {
+        for (int i = 0; i < batch->count; i++) wots_free_sig(&batch->wots[i], params);
+    }
+    free(batch->wots);
+    free(batch->indices);
+    free(batch->proof);
+    memset(batch, 0, sizeof(*batch));
+}
+
+// Build a batch from individual signatures: copy the WOTS+ parts and merge the auth paths
+int xmss_sigbatch_build(const xmss_params *params, xmss_sigbatch *batch, XMSSSignature *const *sigs, int count) {
+    memset(batch, 0, sizeof(*batch));
+    if (count <= 0) return -1;
+    uint64_t *indices = malloc((size_t)count * sizeof(uint64_t));
+    uint8_t *const **paths = malloc((size_t)count * sizeof(*paths));
+    if (!indices || !paths) {
+        free(indices);
+        free(paths);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        indices[i] = sigs[i]->index < 0 ? UINT64_MAX : (uint64_t)sigs[i]->index;
+        paths[i] = (uint8_t *const *)sigs[i]->auth_path;
+    }
+
+    int proof_nodes = merkle_multiproof_size(params->h, indices, count);
+    int r = -1;
+    if (proof_nodes >= 0 && sigbatch_alloc(batch, params, count, proof_nodes) == 0 &&
+        merkle_multiproof_from_paths(params, params->h, indices, count, paths, batch->proof) == proof_nodes) {
+        for (int i = 0; i < count; i++) {
+            batch->indices[i] = indices[i];
+            memcpy(batch->wots[i].nonce, sigs[i]->wots_sig->nonce, WOTS_NONCE_BYTES);
+            for (int j = 0; j < params->wots_len; j++) {
+                memcpy(batch->wots[i].sig[j], sigs[i]->wots_sig->sig[j], params->n);
+            }
+        }
+        r = 0;
+    } else {
+        xmss_sigbatch_free(batch, params);
+    }
+    free(indices);
+    free(paths);
+    return r;
+}
+
+// Serialize: count, proof size, the entries, then the proof nodes
+int xmss_sigbatch_serialize(const xmss_params *params, const xmss_sigbatch *batch, uint8_t *out, size_t out_cap,
+                            size_t *out_len) {
+    size_t need = xmss_sigbatch_size(params, batch->count, batch->proof_nodes);
+    if (!out || out_cap < need) return -1;
+
+    u32le_store(out, (uint32_t)batch->count);
+    u32le_store(out + 4, (uint32_t)batch->proof_nodes);
+    size_t pos = 8;
+    for (int i = 0; i < batch->count; i++) {
+        u32le_store(out + pos, (uint32_t)batch->indices[i]);
+        pos += 4;
+        if (params->encoding == WOTS_ENCODING_TARGET_SUM) {
+            memcpy(out + pos, batch->wots[i].nonce, WOTS_NONCE_BYTES);
+            pos += WOTS_NONCE_BYTES;
+        }
+        for (int j = 0; j < params->wots_len; j++) {
+            memcpy(out + pos, batch->wots[i].sig[j], params->n);
+            pos += params->n;
+        }
+    }
+    memcpy(out + pos, batch->proof, (size_t)batch->proof_nodes * params->n);
+    pos += (size_t)batch->proof_nodes * params->n;
+
+    if (out_len) *out_len = pos;
+    return 0;
+}
+
+// Parse a serialized batch
+int xmss_sigbatch_deserialize(const xmss_params *params, xmss_sigbatch *batch, const uint8_t *in, size_t in_len) {
+    memset(batch, 0, sizeof(*batch));
+    if (!in || in_len < 8) return -1;
+    uint32_t count = u32le_load(in);
+    uint32_t proof_nodes = u32le_load(in + 4);
+    if (count == 0 || count > (uint32_t)INT32_MAX || proof_nodes > (uint32_t)INT32_MAX ||
+        (in_len - 8) / ((size_t)params->wots_len * params->n + 4) < count ||
+        (in_len - 8) / params->n < proof_nodes ||
+        in_len != xmss_sigbatch_size(params, (int)count, (int)proof_nodes)) {
+        fprintf(stderr, "ERROR: xmss_sigbatch_deserialize: input length %zu does not match the batch header\n", in_len);
+        return -1;
+    }
+    if (sigbatch_alloc(batch, params, (int)count, (int)proof_nodes) != 0) return -1;
+
+    size_t pos = 8;
+    for (uint32_t i = 0; i < count; i++) {
+        batch->indices[i] = u32le_load(in + pos);
+        pos += 4;
+        if (params->encoding == WOTS_ENCODING_TARGET_SUM) {
+            memcpy(batch->wots[i].nonce, in + pos, WOTS_NONCE_BYTES);
+            pos += WOTS_NONCE_BYTES;
+        }
+        for (int j = 0; j < params->wots_len; j++) {
+            memcpy(batch->wots[i].sig[j], in + pos, params->n);
+            pos += params->n;
+        }
+    }
+    memcpy(batch->proof, in + pos, (size_t)proof_nodes * params->n);
+    return 0;
+}
+
+// Save a batch file
+int xmss_sigbatch_save(const char *path, const xmss_sigbatch *batch, const xmss_params *params) {
+    size_t need = xmss_sigbatch_size(params, batch->count, batch->proof_nodes);
+    uint8_t *buf = malloc(need);
+    if (!buf) return -1;
+    size_t written = 0;
+    if (xmss_sigbatch_serialize(params, batch, buf, need, &written) != 0) {
+        free(buf);
+        return -1;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) { free(buf); return -1; }
+    uint32_t version = XMSS_SIGBATCH_VERSION;
+    int ok = fwrite(XMSS_SIGBATCH_MAGIC, 4, 1, f) == 1 && fwrite(&version, sizeof(version), 1, f) == 1 &&
+             xmss_params_write(f, params) == 0 && fwrite(buf, written, 1, f) == 1;
+    free(buf);
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+// Load a batch file
+int xmss_sigbatch_load(const char *path, xmss_sigbatch *batch, xmss_params *params) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    char magic[4];
+    uint32_t version;
+    uint8_t header[8];
+    if (fread(magic, 4, 1, f) != 1 || memcmp(magic, XMSS_SIGBATCH_MAGIC, 4) != 0 ||
+        fread(&version, sizeof(version), 1, f) != 1 || version != XMSS_SIGBATCH_VERSION) {
+        fprintf(stderr, "%s is not a signature batch file\n", path);
+        fclose(f);
+        return -1;
+    }
+    if (xmss_params_read(f, params) != 0 || fread(header, sizeof(header), 1, f) != 1) {
+        fprintf(stderr, "Failed to read the batch header from %s\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    // The header gives the size of the rest; read one extra byte to check for trailing data
+    uint32_t count = u32le_load(header), proof_nodes = u32le_load(header + 4);
+    if (count == 0 || count > (1u << 20) || proof_nodes > (uint32_t)count * (uint32_t)params->h) {
+        fprintf(stderr, "ERROR: Implausible batch header in %s\n", path);
+        fclose(f);
+        return -1;
+    }
+    size_t need = xmss_sigbatch_size(params, (int)count, (int)proof_nodes);
+    uint8_t *buf = malloc(need + 1);
+    if (!buf) { fclose(f); return -1; }
+    memcpy(buf, header, sizeof(header));
+    size_t got = sizeof(header) + fread(buf + sizeof(header), 1, need + 1 - sizeof(header), f);
+    fclose(f);
+    if (got != need) {
+        fprintf(stderr, "ERROR: Batch file size mismatch. Got %zu, expected %zu.\n", got, need);
+        free(buf);
+        return -1;
+    }
+
+    int r = xmss_sigbatch_deserialize(params, batch, buf, got);
+    free(buf);
+    return r == 0 ? 1 : -1;
+}
+
+// Verify a batch: recover the leaves, then rebuild the root once from the multi-proof
+int xmss_sigbatch_verify(const xmss_params *params, const uint8_t *const *msgs, const xmss_sigbatch *batch,
+                         const uint8_t *root, const uint8_t *pub_seed) {
+    size_t n = params->n;
+    if (batch->count <= 0) return 0;
+    uint8_t *leaves = malloc((size_t)batch->count * n);
+    if (!leaves) return 0;
+
+    xmss_arena *arena = xmss_arena_thread();
+    size_t mark = xmss_arena_begin(arena);
+    WOTSKey pk;
+    if (wots_alloc_key_arena(&pk, params, arena) != 0) abort();
+
+    // A leaf only counts if its WOTS+ signature decodes; a failed hash never verifies
+    int failed = 0;
+    for (int i = 0; i < batch->count && !failed; i++) {
+        uint8_t msg_hash[HASH_SIZE];
+        xmss_adrs ots_adrs;
+        xmss_hash(params, msgs[i], strlen((const char *)msgs[i]), msg_hash, n);
+        xmss_ots_adrs(&ots_adrs, batch->indices[i]);
+        if (wots_verify(params, msg_hash, &batch->wots[i], &pk, pub_seed, &ots_adrs) != 0) {
+            failed = 1;
+            break;
+        }
+        failed |= xmss_compress_leaf(params, pub_seed, batch->indices[i], pk.pk[0], leaves + (size_t)i * n);
+    }
+    wots_free_key_arena(&pk, params, arena);
+    xmss_arena_end(arena, mark);
+
+    uint8_t computed[HASH_SIZE];
+    int valid = !failed &&
+                merkle_multiproof_root(params, pub_seed, params->h, batch->indices, leaves, batch->count,
+                                       batch->proof, batch->proof_nodes, computed) == 0 &&
+                constant_time_equal(computed, root, n);
+    free(leaves);
+    return valid;
+}
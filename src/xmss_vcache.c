@@ -0,0 +1,141 @@
+// import standard libraries
+#include <stdlib.h>
+#include <string.h>
+
+// import project-specific headers
+#include "xmss_vcache.h"
+#include "xmss_arena.h"
+
+// Cache used by xmss_verify()
+static xmss_verify_cache *attached;
+
+// Allocate a cache
+int xmss_vcache_init(xmss_verify_cache *cache, uint64_t entries) {
+    memset(cache, 0, sizeof(*cache));
+    uint64_t buckets = 1;
+    while (buckets * XMSS_VCACHE_WAYS < entries) buckets <<= 1;
+    cache->entries = calloc(buckets * XMSS_VCACHE_WAYS, sizeof(xmss_vcache_entry));
+    cache->hands = calloc(buckets, 1);
+    if (!cache->entries || !cache->hands) {
+        free(cache->entries);
+        free(cache->hands);
+        return -1;
+    }
+    cache->buckets = buckets;
+    for (int i = 0; i < XMSS_VCACHE_STRIPES; i++) pthread_mutex_init(&cache->locks[i], NULL);
+    return 0;
+}
+
+// Free a cache (detaching it if attached)
+void xmss_vcache_free(xmss_verify_cache *cache) {
+    if (!cache->entries) return;
+    if (attached == cache) attached = NULL;
+    for (int i = 0; i < XMSS_VCACHE_STRIPES; i++) pthread_mutex_destroy(&cache->locks[i]);
+    free(cache->entries);
+    free(cache->hands);
+    cache->entries = NULL;
+    cache->hands = NULL;
+}
+
+// Digest of everything the verification result depends on
+int xmss_vcache_digest(const xmss_params *params, const uint8_t *msg_hash, const XMSSSignature *sig,
+                        const uint8_t *root, const uint8_t *pub_seed, uint8_t digest[HASH_SIZE]) {
+    size_t n = params->n;
+    // The same parameter words as key and signature headers, so the hash backend is part of the key
+    int32_t header[XMSS_PARAMS_WORDS];
+    xmss_params_encode(params, header);
+    size_t len = sizeof(header) + sizeof(int) + WOTS_NONCE_BYTES + XMSS_PUB_SEED_BYTES +
+                 ((size_t)params->wots_len + params->h + 2) * n;
+    // Scratch from the calling thread's arena, so a lookup makes no heap allocation
+    xmss_arena *arena = xmss_arena_thread();
+    size_t mark = xmss_arena_begin(arena);
+    uint8_t *buffer = xmss_arena_get(arena, len);
+    if (!buffer) abort();
+
+    uint8_t *p = buffer;
+    memcpy(p, header, sizeof(header)); p += sizeof(header);
+    memcpy(p, &sig->index, sizeof(int)); p += sizeof(int);
+
+    // The nonce only exists in the target-sum encoding
+    if (params->encoding == WOTS_ENCODING_TARGET_SUM) memcpy(p, sig->wots_sig->nonce, WOTS_NONCE_BYTES);
+    else memset(p, 0, WOTS_NONCE_BYTES);
+    p += WOTS_NONCE_BYTES;
+    if (pub_seed) memcpy(p, pub_seed, XMSS_PUB_SEED_BYTES);
+    else memset(p, 0, XMSS_PUB_SEED_BYTES);
+    p += XMSS_PUB_SEED_BYTES;
+    memcpy(p, msg_hash, n); p += n;
+    memcpy(p, root, n); p += n;
+    for (int i = 0; i < params->wots_len; i++, p += n) memcpy(p, sig->wots_sig->sig[i], n);
+    for (int i = 0; i < params->h; i++, p += n) memcpy(p, sig->auth_path[i], n);
+
+    int r = hash_shake256(buffer, len, digest, HASH_SIZE);
+    xmss_arena_put(arena, buffer);
+    xmss_arena_end(arena, mark);
+    return r;
+}
+
+// Bucket of a digest
+static uint64_t bucket_of(const xmss_verify_cache *cache, const uint8_t digest[HASH_SIZE]) {
+    uint64_t b;
+    memcpy(&b, digest, sizeof(b));
+    return b & (cache->buckets - 1);
+}
+
+// Look up a digest
+int xmss_vcache_lookup(xmss_verify_cache *cache, const uint8_t digest[HASH_SIZE]) {
+    uint64_t b = bucket_of(cache, digest);
+    xmss_vcache_entry *set = cache->entries + b * XMSS_VCACHE_WAYS;
+    int result = -1;
+
+    pthread_mutex_lock(&cache->locks[b % XMSS_VCACHE_STRIPES]);
+    for (int i = 0; i < XMSS_VCACHE_WAYS; i++) {
+        if (set[i].used && memcmp(set[i].digest, digest, HASH_SIZE) == 0) {
+            set[i].referenced = 1;
+            result = set[i].result;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache->locks[b % XMSS_VCACHE_STRIPES]);
+
+    __atomic_add_fetch(result < 0 ? &cache->misses : &cache->hits, 1, __ATOMIC_RELAXED);
+    return result;
+}
+
+// Insert a result, evicting with CLOCK: the hand skips (and clears) referenced entries
+void xmss_vcache_insert(xmss_verify_cache *cache, const uint8_t digest[HASH_SIZE], int result) {
+    uint64_t b = bucket_of(cache, digest);
+    xmss_vcache_entry *set = cache->entries + b * XMSS_VCACHE_WAYS;
+
+    pthread_mutex_lock(&cache->locks[b % XMSS_VCACHE_STRIPES]);
+    xmss_vcache_entry *slot = NULL;
+    for (int i = 0; i < XMSS_VCACHE_WAYS && !slot; i++) {
+        if (!set[i].used || memcmp(set[i].digest, digest, HASH_SIZE) == 0) slot = &set[i];
+    }
+    while (!slot) {
+        xmss_vcache_entry *e = &set[cache->hands[b]];
+        cache->hands[b] = (uint8_t)((cache->hands[b] + 1) % XMSS_VCACHE_WAYS);
+        if (e->referenced) e->referenced = 0;
+        else slot = e;
+    }
+    memcpy(slot->digest, digest, HASH_SIZE);
+    slot->used = 1;
+    slot->result = result ? 1 : 0;
+    slot->referenced = 0;
+    pthread_mutex_unlock(&cache->locks[b % XMSS_VCACHE_STRIPES]);
+}
+
+// Hit and miss counters
+void xmss_vcache_stats(const xmss_verify_cache *cache, uint64_t *hits, uint64_t *misses) {
+    if (hits) *hits = __atomic_load_n(&cache->hits, __ATOMIC_RELAXED);
+    if (misses) *misses = __atomic_load_n(&cache->misses, __ATOMIC_RELAXED);
+}
+
+// Attach a cache to xmss_verify()
+void xmss_vcache_use(xmss_verify_cache *cache) {
+    attached = cache;
+}
+
+// The attached cache
+xmss_verify_cache *xmss_vcache_attached(void) {
+    return attached;
+}
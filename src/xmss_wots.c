@@ -8,8 +8,8 @@
 #include "xmss_config.h"
 #include "util.h"
 
-// Generate a WOTS+ key for a specific leaf index
-void xmss_generate_wots_key(const xmss_params *params, XMSSKey *key, int index, WOTSKey *wots_key) {
+// Derive the WOTS+ secret key of a specific leaf index (0, or -1 with the key zeroed if the PRF failed)
+int xmss_derive_wots_sk(const xmss_params *params, const XMSSKey *key, int index, WOTSKey *wots_key) {
     // Buffer to hold the PRF input: master_seed || leaf_index
     uint8_t buffer[XMSS_SEED_BYTES + sizeof(int)];
     
@@ -17,27 +17,29 @@ void xmss_generate_wots_key(const xmss_params *params, XMSSKey *key, int index,
     memcpy(buffer, key->seed, XMSS_SEED_BYTES);
     memcpy(buffer + XMSS_SEED_BYTES, &index, sizeof(int));
     
-    // Allocate a temporary buffer to hold the full concatenated secret key
-    size_t sk_total_bytes = (size_t)params->wots_len * HASH_SIZE;
-    uint8_t *sk_concat = malloc(sk_total_bytes);
-    if (!sk_concat) {
-        // In a real application, handle this error more gracefully
-        abort();
-    }
-    
-    // Use SHAKE256 as a PRF to generate the entire WOTS+ secret key material
-    hash_shake256(buffer, sizeof(buffer), sk_concat, sk_total_bytes);
+    // Use the hash backend as a PRF to generate the entire WOTS+ secret key material, straight
+    // into the contiguous secret chains (locked memory, see wots_alloc_key())
+    int r = xmss_hash(params, buffer, sizeof(buffer), wots_key->sk[0], (size_t)params->wots_len * params->n);
     
-    // Distribute the generated material into the individual secret key chains
-    for(int i = 0; i < params->wots_len; i++) {
-        memcpy(wots_key->sk[i], sk_concat + (size_t)i * HASH_SIZE, HASH_SIZE);
-    }
-    
-    // Securely wipe the temporary buffers that held sensitive data
-    secure_zero_memory(sk_concat, sk_total_bytes);
+    // Securely wipe the temporary buffer that held sensitive data
     secure_zero_memory(buffer, sizeof(buffer));
-    free(sk_concat);
-    
+    return r;
+}
+
+// Generate a WOTS+ key for a specific leaf index
+int xmss_generate_wots_key(const xmss_params *params, XMSSKey *key, int index, WOTSKey *wots_key) {
+    if (xmss_derive_wots_sk(params, key, index, wots_key) != 0) return -1;
+
     // Compute the corresponding public key from the newly generated secret key
-    wots_compute_pk(params, wots_key);
+    xmss_adrs adrs;
+    xmss_ots_adrs(&adrs, (uint64_t)index);
+    wots_compute_pk(params, wots_key, key->pub_seed, &adrs);
+    return 0;
+}
+
+// Build the OTS hash address of a leaf
+void xmss_ots_adrs(xmss_adrs *adrs, uint64_t index) {
+    adrs_init(adrs);
+    adrs_set_type(adrs, XMSS_ADDR_TYPE_OTS);
+    adrs_set_ots(adrs, (uint32_t)index);
 }
\ No newline at end of file
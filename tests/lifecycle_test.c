@@ -0,0 +1,362 @@
+// Import standard libraries
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Import project-specific headers
+#include "xmss.h"
+#include "xmss_keygen.h"
+#include "xmss_shard.h"
+#include "xmss_registry.h"
+#include "xmss_keyring.h"
+#include "xmss_precomp.h"
+#include "xmss_vcache.h"
+#include "xmss_pathcache.h"
+#include "xmss_async.h"
+#include "xmss_cache.h"
+#include "xmss_config.h"
+#include "csprng.h"
+
+#define TEST_HEIGHT   6  // 64 leaves for the signing checks
+#define KILL_HEIGHT  10  // Large enough that keygen is still running when it is killed
+
+static int failures = 0;
+
+// Record one check
+static void check(const char *name, const char *what, int ok) {
+    if (!ok) {
+        printf("  FAIL %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+// Print the outcome of one test
+static void report(const char *name, int before) {
+    printf("%s %s\n", failures == before ? "PASS" : "FAIL", name);
+}
+
+// Root of the same seeds through the recursive xmss_keygen() path
+static int reference_root(const xmss_params *params, const XMSSKey *key, uint8_t *root) {
+    XMSSKey *ref = xmss_key_alloc();
+    if (!ref) return -1;
+    memcpy(ref->seed, key->seed, sizeof(ref->seed));
+    memcpy(ref->pub_seed, key->pub_seed, sizeof(ref->pub_seed));
+    xmss_keygen_root(params, ref);
+    memcpy(root, ref->root, params->n);
+    xmss_key_free(ref);
+    return 0;
+}
+
+// Keygen killed after a checkpoint and resumed from the progress file gives the xmss_keygen() root
+static void test_killed_keygen(void) {
+    const char *name = "killed keygen";
+    const char *path = "killed.progress";
+    xmss_params params;
+    if (xmss_params_init(&params, KILL_HEIGHT, 16) != 0 || xmss_params_set_n(&params, 16) != 0) {
+        check(name, "parameters", 0);
+        return;
+    }
+    remove(path);
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        XMSSKey *key = xmss_key_alloc();
+        _exit(key && xmss_keygen_resumable(&params, key, NULL, path, 1) == 0 ? 0 : 1);
+    }
+    if (child < 0) {
+        check(name, "fork", 0);
+        return;
+    }
+
+    // Kill the child as soon as its first checkpoint is on disk
+    int status = 0;
+    while (access(path, F_OK) != 0 && waitpid(child, &status, WNOHANG) == 0) usleep(1000);
+    kill(child, SIGKILL);
+    waitpid(child, &status, 0);
+    check(name, "killed before finishing", WIFSIGNALED(status) && access(path, F_OK) == 0);
+
+    XMSSKey *key = xmss_key_alloc();
+    uint8_t expect[HASH_SIZE];
+    check(name, "resume", key && xmss_keygen_resumable(&params, key, NULL, path, 1) == 0);
+    check(name, "progress file removed", access(path, F_OK) != 0);
+    check(name, "root matches xmss_keygen", key && reference_root(&params, key, expect) == 0 &&
+                                            memcmp(key->root, expect, params.n) == 0);
+    xmss_key_free(key);
+}
+
+// Sharded keygen: merging all shards gives the xmss_keygen() root; gaps and overlaps are rejected
+static void test_shards(const xmss_params *params) {
+    const char *name = "sharded keygen";
+    enum { N = 4 };
+    char paths[N][64], half[2][64];
+    XMSSKey *key = xmss_key_alloc(), *merged = xmss_key_alloc();
+    if (!key || !merged || xmss_shard_seed(params, key) != 0) {
+        check(name, "seed file", 0);
+        xmss_key_free(key);
+        xmss_key_free(merged);
+        return;
+    }
+    for (int i = 0; i < N; i++) {
+        snprintf(paths[i], sizeof(paths[i]), XMSS_SHARD_FILE_FMT, i, N);
+        check(name, "generate shard", xmss_shard_generate(params, key, i, N, 1, paths[i]) == 0);
+    }
+    for (int i = 0; i < 2; i++) {
+        snprintf(half[i], sizeof(half[i]), XMSS_SHARD_FILE_FMT, i, 2);
+        check(name, "generate half", xmss_shard_generate(params, key, i, 2, 0, half[i]) == 0);
+    }
+
+    xmss_params merged_params;
+    xmss_node_cache cache = {0};
+    int have_cache = 0;
+    uint8_t expect[HASH_SIZE];
+    const char *all[N] = { paths[0], paths[1], paths[2], paths[3] };
+    check(name, "merge", xmss_shard_merge(all, N, &merged_params, merged, &cache, &have_cache) == 0);
+    check(name, "root matches xmss_keygen", reference_root(params, key, expect) == 0 &&
+                                            memcmp(merged->root, expect, params->n) == 0);
+    check(name, "cache from the shard segments", have_cache && memcmp(cache.root, expect, params->n) == 0);
+    if (have_cache) xmss_cache_free(&cache);
+
+    // Shard 1 of 4 missing, then shard 1 of 4 inside 0 of 2
+    const char *gap[] = { paths[0], paths[2], paths[3] };
+    const char *overlap[] = { half[0], paths[1], half[1] };
+    check(name, "reject gap", xmss_shard_merge(gap, 3, &merged_params, merged, NULL, &have_cache) != 0);
+    check(name, "reject overlap", xmss_shard_merge(overlap, 3, &merged_params, merged, NULL, &have_cache) != 0);
+
+    for (int i = 0; i < N; i++) remove(paths[i]);
+    for (int i = 0; i < 2; i++) remove(half[i]);
+    remove(XMSS_SEED_FILE);
+    xmss_key_free(key);
+    xmss_key_free(merged);
+}
+
+// Registry: put, remove and reopen read-only
+static void test_registry(const xmss_params *params) {
+    const char *name = "registry";
+    const char *path = "lifecycle.reg";
+    uint8_t root_a[HASH_SIZE], root_b[HASH_SIZE], seed[XMSS_PUB_SEED_BYTES];
+    csprng_random_bytes(root_a, sizeof(root_a));
+    csprng_random_bytes(root_b, sizeof(root_b));
+    csprng_random_bytes(seed, sizeof(seed));
+    remove(path);
+
+    xmss_registry reg;
+    check(name, "create", xmss_registry_open(&reg, path, 1) == 0);
+    check(name, "put", xmss_registry_put(&reg, 2, params, root_a, seed) == 0 &&
+                       xmss_registry_put(&reg, 9, params, root_b, seed) == 0);
+    check(name, "remove", xmss_registry_remove(&reg, 2) == 0 && xmss_registry_lookup(&reg, 2) == NULL);
+    xmss_registry_close(&reg);
+
+    check(name, "reopen", xmss_registry_open(&reg, path, 0) == 0);
+    const xmss_registry_record *rec = xmss_registry_lookup(&reg, 9);
+    check(name, "record survives", rec && memcmp(rec->root, root_b, params->n) == 0 &&
+                                   memcmp(rec->pub_seed, seed, sizeof(seed)) == 0 &&
+                                   xmss_registry_record_matches(rec, params));
+    check(name, "removed stays removed", xmss_registry_lookup(&reg, 2) == NULL);
+    check(name, "unknown id", xmss_registry_lookup(&reg, 1000) == NULL);
+    xmss_registry_close(&reg);
+    remove(path);
+}
+
+// Keyring: the next leaf survives closing and reopening the ring
+static void test_keyring(const xmss_params *params) {
+    const char *name = "keyring";
+    const char *dir = "lifecycle_ring";
+    const uint8_t *msg = (const uint8_t *)"keyring message";
+    xmss_keyring ring;
+    XMSSSignature sig;
+    if (xmss_keyring_open(&ring, dir) != 0 || xmss_alloc_sig(&sig, params) != 0) {
+        check(name, "open", 0);
+        return;
+    }
+    check(name, "generate", xmss_keyring_generate(&ring, 7, params) == 0);
+    check(name, "sign twice", xmss_keyring_sign(&ring, 7, msg, &sig) == 0 && sig.index == 0 &&
+                              xmss_keyring_sign(&ring, 7, msg, &sig) == 0 && sig.index == 1);
+    xmss_keyring_close(&ring);
+
+    check(name, "reopen", xmss_keyring_open(&ring, dir) == 0);
+    xmss_keyring_entry *entry = xmss_keyring_find(&ring, 7);
+    check(name, "state survives", entry && entry->next_index == 2);
+    if (entry) {
+        const uint8_t *pub_seed = params->hash_mode == XMSS_HASH_TWEAKED ? entry->key->pub_seed : NULL;
+        check(name, "next signature after reopen", xmss_keyring_sign(&ring, 7, msg, &sig) == 0 && sig.index == 2 &&
+                                                   xmss_verify(params, msg, &sig, entry->key->root, pub_seed) == 1);
+    }
+    xmss_keyring_close(&ring);
+    xmss_free_sig(&sig, params);
+
+    char path[128];
+    snprintf(path, sizeof(path), XMSS_KEYRING_KEY_FMT, dir, 7u);
+    remove(path);
+    snprintf(path, sizeof(path), XMSS_KEYRING_STATE_FMT, dir, 7u);
+    remove(path);
+    snprintf(path, sizeof(path), XMSS_KEYRING_CACHE_FMT, dir, 7u);
+    remove(path);
+    rmdir(dir);
+}
+
+// Precomputed leaves sign verifiable signatures, and only for prepared leaves
+static void test_precomp(const xmss_params *params, XMSSKey *key) {
+    const char *name = "precomp";
+    const uint8_t *msg = (const uint8_t *)"precomputed message";
+    xmss_precomp_pool pool;
+    XMSSSignature sig;
+    if (xmss_precomp_init(&pool, params, 4) != 0 || xmss_alloc_sig(&sig, params) != 0) {
+        check(name, "allocate", 0);
+        return;
+    }
+    check(name, "fill", xmss_precomp_fill(&pool, params, key, 10) == 4);
+    check(name, "sign prepared leaf", xmss_precomp_sign(&pool, params, msg, key, &sig, 11) == 0 && sig.index == 11);
+    check(name, "verify", xmss_verify(params, msg, &sig, key->root, NULL) == 1);
+    check(name, "reject used leaf", xmss_precomp_sign(&pool, params, msg, key, &sig, 11) != 0);
+    check(name, "reject unprepared leaf", xmss_precomp_sign(&pool, params, msg, key, &sig, 20) != 0);
+    xmss_free_sig(&sig, params);
+    xmss_precomp_free(&pool, params);
+}
+
+// Verified-signature cache: a repeat is a hit, and a hit returns the stored result
+static void test_vcache(const xmss_params *params, XMSSKey *key) {
+    const char *name = "vcache";
+    const uint8_t *msg = (const uint8_t *)"cached message";
+    xmss_verify_cache cache;
+    XMSSSignature sig;
+    if (xmss_vcache_init(&cache, 64) != 0 || xmss_alloc_sig(&sig, params) != 0) {
+        check(name, "allocate", 0);
+        return;
+    }
+    check(name, "sign", xmss_sign_index(params, msg, key, &sig, 5) == 0);
+    xmss_vcache_use(&cache);
+    uint64_t hits, misses;
+    check(name, "first verify", xmss_verify(params, msg, &sig, key->root, NULL) == 1);
+    check(name, "repeat verify", xmss_verify(params, msg, &sig, key->root, NULL) == 1);
+    xmss_vcache_stats(&cache, &hits, &misses);
+    check(name, "one miss then one hit", hits == 1 && misses == 1);
+
+    // A forged signature with a planted "valid" entry must come back valid: the cache answered
+    sig.auth_path[0][0] ^= 1;
+    uint8_t msg_hash[HASH_SIZE], digest[HASH_SIZE];
+    check(name, "forged rejected", xmss_verify(params, msg, &sig, key->root, NULL) == 0);
+    check(name, "digest", xmss_hash(params, msg, strlen((const char *)msg), msg_hash, params->n) == 0 &&
+                          xmss_vcache_digest(params, msg_hash, &sig, key->root, NULL, digest) == 0);
+    xmss_vcache_insert(&cache, digest, 1);
+    check(name, "hit returns the cached result", xmss_verify(params, msg, &sig, key->root, NULL) == 1);
+    xmss_vcache_use(NULL);
+    check(name, "detached cache not used", xmss_verify(params, msg, &sig, key->root, NULL) == 0);
+    xmss_free_sig(&sig, params);
+    xmss_vcache_free(&cache);
+}
+
+// Proven-node cache: a sibling leaf ends early on a cached node, and a changed path still fails
+static void test_pathcache(const xmss_params *params, XMSSKey *key) {
+    const char *name = "pathcache";
+    const uint8_t *msg = (const uint8_t *)"path cache message";
+    xmss_path_cache cache;
+    XMSSSignature first, second;
+    if (xmss_pathcache_init(&cache, params, key->root, NULL) != 0 || xmss_alloc_sig(&first, params) != 0 ||
+        xmss_alloc_sig(&second, params) != 0) {
+        check(name, "allocate", 0);
+        return;
+    }
+    check(name, "sign", xmss_sign_index(params, msg, key, &first, 20) == 0 &&
+                        xmss_sign_index(params, msg, key, &second, 21) == 0);
+    xmss_pathcache_use(&cache);
+    check(name, "first verify", xmss_verify(params, msg, &first, key->root, NULL) == 1 && cache.hits == 0);
+    check(name, "sibling hits the cache", xmss_verify(params, msg, &second, key->root, NULL) == 1 && cache.hits == 1);
+    second.auth_path[params->h - 1][0] ^= 1;
+    check(name, "changed path rejected", xmss_verify(params, msg, &second, key->root, NULL) == 0);
+    xmss_free_sig(&first, params);
+    xmss_free_sig(&second, params);
+    xmss_pathcache_free(&cache);
+}
+
+// Async queue: a sign job, then verify jobs for the signature and a changed message
+static void notify_done(xmss_async_job *job) {
+    __atomic_add_fetch((int *)job->user, 1, __ATOMIC_SEQ_CST);
+}
+
+static void test_async(const xmss_params *params, XMSSKey *key) {
+    const char *name = "async";
+    const uint8_t *msg = (const uint8_t *)"async message";
+    XMSSSignature sig;
+    int fds[2], done = 0;
+    xmss_async *q = xmss_async_create(2, 8);
+    if (!q || xmss_alloc_sig(&sig, params) != 0 || pipe(fds) != 0) {
+        check(name, "create", 0);
+        if (q) xmss_async_destroy(q);
+        return;
+    }
+    remove(XMSS_STATE_FILE);
+
+    xmss_async_job sign = { .op = XMSS_ASYNC_SIGN, .params = params, .msg = msg, .sig = &sig, .key = key,
+                            .done = notify_done, .user = &done, .notify_fd = fds[1] };
+    uint64_t note = 0;
+    check(name, "submit sign", xmss_async_submit(q, &sign) == 0);
+    check(name, "sign notified", read(fds[0], &note, sizeof(note)) == sizeof(note) && note == 1);
+    check(name, "sign result", sign.result == 0 && sig.index == 0);
+
+    xmss_async_job good = { .op = XMSS_ASYNC_VERIFY, .params = params, .msg = msg, .sig = &sig,
+                            .root = key->root, .done = notify_done, .user = &done, .notify_fd = -1 };
+    xmss_async_job bad = good;
+    bad.msg = (const uint8_t *)"async messagf";
+    check(name, "submit verify", xmss_async_submit(q, &good) == 0 && xmss_async_submit(q, &bad) == 0);
+    xmss_async_destroy(q);
+    check(name, "verify results", good.result == 1 && bad.result == 0);
+    check(name, "every callback ran", __atomic_load_n(&done, __ATOMIC_SEQ_CST) == 3);
+
+    int next = -1;
+    check(name, "state advanced", xmss_load_state_file(XMSS_STATE_FILE, &next) == 1 && next == 1);
+    remove(XMSS_STATE_FILE);
+    close(fds[0]);
+    close(fds[1]);
+    xmss_free_sig(&sig, params);
+}
+
+// Key lifecycle checks, run in a scratch directory
+int main() {
+    char dir[] = "/tmp/lifecycle_test.XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        printf("Cannot create a scratch directory\n");
+        return 1;
+    }
+    csprng_seed_from_int(2024);
+
+    xmss_params params;
+    XMSSKey *key = xmss_key_alloc();
+    if (!key || xmss_params_init(&params, TEST_HEIGHT, 16) != 0 || xmss_params_set_n(&params, 16) != 0) {
+        printf("Cannot set up the test key\n");
+        return 1;
+    }
+    xmss_keygen(&params, key);
+
+    int before = failures;
+    test_killed_keygen();
+    report("killed keygen", before);
+    before = failures;
+    test_shards(&params);
+    report("sharded keygen", before);
+    before = failures;
+    test_registry(&params);
+    report("registry", before);
+    before = failures;
+    test_keyring(&params);
+    report("keyring", before);
+    before = failures;
+    test_precomp(&params, key);
+    report("precomp", before);
+    before = failures;
+    test_vcache(&params, key);
+    report("vcache", before);
+    before = failures;
+    test_pathcache(&params, key);
+    report("pathcache", before);
+    before = failures;
+    test_async(&params, key);
+    report("async", before);
+
+    xmss_key_free(key);
+    if (chdir("/") == 0) rmdir(dir);
+    printf("%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
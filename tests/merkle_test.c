@@ -0,0 +1,181 @@
+// Import standard libraries
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Import project-specific headers
+#include "xmss.h"
+#include "merkle.h"
+#include "thash.h"
+#include "xmss_config.h"
+#include "xmss_parallel.h"
+#include "csprng.h"
+
+#define LARGE_LEAVES 300001 // Odd, and large enough for the threaded levels
+
+static int failures = 0;
+
+// Record one check
+static void check(const char *name, const char *what, int ok) {
+    if (!ok) {
+        printf("  FAIL %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+// Reference root: recursive, a subtree with no right half is its left half carried up
+static void naive_root(const xmss_params *params, const uint8_t *pub_seed, const uint8_t *leaves,
+                       uint64_t num_leaves, int height, uint64_t index, uint8_t *out) {
+    size_t n = params->n;
+    uint64_t first = index << height;
+    if (height == 0) {
+        memcpy(out, leaves + first * n, n);
+        return;
+    }
+    uint8_t left[HASH_SIZE], right[HASH_SIZE];
+    naive_root(params, pub_seed, leaves, num_leaves, height - 1, 2 * index, left);
+    if (first + (1ULL << (height - 1)) >= num_leaves) {
+        memcpy(out, left, n);
+        return;
+    }
+    naive_root(params, pub_seed, leaves, num_leaves, height - 1, 2 * index + 1, right);
+    thash_node(params, pub_seed, height, index, left, right, out);
+}
+
+// Random leaves
+static uint8_t *random_leaves(const xmss_params *params, uint64_t num_leaves) {
+    uint8_t *leaves = malloc(num_leaves * params->n);
+    if (leaves) csprng_random_bytes(leaves, num_leaves * params->n);
+    return leaves;
+}
+
+// Small odd and even leaf counts: root against the reference, and every auth path back to it
+static void test_counts(const xmss_params *params, const uint8_t *pub_seed) {
+    static const uint64_t counts[] = { 1, 2, 3, 5, 7, 8, 13, 1000 };
+    size_t n = params->n;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        uint64_t num = counts[c];
+        char name[32];
+        snprintf(name, sizeof(name), "%llu leaves", (unsigned long long)num);
+        uint8_t *leaves = random_leaves(params, num);
+        int height = merkle_height(num);
+        uint8_t *path = malloc((size_t)(height ? height : 1) * n);
+        uint8_t *work = malloc(merkle_workspace_bytes(params, num) + 1);
+        if (!leaves || !path || !work) {
+            check(name, "allocate", 0);
+            free(leaves); free(path); free(work);
+            continue;
+        }
+
+        uint8_t expect[HASH_SIZE], root[HASH_SIZE], from_path[HASH_SIZE];
+        naive_root(params, pub_seed, leaves, num, height, 0, expect);
+        check(name, "root", merkle_compute_root(params, pub_seed, leaves, num, NULL, root) == 0 &&
+                            memcmp(root, expect, n) == 0);
+        check(name, "root in caller workspace", merkle_compute_root(params, pub_seed, leaves, num, work, root) == 0 &&
+                                                memcmp(root, expect, n) == 0);
+
+        int paths_ok = 1;
+        for (uint64_t i = 0; i < num; i++) {
+            paths_ok &= merkle_auth_path(params, pub_seed, leaves, num, i, work, path, root) == 0 &&
+                        memcmp(root, expect, n) == 0 &&
+                        merkle_root_from_path(params, pub_seed, leaves + i * n, i, num, path, from_path) == 0 &&
+                        memcmp(from_path, expect, n) == 0;
+        }
+        check(name, "every auth path", paths_ok);
+        check(name, "reject index out of range", merkle_auth_path(params, pub_seed, leaves, num, num, work, path, root) != 0);
+
+        // Repeating the last leaf of an odd level must not give the same root
+        if (num > 1 && (num & 1)) {
+            uint8_t *padded = malloc((num + 1) * n);
+            if (padded) {
+                memcpy(padded, leaves, num * n);
+                memcpy(padded + num * n, leaves + (num - 1) * n, n);
+                check(name, "duplicated last leaf changes the root",
+                      merkle_compute_root(params, pub_seed, padded, num + 1, NULL, root) == 0 &&
+                      memcmp(root, expect, n) != 0);
+                free(padded);
+            }
+        }
+        free(leaves);
+        free(path);
+        free(work);
+    }
+}
+
+// A power-of-two tree over the XMSS leaves is the XMSS tree
+static void test_xmss_tree(const xmss_params *params) {
+    const char *name = "xmss tree";
+    size_t n = params->n;
+    uint64_t num = 1ULL << params->h;
+    XMSSKey *key = xmss_key_alloc();
+    uint8_t *leaves = malloc(num * n);
+    if (!key || !leaves) {
+        check(name, "allocate", 0);
+        xmss_key_free(key);
+        free(leaves);
+        return;
+    }
+    xmss_keygen(params, key);
+    for (uint64_t i = 0; i < num; i++) compute_node(params, leaves + i * n, key, 0, i);
+    uint8_t root[HASH_SIZE];
+    const uint8_t *pub_seed = params->hash_mode == XMSS_HASH_TWEAKED ? key->pub_seed : NULL;
+    check(name, "root matches the key", merkle_compute_root(params, pub_seed, leaves, num, NULL, root) == 0 &&
+                                        memcmp(root, key->root, n) == 0);
+    xmss_key_free(key);
+    free(leaves);
+}
+
+// Many leaves: heap levels instead of the stack, and the threaded levels give the serial root
+static void test_large(const xmss_params *params, const uint8_t *pub_seed) {
+    const char *name = "large tree";
+    size_t n = params->n;
+    uint64_t num = LARGE_LEAVES;
+    uint8_t *leaves = random_leaves(params, num);
+    uint8_t *path = malloc((size_t)merkle_height(num) * n);
+    if (!leaves || !path) {
+        check(name, "allocate", 0);
+        free(leaves);
+        free(path);
+        return;
+    }
+    uint8_t serial[HASH_SIZE], threaded[HASH_SIZE], from_path[HASH_SIZE];
+    check(name, "serial root", merkle_compute_root(params, pub_seed, leaves, num, NULL, serial) == 0);
+    if (xmss_parallel_start(4) == 0) {
+        check(name, "threaded root", merkle_compute_root(params, pub_seed, leaves, num, NULL, threaded) == 0 &&
+                                     memcmp(serial, threaded, n) == 0);
+        xmss_parallel_stop();
+    } else {
+        check(name, "start workers", 0);
+    }
+    uint64_t leaf = num - 1;
+    check(name, "last leaf path", merkle_auth_path(params, pub_seed, leaves, num, leaf, NULL, path, threaded) == 0 &&
+                                  merkle_root_from_path(params, pub_seed, leaves + leaf * n, leaf, num, path, from_path) == 0 &&
+                                  memcmp(from_path, serial, n) == 0);
+    free(leaves);
+    free(path);
+}
+
+// Merkle builder checks under plain and tweaked hashing
+int main() {
+    static const int modes[] = { XMSS_HASH_PLAIN, XMSS_HASH_TWEAKED };
+    csprng_seed_from_int(2024);
+    uint8_t pub_seed[HASH_SIZE];
+    csprng_random_bytes(pub_seed, sizeof(pub_seed));
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        xmss_params params;
+        if (xmss_params_init(&params, 6, 16) != 0 || xmss_params_set_n(&params, 16) != 0 ||
+            xmss_params_set_hash_mode(&params, modes[m]) != 0) {
+            check("parameters", "init", 0);
+            continue;
+        }
+        int before = failures;
+        test_counts(&params, pub_seed);
+        test_xmss_tree(&params);
+        test_large(&params, pub_seed);
+        printf("%s %s hashing\n", failures == before ? "PASS" : "FAIL",
+               modes[m] == XMSS_HASH_TWEAKED ? "tweaked" : "plain");
+    }
+    printf("%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+// Import standard libraries
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Import project-specific headers
+#include "xmss.h"
+#include "xmss_eth.h"
+#include "xmss_sigbatch.h"
+#include "merkle.h"
+#include "wots_kernels.h"
+#include "xmss_config.h"
+#include "csprng.h"
+
+#define TEST_HEIGHT 4 // 16 leaves keep every case fast
+
+// One parameter set under test
+typedef struct {
+    const char *name;
+    int w, n, encoding, hash_mode, backend;
+} roundtrip_case;
+
+static const roundtrip_case cases[] = {
+    { "checksum w=4 (specialized)",     4, 32, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_PLAIN,   HASH_BACKEND_SHAKE256 },
+    { "checksum w=16 (specialized)",   16, 32, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_PLAIN,   HASH_BACKEND_SHAKE256 },
+    { "checksum w=256 (specialized)", 256, 32, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_PLAIN,   HASH_BACKEND_SHAKE256 },
+    { "checksum w=8 (generic)",         8, 24, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_PLAIN,   HASH_BACKEND_SHAKE256 },
+    { "target-sum w=16",               16, 32, WOTS_ENCODING_TARGET_SUM, XMSS_HASH_PLAIN,   HASH_BACKEND_SHAKE256 },
+    { "tweaked shake256",              16, 32, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_TWEAKED, HASH_BACKEND_SHAKE256 },
+    { "tweaked sha256 n=16",           16, 16, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_TWEAKED, HASH_BACKEND_SHA256 },
+    { "poseidon2",                     16, 32, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_PLAIN,   HASH_BACKEND_POSEIDON2 },
+    { "poseidon2 target-sum tweaked",  16, 32, WOTS_ENCODING_TARGET_SUM, XMSS_HASH_TWEAKED, HASH_BACKEND_POSEIDON2 },
+    { "sha256",                        16, 32, WOTS_ENCODING_CHECKSUM,   XMSS_HASH_PLAIN,   HASH_BACKEND_SHA256 },
+    { "sha256 target-sum",              4, 24, WOTS_ENCODING_TARGET_SUM, XMSS_HASH_PLAIN,   HASH_BACKEND_SHA256 },
+};
+
+static int failures = 0;
+
+// Record one check
+static void check(const char *name, const char *what, int ok) {
+    if (!ok) {
+        printf("  FAIL %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+// Parameters of a case
+static int case_params(const roundtrip_case *c, xmss_params *params) {
+    return xmss_params_init(params, TEST_HEIGHT, c->w) != 0 ||
+           xmss_params_set_n(params, c->n) != 0 ||
+           xmss_params_set_encoding(params, c->encoding, 0) != 0 ||
+           xmss_params_set_hash_mode(params, c->hash_mode) != 0 ||
+           xmss_params_set_hash_backend(params, c->backend) != 0 ? -1 : 0;
+}
+
+// Sign at a few leaves and verify directly and through the Ethereum compact form
+static void test_roundtrip(const roundtrip_case *c, const xmss_params *params, XMSSKey *key) {
+    static const int leaves[] = { 0, 5, (1 << TEST_HEIGHT) - 1 };
+    const uint8_t *pub_seed = params->hash_mode == XMSS_HASH_TWEAKED ? key->pub_seed : NULL;
+    XMSSSignature sig, parsed;
+    if (xmss_alloc_sig(&sig, params) != 0) {
+        check(c->name, "allocate signature", 0);
+        return;
+    }
+    size_t sig_size = xmss_eth_sig_size(params);
+    uint8_t *buf = malloc(sig_size);
+
+    for (size_t i = 0; i < sizeof(leaves) / sizeof(leaves[0]); i++) {
+        const uint8_t *msg = (const uint8_t *)"round trip message";
+        check(c->name, "sign", xmss_sign_index(params, msg, key, &sig, leaves[i]) == 0);
+        check(c->name, "verify", xmss_verify(params, msg, &sig, key->root, pub_seed) == 1);
+        check(c->name, "reject other message",
+              xmss_verify(params, (const uint8_t *)"round trip messagf", &sig, key->root, pub_seed) == 0);
+
+        // Serialize and parse; the parsed copy must verify too
+        xmss_params parsed_params = *params;
+        size_t len = 0;
+        int ok = buf && xmss_eth_serialize(params, &sig, buf, sig_size, &len) == 0 && len == sig_size &&
+                 xmss_alloc_sig(&parsed, params) == 0;
+        if (ok) {
+            ok = xmss_eth_deserialize(&parsed_params, &parsed, buf, len) == 0 &&
+                 xmss_verify(params, msg, &parsed, key->root, pub_seed) == 1;
+            xmss_free_sig(&parsed, params);
+        }
+        check(c->name, "serialized round trip", ok);
+    }
+
+    // An index outside the tree is rejected
+    const uint8_t *msg = (const uint8_t *)"round trip message";
+    sig.index = 1 << TEST_HEIGHT;
+    check(c->name, "reject index past the tree", xmss_verify(params, msg, &sig, key->root, pub_seed) == 0);
+    sig.index = -1;
+    check(c->name, "reject negative index", xmss_verify(params, msg, &sig, key->root, pub_seed) == 0);
+    free(buf);
+    xmss_free_sig(&sig, params);
+}
+
+// Signature files: a saved signature loads and verifies, a file with the parameter header but
+// no XSIG magic is rejected, and an original headerless file of a SHAKE256, n = 32 key still loads
+static void test_sig_file(const roundtrip_case *c, const xmss_params *params, XMSSKey *key) {
+    const char *path = "roundtrip_sig.tmp";
+    const uint8_t *msg = (const uint8_t *)"signature file";
+    const uint8_t *pub_seed = params->hash_mode == XMSS_HASH_TWEAKED ? key->pub_seed : NULL;
+    size_t sig_size = xmss_eth_sig_size(params);
+    XMSSSignature sig, loaded;
+    xmss_params loaded_params;
+    uint8_t *buf = malloc(sig_size);
+    if (!buf || xmss_alloc_sig(&sig, params) != 0) {
+        check(c->name, "allocate signature", 0);
+        free(buf);
+        return;
+    }
+    check(c->name, "sign for file", xmss_sign_index(params, msg, key, &sig, 3) == 0 &&
+                                    xmss_eth_serialize(params, &sig, buf, sig_size, NULL) == 0);
+
+    int ok = xmss_eth_save_sig(path, &sig, params) == 0 && xmss_eth_load_sig(path, &loaded, &loaded_params) == 1;
+    if (ok) {
+        ok = xmss_params_equal(&loaded_params, params) && xmss_verify(params, msg, &loaded, key->root, pub_seed) == 1;
+        xmss_free_sig(&loaded, &loaded_params);
+    }
+    check(c->name, "signature file round trip", ok);
+
+    // Parameter header without the magic
+    FILE *f = fopen(path, "wb");
+    ok = f && xmss_params_write(f, params) == 0 && fwrite(buf, sig_size, 1, f) == 1;
+    if (f) fclose(f);
+    check(c->name, "reject file without magic", ok && xmss_eth_load_sig(path, &loaded, &loaded_params) == -1);
+
+    // Original layout: int h, int w, then the signature
+    xmss_params original;
+    if (xmss_params_init(&original, params->h, params->w) == 0 && xmss_params_equal(&original, params)) {
+        int hw[2] = { params->h, params->w };
+        f = fopen(path, "wb");
+        ok = f && fwrite(hw, sizeof(hw), 1, f) == 1 && fwrite(buf, sig_size, 1, f) == 1;
+        if (f) fclose(f);
+        ok = ok && xmss_eth_load_sig(path, &loaded, &loaded_params) == 1;
+        if (ok) {
+            ok = xmss_verify(&loaded_params, msg, &loaded, key->root, pub_seed) == 1;
+            xmss_free_sig(&loaded, &loaded_params);
+        }
+        check(c->name, "load original headerless file", ok);
+    }
+    remove(path);
+    free(buf);
+    xmss_free_sig(&sig, params);
+}
+
+// Checksum encoding: the checksum digits must carry the whole checksum, and changing only a
+// checksum chain of a signature must invalidate it
+static void test_checksum(const roundtrip_case *c, const xmss_params *params, XMSSKey *key) {
+    const uint8_t *pub_seed = params->hash_mode == XMSS_HASH_TWEAKED ? key->pub_seed : NULL;
+    XMSSSignature sig;
+    if (xmss_alloc_sig(&sig, params) != 0) {
+        check(c->name, "allocate signature", 0);
+        return;
+    }
+
+    int encoded = 1;
+    for (int t = 0; t < 64 && encoded; t++) {
+        uint8_t msg_hash[HASH_SIZE];
+        uint8_t digits[WOTS_LEN_MAX];
+        csprng_random_bytes(msg_hash, params->n);
+        if (wots_verify_digits(params, msg_hash, sig.wots_sig, digits) != 0) {
+            encoded = 0;
+            break;
+        }
+        uint64_t checksum = 0, value = 0;
+        for (int i = 0; i < params->wots_len1; i++) checksum += (uint64_t)(params->w - 1 - digits[i]);
+        for (int i = 0; i < params->wots_len2; i++) value = (value << params->log_w) | digits[params->wots_len1 + i];
+        encoded = value == checksum;
+    }
+    check(c->name, "checksum digits encode the full checksum", encoded);
+
+    const uint8_t *msg = (const uint8_t *)"checksum message";
+    int ok = xmss_sign_index(params, msg, key, &sig, 6) == 0 && xmss_verify(params, msg, &sig, key->root, pub_seed) == 1;
+    check(c->name, "sign for checksum tamper", ok);
+    for (int i = 0; ok && i < params->wots_len2; i++) {
+        uint8_t *chain = sig.wots_sig->sig[params->wots_len1 + i];
+        chain[0] ^= 0x80;
+        check(c->name, "reject changed checksum chain", xmss_verify(params, msg, &sig, key->root, pub_seed) == 0);
+        chain[0] ^= 0x80;
+    }
+    check(c->name, "verify restored signature", !ok || xmss_verify(params, msg, &sig, key->root, pub_seed) == 1);
+    xmss_free_sig(&sig, params);
+}
+
+// Sign k leaves, merge their auth paths into a multi-proof and rebuild the root from it
+static void test_multiproof(const roundtrip_case *c, const xmss_params *params, XMSSKey *key) {
+    enum { K = 5 };
+    static const int leaves[K] = { 1, 2, 3, 8, 13 };
+    const char *msgs[K] = { "m0", "m1", "m2", "m3", "m4" };
+    const uint8_t *pub_seed = params->hash_mode == XMSS_HASH_TWEAKED ? key->pub_seed : NULL;
+    XMSSSignature sigs[K];
+    XMSSSignature *order[K];
+    uint8_t *const *paths[K];
+    uint64_t indices[K];
+    uint8_t leaf_nodes[K * HASH_SIZE];
+    size_t n = params->n;
+    int made = 0, ok = 1;
+
+    for (; made < K && ok; made++) {
+        ok = xmss_alloc_sig(&sigs[made], params) == 0 &&
+             xmss_sign_index(params, (const uint8_t *)msgs[made], key, &sigs[made], leaves[made]) == 0;
+        order[made] = &sigs[made];
+        paths[made] = sigs[made].auth_path;
+        indices[made] = (uint64_t)leaves[made];
+    }
+    check(c->name, "sign multi-proof leaves", ok);
+
+    // Recover every leaf from its WOTS+ signature, as a verifier would
+    for (int i = 0; ok && i < K; i++) {
+        uint8_t msg_hash[HASH_SIZE];
+        xmss_adrs ots_adrs;
+        WOTSKey pk;
+        xmss_hash(params, (const uint8_t *)msgs[i], strlen(msgs[i]), msg_hash, n);
+        xmss_ots_adrs(&ots_adrs, indices[i]);
+        ok = wots_alloc_key(&pk, params) == 0;
+        if (!ok) break;
+        ok = wots_verify(params, msg_hash, sigs[i].wots_sig, &pk, pub_seed, &ots_adrs) == 0 &&
+             xmss_compress_leaf(params, pub_seed, indices[i], pk.pk[0], leaf_nodes + i * n) == 0;
+        wots_free_key(&pk, params);
+    }
+    check(c->name, "recover leaves", ok);
+
+    // The proof holds fewer nodes than the separate auth paths and rebuilds the key's root
+    int nodes = ok ? merkle_multiproof_size(params->h, indices, K) : -1;
+    uint8_t *proof = malloc((size_t)(nodes > 0 ? nodes : 1) * n);
+    uint8_t root[HASH_SIZE];
+    ok = nodes > 0 && nodes < K * params->h && proof &&
+         merkle_multiproof_from_paths(params, params->h, indices, K, paths, proof) == nodes &&
+         merkle_multiproof_root(params, pub_seed, params->h, indices, leaf_nodes, K, proof, nodes, root) == 0 &&
+         memcmp(root, key->root, n) == 0;
+    check(c->name, "multi-proof rebuilds the root", ok);
+
+    // A changed proof node gives another root
+    if (ok) {
+        proof[0] ^= 1;
+        merkle_multiproof_root(params, pub_seed, params->h, indices, leaf_nodes, K, proof, nodes, root);
+        check(c->name, "reject changed proof node", memcmp(root, key->root, n) != 0);
+    }
+    free(proof);
+
+    // The same through a serialized signature batch
+    xmss_sigbatch batch, parsed;
+    const uint8_t *batch_msgs[K];
+    for (int i = 0; i < K; i++) batch_msgs[i] = (const uint8_t *)msgs[i];
+    ok = made == K && xmss_sigbatch_build(params, &batch, order, K) == 0;
+    if (ok) {
+        size_t size = xmss_sigbatch_size(params, batch.count, batch.proof_nodes), len = 0;
+        uint8_t *buf = malloc(size);
+        ok = buf && xmss_sigbatch_serialize(params, &batch, buf, size, &len) == 0 &&
+             xmss_sigbatch_deserialize(params, &parsed, buf, len) == 0;
+        if (ok) {
+            ok = xmss_sigbatch_verify(params, batch_msgs, &parsed, key->root, pub_seed) == 1;
+            batch_msgs[2] = (const uint8_t *)"forged";
+            check(c->name, "reject batch with a changed message",
+                  xmss_sigbatch_verify(params, batch_msgs, &parsed, key->root, pub_seed) == 0);
+            xmss_sigbatch_free(&parsed, params);
+        }
+        free(buf);
+        xmss_sigbatch_free(&batch, params);
+    }
+    check(c->name, "signature batch round trip", ok);
+
+    for (int i = 0; i < made; i++) xmss_free_sig(&sigs[i], params);
+}
+
+// Sign and verify under every parameter set, including multi-proofs built from real signatures and,
+// for the checksum encoding, checksum tampering
+int main() {
+    int count = (int)(sizeof(cases) / sizeof(cases[0]));
+    csprng_seed_from_int(2024);
+    for (int i = 0; i < count; i++) {
+        const roundtrip_case *c = &cases[i];
+        xmss_params params;
+        int before = failures;
+        if (case_params(c, &params) != 0) {
+            check(c->name, "parameters", 0);
+            continue;
+        }
+        XMSSKey *key = xmss_key_alloc();
+        if (!key) {
+            check(c->name, "allocate key", 0);
+            continue;
+        }
+        xmss_keygen(&params, key);
+        test_roundtrip(c, &params, key);
+        test_multiproof(c, &params, key);
+        test_sig_file(c, &params, key);
+        if (params.encoding == WOTS_ENCODING_CHECKSUM) test_checksum(c, &params, key);
+        xmss_key_free(key);
+        printf("%s %s\n", failures == before ? "PASS" : "FAIL", c->name);
+    }
+    printf("%d case(s), %d failure(s)\n", count, failures);
+    return failures ? 1 : 0;
+}
@@ -53,12 +53,12 @@ int main() {
     // --- Test Hardened (Constant-Time) Function ---
     for (int i = 0; i < NUM_RUNS; i++) {
         start = hires_time_seconds();
-        wots_sign(&params, msg_easy, HASH_SIZE, &key, &sig);
+        wots_sign(&params, msg_easy, HASH_SIZE, &key, &sig, NULL, NULL);
         end = hires_time_seconds();
         time_hardened_easy += (end - start);
 
         start = hires_time_seconds();
-        wots_sign(&params, msg_hard, HASH_SIZE, &key, &sig);
+        wots_sign(&params, msg_hard, HASH_SIZE, &key, &sig, NULL, NULL);
         end = hires_time_seconds();
         time_hardened_hard += (end - start);
     }